@@ -0,0 +1,138 @@
+#ifndef MDICT_BENCH_BASELINE_OA_H
+#define MDICT_BENCH_BASELINE_OA_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "bench_common.h"
+
+/*
+	Bundled open addressing baseline for the benchmarks : a textbook int64->int64 table with linear probing,
+	Fibonacci hashing, a maximum load of 1/2, a byte per bucket marking it used and backward shift deletion (no
+	tombstones). It grows by doubling and never shrinks. It gives a reference point that does not depend on any
+	third party library.
+*/
+
+typedef struct {
+	int64_t *keys, *vals;
+	uint8_t *used;
+	int64_t num_buckets, size;
+	int bits;
+	uint64_t resize_ns;
+} oa_t;
+
+
+static inline int64_t oa_home(const oa_t *t, int64_t key) {
+	return (int64_t) (((uint64_t) key * 0x9E3779B97F4A7C15ull) >> (64 - t->bits));
+}
+
+
+static int oa_alloc(oa_t *t, int bits) {
+	int64_t n = (int64_t) 1 << bits;
+	t->keys = (int64_t*) malloc((size_t) n * sizeof(int64_t));
+	t->vals = (int64_t*) malloc((size_t) n * sizeof(int64_t));
+	t->used = (uint8_t*) calloc((size_t) n, 1);
+	if (!t->keys || !t->vals || !t->used) {
+		free(t->keys);
+		free(t->vals);
+		free(t->used);
+		return -1;
+	}
+	t->bits = bits;
+	t->num_buckets = n;
+	t->size = 0;
+	return 0;
+}
+
+
+static int oa_init(oa_t *t) {
+	t->resize_ns = 0;
+	return oa_alloc(t, 4);
+}
+
+
+static void oa_free(oa_t *t) {
+	free(t->keys);
+	free(t->vals);
+	free(t->used);
+}
+
+
+static int oa_set(oa_t *t, int64_t key, int64_t val);
+
+static int oa_grow(oa_t *t) {
+	uint64_t t0 = bench_now_ns();
+	oa_t old = *t;
+	if (oa_alloc(t, old.bits + 1) < 0) {
+		*t = old;
+		return -1;
+	}
+	for (int64_t i = 0; i < old.num_buckets; ++i) {
+		if (old.used[i])
+			oa_set(t, old.keys[i], old.vals[i]);
+	}
+	oa_free(&old);
+	t->resize_ns += bench_now_ns() - t0;
+	return 0;
+}
+
+
+static int oa_set(oa_t *t, int64_t key, int64_t val) {
+	/*
+	Returns 1 if key was inserted, 0 if it was updated and -1 if growing the table failed.
+	*/
+
+	if (2 * (t->size + 1) > t->num_buckets && oa_grow(t) < 0)
+		return -1;
+
+	int64_t mask = t->num_buckets - 1, i = oa_home(t, key);
+	while (t->used[i]) {
+		if (t->keys[i] == key) {
+			t->vals[i] = val;
+			return 0;
+		}
+		i = (i + 1) & mask;
+	}
+	t->used[i] = 1;
+	t->keys[i] = key;
+	t->vals[i] = val;
+	++t->size;
+	return 1;
+}
+
+
+static inline int64_t oa_find(const oa_t *t, int64_t key) {
+	/*
+	Returns the bucket of key, or -1 if it is absent.
+	*/
+
+	int64_t mask = t->num_buckets - 1, i = oa_home(t, key);
+	while (t->used[i]) {
+		if (t->keys[i] == key)
+			return i;
+		i = (i + 1) & mask;
+	}
+	return -1;
+}
+
+
+static int oa_del(oa_t *t, int64_t key) {
+	int64_t mask = t->num_buckets - 1, i = oa_find(t, key);
+	if (i < 0)
+		return -1;
+
+	// Backward shift : moves the following items of the cluster back unless that would put them before their home.
+	for (int64_t j = (i + 1) & mask; t->used[j]; j = (j + 1) & mask) {
+		int64_t home = oa_home(t, t->keys[j]);
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			t->keys[i] = t->keys[j];
+			t->vals[i] = t->vals[j];
+			i = j;
+		}
+	}
+	t->used[i] = 0;
+	--t->size;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,288 @@
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bench_common.h"
+#include "baseline_oa.h"
+#include "flat_map.hpp"
+
+/*
+	Baselines for the mdict benchmarks, reported in the same format by the same phases as bench_mdict.c :
+
+	* std	i64:i64	std::unordered_map<int64_t, int64_t>
+	* std	str:str	std::unordered_map<std::string, std::string> with 16 character keys and values
+	* oa	i64:i64	the bundled open addressing table of baseline_oa.h
+	* flat_map	i64:i64	microdict::flat_map<int64_t, int64_t>, the C++ version of the mdict table (flat_map.hpp)
+
+	Memory is measured with a counting allocator, so it includes the nodes, the bucket array and, for strings, their
+	heap buffers. std::unordered_map does not expose its rehashing time, so its "resize" line is left out.
+*/
+
+static volatile int64_t bench_sink;
+static size_t allocated_bytes;
+
+
+template <typename T>
+struct counting_alloc {
+	typedef T value_type;
+
+	counting_alloc() = default;
+	template <typename U> counting_alloc(const counting_alloc<U>&) {}
+
+	T* allocate(size_t n) {
+		allocated_bytes += n * sizeof(T);
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* p, size_t n) {
+		allocated_bytes -= n * sizeof(T);
+		::operator delete(p);
+	}
+
+	template <typename U> bool operator==(const counting_alloc<U>&) const { return true; }
+	template <typename U> bool operator!=(const counting_alloc<U>&) const { return false; }
+};
+
+typedef std::basic_string<char, std::char_traits<char>, counting_alloc<char>> bench_string;
+
+struct bench_string_hash {
+	size_t operator()(const bench_string& s) const { return std::hash<std::string_view>()(std::string_view(s.data(), s.size())); }
+};
+
+typedef std::unordered_map<int64_t, int64_t, std::hash<int64_t>, std::equal_to<int64_t>, counting_alloc<std::pair<const int64_t, int64_t>>> int_map;
+typedef std::unordered_map<bench_string, bench_string, bench_string_hash, std::equal_to<bench_string>, counting_alloc<std::pair<const bench_string, bench_string>>> str_map;
+
+
+static void run_std_int(int dist, int64_t n) {
+	int64_t* keys = bench_gen_keys(dist, n, 64, 12345 + dist);
+	int64_t reps = bench_reps(n), num_items = 0;
+	uint64_t t_insert = 0, t_hit = 0, t_miss = 0, t_iter = 0, t_delete = 0, t0;
+	double bytes_per_entry = 0;
+
+	for (int64_t r = 0; r < reps; ++r) {
+		size_t base = allocated_bytes;
+		int_map m;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m[keys[i]] = i;
+		t_insert += bench_now_ns() - t0;
+		if (r == 0)
+			bytes_per_entry = (double) (allocated_bytes - base + sizeof(m)) / m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.find(keys[i]) != m.end();
+		t_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.find(-keys[i] - 1) != m.end();
+		t_miss += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (const auto& item : m)
+			bench_sink += item.second;
+		t_iter += bench_now_ns() - t0;
+		num_items += m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m.erase(keys[i]);
+		t_delete += bench_now_ns() - t0;
+	}
+
+	bench_report("std", "i64:i64", dist, n, "insert", t_insert, reps * n, bytes_per_entry);
+	bench_report("std", "i64:i64", dist, n, "hit", t_hit, reps * n, 0);
+	bench_report("std", "i64:i64", dist, n, "miss", t_miss, reps * n, 0);
+	bench_report("std", "i64:i64", dist, n, "iterate", t_iter, num_items, 0);
+	bench_report("std", "i64:i64", dist, n, "delete", t_delete, reps * n, 0);
+	free(keys);
+}
+
+
+static void run_std_str(int dist, int64_t n) {
+	int64_t* keys = bench_gen_keys(dist, n, 64, 12345 + dist);
+	std::vector<bench_string> key_strs(n), miss_strs(n);
+	char buf[BENCH_STR_LEN];
+	for (int64_t i = 0; i < n; ++i) {
+		bench_key_str(keys[i], buf);
+		key_strs[i].assign(buf, BENCH_STR_LEN);
+		bench_key_str(-keys[i] - 1, buf);
+		miss_strs[i].assign(buf, BENCH_STR_LEN);
+	}
+
+	int64_t reps = bench_reps(n), num_items = 0;
+	uint64_t t_insert = 0, t_hit = 0, t_miss = 0, t_iter = 0, t_delete = 0, t0;
+	double bytes_per_entry = 0;
+
+	for (int64_t r = 0; r < reps; ++r) {
+		size_t base = allocated_bytes;
+		str_map m;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m[key_strs[i]] = key_strs[i];
+		t_insert += bench_now_ns() - t0;
+		if (r == 0)
+			bytes_per_entry = (double) (allocated_bytes - base + sizeof(m)) / m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.find(key_strs[i]) != m.end();
+		t_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.find(miss_strs[i]) != m.end();
+		t_miss += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (const auto& item : m)
+			bench_sink += item.second[1];
+		t_iter += bench_now_ns() - t0;
+		num_items += m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m.erase(key_strs[i]);
+		t_delete += bench_now_ns() - t0;
+	}
+
+	bench_report("std", "str:str", dist, n, "insert", t_insert, reps * n, bytes_per_entry);
+	bench_report("std", "str:str", dist, n, "hit", t_hit, reps * n, 0);
+	bench_report("std", "str:str", dist, n, "miss", t_miss, reps * n, 0);
+	bench_report("std", "str:str", dist, n, "iterate", t_iter, num_items, 0);
+	bench_report("std", "str:str", dist, n, "delete", t_delete, reps * n, 0);
+	free(keys);
+}
+
+
+static void run_flat_map(int dist, int64_t n) {
+	int64_t* keys = bench_gen_keys(dist, n, 64, 12345 + dist);
+	int64_t reps = bench_reps(n), num_items = 0;
+	uint64_t t_insert = 0, t_hit = 0, t_miss = 0, t_iter = 0, t_delete = 0, t0;
+	double bytes_per_entry = 0;
+
+	for (int64_t r = 0; r < reps; ++r) {
+		microdict::flat_map<int64_t, int64_t> m;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m[keys[i]] = i;
+		t_insert += bench_now_ns() - t0;
+		if (r == 0)
+			bytes_per_entry = (double) (sizeof(m) + m.table_bytes()) / m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.contains(keys[i]);
+		t_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += m.contains(-keys[i] - 1);
+		t_miss += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (auto [k, v] : m)
+			bench_sink += v;
+		t_iter += bench_now_ns() - t0;
+		num_items += m.size();
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			m.erase(keys[i]);
+		t_delete += bench_now_ns() - t0;
+	}
+
+	bench_report("flat_map", "i64:i64", dist, n, "insert", t_insert, reps * n, bytes_per_entry);
+	bench_report("flat_map", "i64:i64", dist, n, "hit", t_hit, reps * n, 0);
+	bench_report("flat_map", "i64:i64", dist, n, "miss", t_miss, reps * n, 0);
+	bench_report("flat_map", "i64:i64", dist, n, "iterate", t_iter, num_items, 0);
+	bench_report("flat_map", "i64:i64", dist, n, "delete", t_delete, reps * n, 0);
+	free(keys);
+}
+
+
+static int run_oa(int dist, int64_t n) {
+	int64_t* keys = bench_gen_keys(dist, n, 64, 12345 + dist);
+	int64_t reps = bench_reps(n), num_items = 0;
+	uint64_t t_insert = 0, t_resize = 0, t_hit = 0, t_miss = 0, t_iter = 0, t_delete = 0, t0;
+	double bytes_per_entry = 0;
+
+	for (int64_t r = 0; r < reps; ++r) {
+		oa_t t;
+		if (oa_init(&t) < 0)
+			return -1;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i) {
+			if (oa_set(&t, keys[i], i) < 0)
+				return -1;
+		}
+		t_insert += bench_now_ns() - t0;
+		t_resize += t.resize_ns;
+		if (r == 0)
+			bytes_per_entry = (double) (sizeof(oa_t) + t.num_buckets * (2 * sizeof(int64_t) + 1)) / t.size;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += oa_find(&t, keys[i]);
+		t_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			bench_sink += oa_find(&t, -keys[i] - 1);
+		t_miss += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < t.num_buckets; ++i) {
+			if (t.used[i])
+				bench_sink += t.vals[i];
+		}
+		t_iter += bench_now_ns() - t0;
+		num_items += t.size;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			oa_del(&t, keys[i]);
+		t_delete += bench_now_ns() - t0;
+
+		oa_free(&t);
+	}
+
+	bench_report("oa", "i64:i64", dist, n, "insert", t_insert, reps * n, bytes_per_entry);
+	bench_report("oa", "i64:i64", dist, n, "resize", t_resize, reps * n, 0);
+	bench_report("oa", "i64:i64", dist, n, "hit", t_hit, reps * n, 0);
+	bench_report("oa", "i64:i64", dist, n, "miss", t_miss, reps * n, 0);
+	bench_report("oa", "i64:i64", dist, n, "iterate", t_iter, num_items, 0);
+	bench_report("oa", "i64:i64", dist, n, "delete", t_delete, reps * n, 0);
+	free(keys);
+	return 0;
+}
+
+
+int main(int argc, char** argv) {
+	int64_t sizes[32];
+	int dists[NUM_DISTS], num_sizes, num_dists;
+
+	if (bench_parse_args(argc, argv, sizes, &num_sizes, dists, &num_dists) < 0)
+		return 2;
+
+	bench_header();
+	for (int d = 0; d < num_dists; ++d) {
+		for (int s = 0; s < num_sizes; ++s) {
+			run_std_int(dists[d], sizes[s]);
+			run_std_str(dists[d], sizes[s]);
+			run_flat_map(dists[d], sizes[s]);
+			if (run_oa(dists[d], sizes[s]) < 0) {
+				fprintf(stderr, "%s : out of memory at size %lld\n", argv[0], (long long) sizes[s]);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,221 @@
+#ifndef MDICT_BENCH_COMMON_H
+#define MDICT_BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/*
+	Helpers shared by the benchmark programs : timing, key distributions, command line parsing and the report
+	format. Every program prints one tab separated line per measurement :
+
+		impl  type  dist  size  op  ns_per_op  bytes_per_entry
+
+	ns_per_op is averaged over enough repetitions to run each phase for about BENCH_MIN_OPS operations, and
+	bytes_per_entry (only printed on the insert line, "-" elsewhere) is the memory held by the table divided by its
+	number of items. Inserted keys are always non negative, and the keys used for miss lookups are their negated
+	counterparts minus one, so they are guaranteed to be absent.
+*/
+
+#define BENCH_MIN_OPS 2000000
+#define BENCH_STR_LEN 16 // Key and value length of the str:str tables.
+
+enum { DIST_UNIFORM, DIST_ZIPF, DIST_SEQUENTIAL, DIST_STRIDED, NUM_DISTS };
+static const char *bench_dist_names[NUM_DISTS] = {"uniform", "zipf", "sequential", "strided"};
+
+#define BENCH_STRIDE 1024 // Spacing of the strided keys, which defeats hash functions that keep the low bits.
+
+
+static inline uint64_t bench_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+
+static inline uint64_t bench_rand(uint64_t *state) {
+	// splitmix64
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+
+static int64_t *bench_gen_keys(int dist, int64_t n, int key_bits, uint64_t seed) {
+	/*
+	Returns a newly allocated array of n keys in [0, 2^(key_bits-1)) following dist. Uniform keys are random (and
+	may repeat for the 32 bit types at large sizes), Zipf keys repeat a few hot keys (s = 1, drawn from n distinct
+	keys by inverting the continuous CDF), sequential keys are 0, 1, 2... and strided keys 0, BENCH_STRIDE, ...
+	*/
+
+	int64_t *keys = (int64_t*) malloc((size_t) n * sizeof(int64_t));
+	uint64_t mask = ((uint64_t) 1 << (key_bits - 1)) - 1, state = seed;
+	if (!keys)
+		return NULL;
+
+	for (int64_t i = 0; i < n; ++i) {
+		uint64_t k;
+		if (dist == DIST_UNIFORM) {
+			k = bench_rand(&state);
+		} else if (dist == DIST_ZIPF) {
+			double u = (double) (bench_rand(&state) >> 11) / (double) (1ull << 53);
+			uint64_t rank = (uint64_t) pow((double) n, u); // P(rank <= r) ~ log(r) / log(n)
+			k = rank * 0x9E3779B97F4A7C15ull; // Scatters the hot ranks over the key space.
+		} else if (dist == DIST_SEQUENTIAL) {
+			k = (uint64_t) i;
+		} else {
+			k = (uint64_t) i * BENCH_STRIDE;
+		}
+		keys[i] = (int64_t) (k & mask);
+	}
+	return keys;
+}
+
+
+static void bench_key_str(int64_t key, char *buf) {
+	/*
+	Writes the BENCH_STR_LEN characters long string form of key into buf : 'k' for present keys and 'm' for the
+	negative miss keys, followed by the hexadecimal digits of the absolute value.
+	*/
+
+	uint64_t v = key < 0 ? (uint64_t) (-(key + 1)) : (uint64_t) key;
+	buf[0] = key < 0 ? 'm' : 'k';
+	for (int i = BENCH_STR_LEN - 1; i > 0; --i, v >>= 4)
+		buf[i] = "0123456789abcdef"[v & 15];
+}
+
+
+static int bench_parse_sizes(const char *arg, int64_t *sizes, int max_sizes) {
+	/*
+	Parses a comma separated list of sizes such as "1e3,1e6,5000000". Returns the number of sizes.
+	*/
+
+	int n = 0;
+	char *end;
+	while (*arg && n < max_sizes) {
+		double v = strtod(arg, &end);
+		if (end == arg || v < 1)
+			return -1;
+		sizes[n++] = (int64_t) v;
+		arg = *end == ',' ? end + 1 : end;
+	}
+	return n;
+}
+
+
+static int bench_parse_dists(const char *arg, int *dists) {
+	/*
+	Parses a comma separated list of distribution names. Returns the number of distributions.
+	*/
+
+	int n = 0;
+	while (*arg && n < NUM_DISTS) {
+		size_t len = strcspn(arg, ",");
+		int d;
+		for (d = 0; d < NUM_DISTS; ++d) {
+			if (strlen(bench_dist_names[d]) == len && strncmp(arg, bench_dist_names[d], len) == 0)
+				break;
+		}
+		if (d == NUM_DISTS)
+			return -1;
+		dists[n++] = d;
+		arg += len + (arg[len] == ',');
+	}
+	return n;
+}
+
+
+static int bench_parse_args(int argc, char **argv, int64_t *sizes, int *num_sizes, int *dists, int *num_dists) {
+	/*
+	Usage : bench_xxx [sizes] [distributions], both comma separated lists. Defaults to 1e3,1e5,1e6 and every
+	distribution.
+	*/
+
+	const char *size_arg = argc > 1 ? argv[1] : "1e3,1e5,1e6";
+	const char *dist_arg = argc > 2 ? argv[2] : "uniform,zipf,sequential,strided";
+
+	*num_sizes = bench_parse_sizes(size_arg, sizes, 32);
+	*num_dists = bench_parse_dists(dist_arg, dists);
+	if (*num_sizes <= 0 || *num_dists <= 0) {
+		fprintf(stderr, "usage : %s [sizes, e.g. 1e3,1e6] [distributions among uniform,zipf,sequential,strided]\n", argv[0]);
+		return -1;
+	}
+	return 0;
+}
+
+
+static inline int64_t bench_reps(int64_t n) {
+	return n >= BENCH_MIN_OPS ? 1 : (BENCH_MIN_OPS + n - 1) / n;
+}
+
+
+static void bench_report(const char *impl, const char *type, int dist, int64_t n, const char *op, uint64_t ns, int64_t ops, double bytes_per_entry) {
+	printf("%s\t%s\t%s\t%lld\t%s\t%.2f\t", impl, type, bench_dist_names[dist], (long long) n, op, ops ? (double) ns / (double) ops : 0.0);
+	if (bytes_per_entry > 0)
+		printf("%.2f\n", bytes_per_entry);
+	else
+		printf("-\n");
+	fflush(stdout);
+}
+
+
+static void bench_header(void) {
+	printf("impl\ttype\tdist\tsize\top\tns_per_op\tbytes_per_entry\n");
+}
+
+
+/*
+	Latency histogram with 32 sub-buckets per power of two, so that every recorded value is known to within about
+	3% while the histogram keeps a fixed size whatever the number of operations. Values below 32 ns are exact.
+*/
+
+#define BENCH_HIST_SUB 32
+
+typedef struct {
+	uint64_t counts[64 * BENCH_HIST_SUB];
+	uint64_t total, max;
+} bench_hist_t;
+
+
+static inline int bench_hist_index(uint64_t ns) {
+	if (ns < BENCH_HIST_SUB)
+		return (int) ns;
+	int e = 63 - __builtin_clzll(ns); // e >= 5
+	return (e - 4) * BENCH_HIST_SUB + (int) ((ns >> (e - 5)) & (BENCH_HIST_SUB - 1));
+}
+
+
+static inline void bench_hist_add(bench_hist_t *hist, uint64_t ns) {
+	hist->counts[bench_hist_index(ns)] += 1;
+	hist->total += 1;
+	if (ns > hist->max)
+		hist->max = ns;
+}
+
+
+static uint64_t bench_hist_percentile(const bench_hist_t *hist, double p) {
+	/*
+	Returns the smallest bucket bound below which at least a fraction p of the values fall, or the exact maximum
+	for p = 1.
+	*/
+
+	uint64_t rank = (uint64_t) ceil(p * (double) hist->total), seen = 0;
+	if (p >= 1 || rank >= hist->total)
+		return hist->max;
+	for (int i = 0; i < 64 * BENCH_HIST_SUB; ++i) {
+		seen += hist->counts[i];
+		if (seen >= rank && seen > 0) {
+			if (i < BENCH_HIST_SUB)
+				return (uint64_t) i;
+			int e = i / BENCH_HIST_SUB + 4;
+			return (uint64_t) (BENCH_HIST_SUB + i % BENCH_HIST_SUB) << (e - 5);
+		}
+	}
+	return hist->max;
+}
+
+#endif
@@ -0,0 +1,168 @@
+#include "bench_mdict.h"
+
+/*
+	Tail latency of mdict_set while a table grows from empty, built once per type specialization (see
+	bench_mdict.h). Averages spread the cost of a resize over every insert, while a program sees it as a single
+	pause that grows with the table, so every insert is timed on its own and the latencies are summarized as
+	percentiles. Each line of the output is :
+
+		impl  type  mode  dist  size  p50_ns  p99_ns  p999_ns  max_ns  resizes  max_resize_ns
+
+	The stream of size inserts crosses log2(size / 32) doublings. It is repeated, with the histograms merged, until
+	at least BENCH_MIN_OPS inserts have been timed. resizes counts the mdict_resize calls of one stream and
+	max_resize_ns is the longest insert that performed one. Every latency includes the cost of reading the clock,
+	which is printed to stderr first.
+
+	Resizing strategies are listed in bench_modes : a mode prepares the empty table before the stream starts.
+	Adding a row there (e.g. for an incremental or parallel rehash) is all it takes to measure it against the
+	others.
+*/
+
+typedef struct {
+	const char *name;
+	int (*prepare)(h_t *h, int64_t n); // Returns -1 on failure.
+} bench_mode_t;
+
+
+static int mode_default(h_t *h, int64_t n) {
+	return 0;
+}
+
+
+static int mode_presized(h_t *h, int64_t n) {
+	/*
+	Grows the table up front so that the stream never resizes. Gives the latencies to expect without resizing.
+	*/
+
+	while (h->is_small || h->upper_bound < n) {
+		if (mdict_resize(h, true) < 0)
+			return -1;
+	}
+	h->num_resizes = 0;
+	h->rehash_ns = 0;
+	return 0;
+}
+
+
+static int mode_seqlock(h_t *h, int64_t n) {
+	// Grows into new arrays and keeps the old ones, see mdict_seqlock.h.
+	return mdict_seqlock_enable(h);
+}
+
+
+static const bench_mode_t bench_modes[] = {
+	{"default", mode_default},
+	{"presized", mode_presized},
+	{"seqlock", mode_seqlock},
+};
+
+#define NUM_MODES ((int) (sizeof(bench_modes) / sizeof(bench_modes[0])))
+
+static bench_hist_t hist;
+
+
+static int bench_parse_modes(const char *arg, int *modes) {
+	/*
+	Parses a comma separated list of mode names. Returns the number of modes.
+	*/
+
+	int n = 0;
+	while (*arg && n < NUM_MODES) {
+		size_t len = strcspn(arg, ",");
+		int m;
+		for (m = 0; m < NUM_MODES; ++m) {
+			if (strlen(bench_modes[m].name) == len && strncmp(arg, bench_modes[m].name, len) == 0)
+				break;
+		}
+		if (m == NUM_MODES)
+			return -1;
+		modes[n++] = m;
+		arg += len + (arg[len] == ',');
+	}
+	return n;
+}
+
+
+static void bench_timer_overhead(void) {
+	memset(&hist, 0, sizeof(hist));
+	for (int64_t i = 0; i < BENCH_MIN_OPS; ++i) {
+		uint64_t t0 = bench_now_ns();
+		bench_hist_add(&hist, bench_now_ns() - t0);
+	}
+	fprintf(stderr, "timer overhead : p50 %llu ns, p99 %llu ns\n", (unsigned long long) bench_hist_percentile(&hist, 0.5), (unsigned long long) bench_hist_percentile(&hist, 0.99));
+}
+
+
+static int bench_run(const bench_mode_t *mode, int dist, int64_t n) {
+	if (bench_load_keys(dist, n) < 0)
+		return -1;
+
+	int64_t reps = bench_reps(n), resizes = 0;
+	uint64_t max_resize_ns = 0;
+	memset(&hist, 0, sizeof(hist));
+
+	for (int64_t r = 0; r < reps; ++r) {
+		h_t *h = bench_create();
+		if (!h || mode->prepare(h, n) < 0) {
+			if (h)
+				mdict_delete_ht(h);
+			bench_free_keys();
+			return -1;
+		}
+
+		for (int64_t i = 0; i < n; ++i) {
+			i_t num_resizes = h->num_resizes;
+			uint64_t t0 = bench_now_ns();
+			mdict_set(h, KEY(i), VAL(i));
+			uint64_t ns = bench_now_ns() - t0;
+			bench_hist_add(&hist, ns);
+			if (h->num_resizes != num_resizes && ns > max_resize_ns)
+				max_resize_ns = ns;
+		}
+		resizes = h->num_resizes;
+		mdict_delete_ht(h);
+	}
+
+	printf("mdict\t%s\t%s\t%s\t%lld\t%llu\t%llu\t%llu\t%llu\t%lld\t%llu\n", BENCH_TYPE_NAME, mode->name, bench_dist_names[dist], (long long) n,
+		(unsigned long long) bench_hist_percentile(&hist, 0.5), (unsigned long long) bench_hist_percentile(&hist, 0.99),
+		(unsigned long long) bench_hist_percentile(&hist, 0.999), (unsigned long long) hist.max, (long long) resizes,
+		(unsigned long long) max_resize_ns);
+	fflush(stdout);
+
+	bench_free_keys();
+	return 0;
+}
+
+
+int main(int argc, char **argv) {
+	/*
+	Usage : bench_latency_xxx [sizes] [distributions] [modes], all comma separated lists. Defaults to 1e6,1e7, every
+	distribution and every mode.
+	*/
+
+	int64_t sizes[32];
+	int dists[NUM_DISTS], modes[NUM_MODES], num_sizes, num_dists, num_modes;
+	char *args[3] = {argv[0], argc > 1 ? argv[1] : (char *) "1e6,1e7", argc > 2 ? argv[2] : (char *) "uniform,zipf,sequential,strided"};
+
+	if (bench_parse_args(3, args, sizes, &num_sizes, dists, &num_dists) < 0)
+		return 2;
+	num_modes = bench_parse_modes(argc > 3 ? argv[3] : "default,presized,seqlock", modes);
+	if (num_modes <= 0) {
+		fprintf(stderr, "usage : %s [sizes] [distributions] [modes among default,presized,seqlock]\n", argv[0]);
+		return 2;
+	}
+
+	bench_timer_overhead();
+	printf("impl\ttype\tmode\tdist\tsize\tp50_ns\tp99_ns\tp999_ns\tmax_ns\tresizes\tmax_resize_ns\n");
+	for (int m = 0; m < num_modes; ++m) {
+		for (int d = 0; d < num_dists; ++d) {
+			for (int s = 0; s < num_sizes; ++s) {
+				if (bench_run(&bench_modes[modes[m]], dists[d], sizes[s]) < 0) {
+					fprintf(stderr, "%s : out of memory at size %lld\n", argv[0], (long long) sizes[s]);
+					return 1;
+				}
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include "bench_mdict.h"
+
+/*
+	Benchmark of the C hashtable core (mdict_ht.h), without Python, built once per type specialization (see
+	bench_mdict.h).
+
+	For every size and key distribution, each repetition creates an empty table and measures, in this order :
+	insert (all keys, growing the table from empty), hit lookup, miss lookup, iteration over the items, hit and miss
+	lookups in a frozen copy of the table (see mdict_frozen.h) and delete (all keys, shrinking the table back). The
+	"resize" line reports the part of the insert time spent in mdict_resize, as counted by mdict_stats.h, and
+	bytes_per_entry is mdict_sizeof divided by the number of items (of the frozen copy for the frozen lines).
+*/
+
+volatile int64_t bench_sink; // Keeps the compiler from dropping the lookups.
+
+
+static int bench_run(int dist, int64_t n) {
+	if (bench_load_keys(dist, n) < 0)
+		return -1;
+
+	int64_t reps = bench_reps(n), num_items = 0;
+	uint64_t t_insert = 0, t_resize = 0, t_hit = 0, t_miss = 0, t_iter = 0, t_frozen_hit = 0, t_frozen_miss = 0, t_delete = 0, t0;
+	double bytes_per_entry = 0, frozen_bytes_per_entry = 0;
+	i_t idx;
+
+	for (int64_t r = 0; r < reps; ++r) {
+		h_t *h = bench_create();
+		if (!h)
+			return -1;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			mdict_set(h, KEY(i), VAL(i));
+		t_insert += bench_now_ns() - t0;
+		t_resize += h->rehash_ns;
+		if (r == 0)
+			bytes_per_entry = (double) mdict_sizeof(h) / h->size;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i) {
+			mdict_get_map(h, KEY(i), &idx);
+			bench_sink += idx;
+		}
+		t_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i) {
+			mdict_get_map(h, MISS(i), &idx);
+			bench_sink += idx;
+		}
+		t_miss += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (i_t i = _flags_next_occupied(h->flags, 0, h->num_buckets); i < h->num_buckets; i = _flags_next_occupied(h->flags, i + 1, h->num_buckets))
+			bench_sink += ITEM_VAL(h, i);
+		t_iter += bench_now_ns() - t0;
+		num_items += h->size;
+
+		h_t *f = mdict_freeze(h);
+		if (!f)
+			return -1;
+		if (r == 0)
+			frozen_bytes_per_entry = (double) mdict_sizeof(f) / f->size;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i) {
+			mdict_get_map(f, KEY(i), &idx);
+			bench_sink += idx;
+		}
+		t_frozen_hit += bench_now_ns() - t0;
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i) {
+			mdict_get_map(f, MISS(i), &idx);
+			bench_sink += idx;
+		}
+		t_frozen_miss += bench_now_ns() - t0;
+		mdict_delete_ht(f);
+
+		t0 = bench_now_ns();
+		for (int64_t i = 0; i < n; ++i)
+			mdict_del_map(h, KEY(i), NULL);
+		t_delete += bench_now_ns() - t0;
+
+		mdict_delete_ht(h);
+	}
+
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "insert", t_insert, reps * n, bytes_per_entry);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "resize", t_resize, reps * n, 0);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "hit", t_hit, reps * n, 0);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "miss", t_miss, reps * n, 0);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "iterate", t_iter, num_items, 0);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "frozen_hit", t_frozen_hit, reps * n, frozen_bytes_per_entry);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "frozen_miss", t_frozen_miss, reps * n, 0);
+	bench_report("mdict", BENCH_TYPE_NAME, dist, n, "delete", t_delete, reps * n, 0);
+
+	bench_free_keys();
+	return 0;
+}
+
+
+int main(int argc, char **argv) {
+	int64_t sizes[32];
+	int dists[NUM_DISTS], num_sizes, num_dists;
+
+	if (bench_parse_args(argc, argv, sizes, &num_sizes, dists, &num_dists) < 0)
+		return 2;
+
+	bench_header();
+	for (int d = 0; d < num_dists; ++d) {
+		for (int s = 0; s < num_sizes; ++s) {
+			if (bench_run(dists[d], sizes[s]) < 0) {
+				fprintf(stderr, "%s : out of memory at size %lld\n", argv[0], (long long) sizes[s]);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
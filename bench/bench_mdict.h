@@ -0,0 +1,112 @@
+#ifndef MDICT_BENCH_MDICT_H
+#define MDICT_BENCH_MDICT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+	Type selection shared by the programs that benchmark the C hashtable core. The Makefile builds them once per
+	type specialization, selected by BENCH_TYPE :
+
+		1 : i32:i32    2 : i32:i64    3 : i64:i32    4 : i64:i64    5 : str:str (16 character keys and values)
+
+	KEY(i), MISS(i) and VAL(i) give the i-th inserted key, absent key and value as boxes for mdict_set and
+	mdict_get_map, after bench_load_keys has generated them.
+*/
+
+#if BENCH_TYPE == 1
+	#define dtype_key 1
+	#define dtype_val 1
+	#define BENCH_TYPE_NAME "i32:i32"
+#elif BENCH_TYPE == 2
+	#define dtype_key 1
+	#define dtype_val 2
+	#define BENCH_TYPE_NAME "i32:i64"
+#elif BENCH_TYPE == 3
+	#define dtype_key 2
+	#define dtype_val 1
+	#define BENCH_TYPE_NAME "i64:i32"
+#elif BENCH_TYPE == 4
+	#define dtype_key 2
+	#define dtype_val 2
+	#define BENCH_TYPE_NAME "i64:i64"
+#elif BENCH_TYPE == 5
+	#include "str_str_wyhash.h"
+	#define BENCH_TYPE_NAME "str:str"
+#else
+	#error "BENCH_TYPE must be between 1 and 5"
+#endif
+
+#if BENCH_TYPE != 5 // The integer types are built from the templates, as in setup.py (see hash_funcs.h for the dtype codes).
+	#include "hash_funcs.h"
+	#include "mdict_ht.h"
+#endif
+
+#include "bench_common.h"
+
+static int64_t *keys;
+
+#if dtype_key == 5
+	#define KEY_BITS 64
+	static char *key_strs, *miss_strs;
+	#define KEY(i) ((kbox_t) {key_strs + (size_t) (i) * BENCH_STR_LEN, BENCH_STR_LEN})
+	#define MISS(i) ((kbox_t) {miss_strs + (size_t) (i) * BENCH_STR_LEN, BENCH_STR_LEN})
+	#define VAL(i) KEY(i)
+	#define ITEM_VAL(h, i) (h)->vals[(size_t) (i) * (h)->v_step_increment + str_len_SIZE]
+#else
+	#define KEY_BITS (dtype_key == 1 ? 32 : 64)
+	#define KEY(i) ((kbox_t) keys[i])
+	#define MISS(i) ((kbox_t) (-keys[i] - 1))
+	#define VAL(i) ((vbox_t) (i))
+	#define ITEM_VAL(h, i) (h)->vals[i]
+#endif
+
+
+static h_t *bench_create(void) {
+#if dtype_key == 5
+	ht_param param = {5, BENCH_STR_LEN, 5, BENCH_STR_LEN, BENCH_STR_LEN + str_len_SIZE, BENCH_STR_LEN + str_len_SIZE};
+	return mdict_create(&param);
+#else
+	return mdict_create(NULL);
+#endif
+}
+
+
+static void bench_free_keys(void) {
+	free(keys);
+	keys = NULL;
+#if dtype_key == 5
+	free(key_strs);
+	free(miss_strs);
+	key_strs = miss_strs = NULL;
+#endif
+}
+
+
+static int bench_load_keys(int dist, int64_t n) {
+	/*
+	Generates the n keys of dist (see bench_gen_keys), and their string forms for str:str. Returns -1 if out of
+	memory.
+	*/
+
+	keys = bench_gen_keys(dist, n, KEY_BITS, 12345 + dist);
+	if (!keys)
+		return -1;
+
+#if dtype_key == 5
+	key_strs = (char*) malloc((size_t) n * BENCH_STR_LEN);
+	miss_strs = (char*) malloc((size_t) n * BENCH_STR_LEN);
+	if (!key_strs || !miss_strs) {
+		bench_free_keys();
+		return -1;
+	}
+	for (int64_t i = 0; i < n; ++i) {
+		bench_key_str(keys[i], key_strs + (size_t) i * BENCH_STR_LEN);
+		bench_key_str(-keys[i] - 1, miss_strs + (size_t) i * BENCH_STR_LEN);
+	}
+#endif
+	return 0;
+}
+
+#endif
@@ -0,0 +1,10 @@
+import os
+
+
+def get_include():
+	"""
+	Returns the directory holding microdict_api.h and microdict_api.pxd, to add to the include path of C extensions
+	and Cython modules that use the microdict C API.
+	"""
+
+	return os.path.dirname(os.path.abspath(__file__))
@@ -3,8 +3,20 @@
 #include <stdlib.h>
 #include <stdint.h>
 
-#define dtype_key 5
-#define dtype_val 5
+/*
+	String keys and/or values. dtype_key and dtype_val default to 5 (string), the other side of a mixed table being
+	one of the integer types of hash_funcs.h. A string side stores every string in a block of str_len_SIZE + maximum
+	length bytes, its step increment, so that GET_PTR gives the offset of the block of a bucket. For an integer side
+	the step increment is 1 and GET_PTR gives the bucket itself.
+*/
+
+#ifndef dtype_key
+	#define dtype_key 5
+#endif
+#ifndef dtype_val
+	#define dtype_val 5
+#endif
+
 #define str_len_SIZE 2 
 #define str_len_MAX 65535
 
@@ -13,22 +25,28 @@
 
 #define _rehash_func rehash_str
 
-typedef char k_t;
-typedef char v_t;
-
 typedef uint16_t str_len_t;
-typedef struct kbox_t
+typedef struct str_box_t
 {
 	char* str;
 	int len;
-} kbox_t;
+} str_box_t;
 
-typedef kbox_t vbox_t;
+#if dtype_key == 5
+	typedef char k_t;
+	typedef str_box_t kbox_t;
+#endif
+#if dtype_val == 5
+	typedef char v_t;
+	typedef str_box_t vbox_t;
+#endif
 
 
 #include "hash_funcs.h"
 
+#if dtype_key == 5
 inline uint64_t _hash_func(h_t *h, kbox_t key_box);
+#endif
 
 void print_str(char* str, int len){
     printf("Str of len: %d ---", len);
@@ -62,6 +80,7 @@ inline void _set_str_len(char* block_ptr, str_len_t len){
 }
 
 
+#if dtype_key == 5
 inline bool _key_equal(h_t *h, i_t idx, kbox_t key_box) {
 	str_len_t h_key_len = _get_str_len(&h->keys[idx]);
 	bool found;
@@ -81,17 +100,21 @@ inline kbox_t _get_key(h_t *h, i_t idx) {
 	idx += str_len_SIZE;
 	return (kbox_t) {&h->keys[idx], len};   
 }  
+#endif
 
 
+#if dtype_val == 5
 inline vbox_t _get_val(h_t *h, i_t idx) {  
 	str_len_t len = _get_str_len(&h->vals[idx]);
 	idx += str_len_SIZE;
 	return (vbox_t) {&h->vals[idx], len};   
 }
+#endif
 
 
 
 
+#if dtype_key == 5
 inline int _set_key(h_t *h, i_t idx, kbox_t key) {
 	/*
 	Returns 0 on success. -1 if the string provided is larger than str_len_MAX.
@@ -106,8 +129,10 @@ inline int _set_key(h_t *h, i_t idx, kbox_t key) {
 		return -1;
 	}
 } 
+#endif
 
 
+#if dtype_val == 5
 inline int _set_val(h_t *h, i_t idx, vbox_t val) {
 	/*
 	Returns 0 on success. -1 if the string provided is larger than str_len_MAX.
@@ -122,19 +147,45 @@ inline int _set_val(h_t *h, i_t idx, vbox_t val) {
 		return -1;
 	}
 }  
+#endif
+
+
+/*
+	The rehash below moves the items along cycles of buckets, so it needs a copy of the first item of a cycle : a
+	string is copied into a buffer of the maximum length, an integer is copied as is.
+*/
+#if dtype_key == 5
+	#define _temp_key_init(h, box) {(box).str = (char*) MDICT_MALLOC(sizeof(char)*(h)->k_t_size);}
+	#define _temp_key_copy(box, key) {strncpy((box).str, (key).str, (key).len); (box).len = (key).len;}
+	#define _temp_key_free(box) MDICT_FREE((box).str)
+#else
+	#define _temp_key_init(h, box)
+	#define _temp_key_copy(box, key) {box = key;}
+	#define _temp_key_free(box)
+#endif
+
+#if dtype_val == 5
+	#define _temp_val_init(h, box) {(box).str = (char*) MDICT_MALLOC(sizeof(char)*(h)->v_t_size);}
+	#define _temp_val_copy(box, val) {strncpy((box).str, (val).str, (val).len); (box).len = (val).len;}
+	#define _temp_val_free(box) MDICT_FREE((box).str)
+#else
+	#define _temp_val_init(h, box)
+	#define _temp_val_copy(box, val) {box = val;}
+	#define _temp_val_free(box)
+#endif
 
 
 void rehash_str(h_t* h, i_t* new_flags, i_t* new_psl, i_t new_num_buckets) {
 	i_t new_mask = new_num_buckets - 1;		
 	i_t i_ptr, k_step_inc = h->k_step_increment, v_step_inc = h->v_step_increment;
-	i_t* visit_array = (i_t*) calloc(h->num_buckets, sizeof(i_t));
+	i_t* visit_array = (i_t*) MDICT_CALLOC(h->num_buckets, sizeof(i_t));
 	i_t last_visited;
 	bool loop_present=false;
 	kbox_t temp_k_box;
 	vbox_t temp_v_box;
 
-	temp_k_box.str = (char*) malloc(sizeof(char)*h->k_t_size);
-	temp_v_box.str = (char*) malloc(sizeof(char)*h->v_t_size);
+	_temp_key_init(h, temp_k_box);
+	_temp_val_init(h, temp_v_box);
 
 	for (i_t j = 0; j < h->num_buckets; ++j) {						
 		if (!_flags_isempty(h->flags, j)) {					
@@ -174,13 +225,11 @@ void rehash_str(h_t* h, i_t* new_flags, i_t* new_psl, i_t new_num_buckets) {
 				
 				i_ptr = GET_PTR(i, k_step_inc);
 				kbox_t key = _get_key(h, i_ptr);
-				strncpy(temp_k_box.str, key.str, key.len);
-				temp_k_box.len = key.len;
+				_temp_key_copy(temp_k_box, key);
 				
 				i_ptr = GET_PTR(i, v_step_inc);
 				vbox_t val = _get_val(h, i_ptr);
-				strncpy(temp_v_box.str, val.str, val.len);
-				temp_v_box.len = val.len;
+				_temp_val_copy(temp_v_box, val);
 			}
 
 			// Backward pass
@@ -209,9 +258,9 @@ void rehash_str(h_t* h, i_t* new_flags, i_t* new_psl, i_t new_num_buckets) {
 		}														
 	}			
 
-	free(temp_k_box.str);
-	free(temp_v_box.str);
-	free(visit_array);
+	_temp_key_free(temp_k_box);
+	_temp_val_free(temp_v_box);
+	MDICT_FREE(visit_array);
 }
 
 
@@ -0,0 +1,281 @@
+"""
+Benchmarks of the microdict types against the Python Dictionary, reproducing the comparison tables of the README.
+
+Run them with ``python -m microdict.benchmarks`` (see ``--help``), or call run() from Python. The results are returned
+(and written) as JSON, so that two runs, e.g. before and after an upgrade, can be compared with compare().
+"""
+
+import gc
+import json
+import multiprocessing
+import os
+import platform
+import random
+import string
+import sys
+import time
+import tracemalloc
+
+from microdict import mdict
+
+TYPES = ["%s:%s" % pair for pair in mdict.TYPE_PAIRS]
+OPERATIONS = ["set", "get", "contains", "pop", "update", "copy", "iteration", "to_Pydict"]
+STR_LEN = 8 # Length of the str keys and values, as in the README.
+
+
+def int_range(t):
+	"""
+	Returns the (min, max) values of the integer type t, e.g. "u16".
+	"""
+
+	bits = int(t[1:])
+	return (0, 2**bits - 1) if t[0] == "u" else (-2**(bits - 1), 2**(bits - 1) - 1)
+
+
+def num_keys(dtype):
+	"""
+	Returns the number of distinct keys of type dtype, None if unbounded (str keys).
+	"""
+
+	k_type = dtype.split(":")[0]
+	if k_type == "str":
+		return None
+	lo, hi = int_range(k_type)
+	return hi - lo + 1
+
+
+def _gen_val(t, rng):
+	if t == "str":
+		return "".join(rng.choices(string.ascii_letters + string.digits, k=STR_LEN))
+	return rng.randint(*int_range(t))
+
+
+def gen_items(dtype, size, seed=0):
+	"""
+	Returns a list of size (key, value) pairs of random unique keys and random values of the dtype types. Raises a
+	ValueError if the key type has fewer than size distinct keys.
+	"""
+
+	k_type, v_type = dtype.split(":")
+	if num_keys(dtype) is not None and size > num_keys(dtype):
+		raise ValueError("%s has fewer than %d distinct keys" % (dtype, size))
+
+	rng = random.Random(seed)
+	keys = set()
+	while len(keys) < size:
+		keys.add(_gen_val(k_type, rng))
+	return [(k, _gen_val(v_type, rng)) for k in keys]
+
+
+def create(dtype):
+	"""
+	Returns an empty microdict of type dtype, using STR_LEN long strings for its str sides.
+	"""
+
+	return mdict.create(dtype, STR_LEN, STR_LEN) # The lengths are ignored for the integer sides.
+
+
+def _time(func, setup, repeat):
+	"""
+	Returns the best of repeat timings (in seconds) of func(setup()), setup not being timed.
+	"""
+
+	best = None
+	for _ in range(repeat):
+		arg = setup()
+		gc.collect()
+		start = time.perf_counter()
+		func(arg)
+		elapsed = time.perf_counter() - start
+		best = elapsed if best is None else min(best, elapsed)
+	return best
+
+
+def _set(d, items):
+	for k, v in items:
+		d[k] = v
+
+def _get(d, keys):
+	for k in keys:
+		d[k]
+
+def _contains(d, keys):
+	for k in keys:
+		k in d
+
+def _pop(d, keys):
+	for k in keys:
+		d.pop(k)
+
+def _iterate(d):
+	for k, v in d.items():
+		pass
+
+
+def time_operations(dtype, size, repeat=3, seed=0):
+	"""
+	Times every operation of OPERATIONS on a microdict of type dtype and on a Python Dictionary holding the same size
+	items. Returns a list of {"type", "size", "op", "mdict_seconds", "dict_seconds", "speed_gain"} dictionaries, where
+	speed_gain is dict_seconds / mdict_seconds as in the README.
+	"""
+
+	items = gen_items(dtype, size, seed)
+	keys = [k for k, _ in items]
+	pydict = dict(items)
+
+	def filled(factory):
+		d = factory()
+		_set(d, items)
+		return d
+
+	impls = {
+		"mdict": (lambda: create(dtype), lambda d: d.to_Pydict()),
+		"dict": (dict, lambda d: dict(d)),
+	}
+
+	results = []
+	for op in OPERATIONS:
+		seconds = {}
+		for name, (factory, to_pydict) in impls.items():
+			if op == "set":
+				seconds[name] = _time(lambda d: _set(d, items), factory, repeat)
+			elif op == "update":
+				seconds[name] = _time(lambda d: d.update(pydict), factory, repeat)
+			elif op == "pop":
+				seconds[name] = _time(lambda d: _pop(d, keys), lambda: filled(factory), repeat)
+			else:
+				d = filled(factory)
+				func = {
+					"get": lambda _: _get(d, keys),
+					"contains": lambda _: _contains(d, keys),
+					"copy": lambda _: d.copy(),
+					"iteration": lambda _: _iterate(d),
+					"to_Pydict": lambda _: to_pydict(d),
+				}[op]
+				seconds[name] = _time(func, lambda: None, repeat)
+		results.append({"type": dtype, "size": size, "op": op, "mdict_seconds": seconds["mdict"], "dict_seconds": seconds["dict"],
+			"speed_gain": seconds["dict"] / seconds["mdict"] if seconds["mdict"] else None})
+	return results
+
+
+def _rss():
+	"""
+	Returns the resident set size of this process in bytes, or None if it can not be read.
+	"""
+
+	try:
+		import psutil
+		return psutil.Process().memory_info().rss
+	except ImportError:
+		pass
+	try:
+		with open("/proc/self/statm") as f:
+			return int(f.read().split()[1]) * os.sysconf("SC_PAGE_SIZE")
+	except (OSError, ValueError, AttributeError):
+		return None
+
+
+def _space_worker(dtype, size, impl, seed, queue):
+	"""
+	Runs in a fresh process : fills a microdict (impl "mdict") or a Python Dictionary (impl "dict") with items generated
+	on the fly, so that only the memory retained by the hashtable is counted, and reports the growth of the RSS and of
+	the memory traced by tracemalloc.
+	"""
+
+	data = json.dumps(gen_items(dtype, size, seed)) # Decoded below into fresh objects, owned by the hashtable alone.
+	gc.collect()
+
+	tracemalloc.start()
+	traced_before = tracemalloc.get_traced_memory()[0]
+	rss_before = _rss()
+
+	d = create(dtype) if impl == "mdict" else {}
+	for k, v in json.loads(data):
+		d[k] = v
+	del data
+	gc.collect()
+
+	traced = tracemalloc.get_traced_memory()[0] - traced_before
+	rss_after = _rss()
+	tracemalloc.stop()
+	queue.put({"traced_bytes": traced, "rss_bytes": None if rss_before is None else rss_after - rss_before, "len": len(d)})
+
+
+def measure_space(dtype, size, seed=0):
+	"""
+	Measures the memory held by a microdict of type dtype and by a Python Dictionary holding the same size items, each in
+	its own process. Returns a {"type", "size", "mdict_traced_bytes", "dict_traced_bytes", "mdict_rss_bytes",
+	"dict_rss_bytes", "space_gain_traced", "space_gain_rss"} dictionary, the gains being dict / mdict as in the README.
+	"""
+
+	ctx = multiprocessing.get_context("spawn")
+	result = {"type": dtype, "size": size}
+	for impl in ("mdict", "dict"):
+		queue = ctx.Queue()
+		proc = ctx.Process(target=_space_worker, args=(dtype, size, impl, seed, queue))
+		proc.start()
+		measured = queue.get()
+		proc.join()
+		result[impl + "_traced_bytes"] = measured["traced_bytes"]
+		result[impl + "_rss_bytes"] = measured["rss_bytes"]
+
+	result["space_gain_traced"] = result["dict_traced_bytes"] / result["mdict_traced_bytes"] if result["mdict_traced_bytes"] else None
+	if result["mdict_rss_bytes"] and result["dict_rss_bytes"] is not None:
+		result["space_gain_rss"] = result["dict_rss_bytes"] / result["mdict_rss_bytes"]
+	else:
+		result["space_gain_rss"] = None
+	return result
+
+
+def run(types=TYPES, sizes=(100000, 1000000), repeat=3, space=True, seed=0, log=sys.stderr):
+	"""
+	Runs the speed (and unless space is False, the space) benchmarks for every type and size. Returns the results as a
+	JSON serializable dictionary with "meta", "speed" and "space" entries. Progress is written to log (None for silence).
+	"""
+
+	results = {
+		"meta": {
+			"python": sys.version.split()[0],
+			"platform": platform.platform(),
+			"machine": platform.machine(),
+			"time": time.strftime("%Y-%m-%dT%H:%M:%S"),
+			"types": list(types),
+			"sizes": list(sizes),
+			"repeat": repeat,
+			"seed": seed,
+		},
+		"speed": [],
+		"space": [],
+	}
+
+	for dtype in types:
+		for size in sizes:
+			if num_keys(dtype) is not None and size > num_keys(dtype):
+				if log:
+					print("%-8s %10d skipped, the key type has only %d distinct keys" % (dtype, size, num_keys(dtype)), file=log)
+				continue
+			for r in time_operations(dtype, size, repeat, seed):
+				results["speed"].append(r)
+				if log:
+					print("%-8s %10d %-10s speed gain %.2fx" % (dtype, size, r["op"], r["speed_gain"] or 0), file=log)
+			if space:
+				s = measure_space(dtype, size, seed)
+				results["space"].append(s)
+				if log:
+					print("%-8s %10d %-10s space gain %.2fx (tracemalloc)" % (dtype, size, "", s["space_gain_traced"] or 0), file=log)
+	return results
+
+
+def compare(old, new, threshold=0.1):
+	"""
+	Compares two results of run() and returns the list of (type, size, op, old_seconds, new_seconds) for the microdict
+	operations that got slower by more than threshold (a fraction).
+	"""
+
+	before = {(r["type"], r["size"], r["op"]): r["mdict_seconds"] for r in old["speed"]}
+	slower = []
+	for r in new["speed"]:
+		key = (r["type"], r["size"], r["op"])
+		if key in before and r["mdict_seconds"] > before[key] * (1 + threshold):
+			slower.append(key + (before[key], r["mdict_seconds"]))
+	return slower
@@ -0,0 +1,38 @@
+import argparse
+import json
+import sys
+
+from microdict import benchmarks
+
+
+def main(argv=None):
+	parser = argparse.ArgumentParser(prog="python -m microdict.benchmarks", description="Benchmarks the microdict types against the Python Dictionary.")
+	parser.add_argument("--types", nargs="+", default=benchmarks.TYPES, choices=benchmarks.TYPES, help="dictionary types to benchmark")
+	parser.add_argument("--sizes", nargs="+", type=int, default=[100000, 1000000], help="numbers of items")
+	parser.add_argument("--repeat", type=int, default=3, help="timings per operation, the best one is kept")
+	parser.add_argument("--seed", type=int, default=0, help="seed of the random items")
+	parser.add_argument("--no-space", action="store_true", help="skip the memory measurements")
+	parser.add_argument("--output", help="writes the JSON results to this file instead of the standard output")
+	parser.add_argument("--compare", metavar="OLD_JSON", help="reports the operations that got more than 10%% slower than in OLD_JSON and exits with status 1 if any did")
+	args = parser.parse_args(argv)
+
+	results = benchmarks.run(args.types, args.sizes, args.repeat, not args.no_space, args.seed)
+
+	if args.output:
+		with open(args.output, "w") as f:
+			json.dump(results, f, indent=1)
+	else:
+		json.dump(results, sys.stdout, indent=1)
+		print()
+
+	if args.compare:
+		with open(args.compare) as f:
+			slower = benchmarks.compare(json.load(f), results)
+		for dtype, size, op, old, new in slower:
+			print("%-8s %10d %-10s %.4fs -> %.4fs" % (dtype, size, op, old, new), file=sys.stderr)
+		return 1 if slower else 0
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
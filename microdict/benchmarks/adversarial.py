@@ -0,0 +1,258 @@
+"""
+Stress benchmarks of the microdict types on key sets that are hard on their hash functions : the integer types hash a
+key to itself and keep its low bits, so keys that only differ in their high bits, or that are multiples of a large power
+of two, pile up in a few buckets. For every key set, the items are inserted and looked up, and the longest probe
+sequence (max PSL, from d.stats()) is reported along with the throughputs.
+
+Run it with ``python -m microdict.benchmarks.adversarial`` (see ``--help``). Passing ``--max-psl`` makes it exit with
+status 1 when a key set exceeds that probe length, and ``--compare`` reports the key sets that got worse since an earlier
+JSON output, so that changes to the hash functions can be gated on it.
+"""
+
+import argparse
+import datetime
+import json
+import random
+import string
+import sys
+import time
+
+from microdict import benchmarks
+from microdict import mdict
+
+INT_KEY_SETS = ["uniform", "timestamps", "strided", "shifted", "clustered", "high_bits", "collide"]
+STR_KEY_SETS = ["uniform", "sequential", "timestamps", "shared_prefix", "binary", "long"]
+
+STRIDE = 1024
+RUN_LEN = 64 # Length of the runs of consecutive keys of the clustered key set.
+_BITS = {"i32": 32, "i64": 64}
+TYPES = [t for t in benchmarks.TYPES if t.split(":")[0] in _BITS or t.split(":")[0] == "str"] # The key types the key sets are made for.
+
+
+def _vals(v_type, size):
+	"""
+	Returns size values of the type v_type.
+	"""
+
+	if v_type == "str":
+		return ["%08x" % (i & 0xffffffff) for i in range(size)]
+	return [i % (benchmarks.int_range(v_type)[1] + 1) for i in range(size)]
+
+
+def _final_num_buckets(dtype, size):
+	"""
+	Returns the number of buckets of a microdict of type dtype once it holds size items.
+	"""
+
+	d = mdict.create(dtype, None, 8)
+	for k, v in zip(range(size), _vals(dtype.split(":")[1], size)):
+		d[k] = v
+	return d.stats()["num_buckets"]
+
+
+def int_keys(dtype, key_set, size, seed=0):
+	"""
+	Returns size distinct keys of key_set for the integer type dtype :
+
+	uniform      random keys, for reference
+	timestamps   consecutive timestamps, one per minute in seconds (i32) or one per second in milliseconds (i64)
+	strided      multiples of STRIDE
+	shifted      i << 20, fewer bits for the i32 types when needed to stay in range
+	clustered    runs of RUN_LEN consecutive keys starting at random multiples of 4096
+	high_bits    keys that only differ in their highest bits
+	collide      keys that all hash to the same bucket of the table they end up in (or, for the i32 types at large
+	             sizes, to as few buckets as the range allows)
+	"""
+
+	bits = _BITS[dtype.split(":")[0]]
+	top = 1 << (bits - 1)
+	rng = random.Random(seed)
+
+	if key_set == "uniform":
+		keys = set()
+		while len(keys) < size:
+			keys.add(rng.randrange(-top, top))
+		return list(keys)
+	if key_set == "timestamps":
+		return [1600000000 + 60 * i for i in range(size)] if bits == 32 else [1600000000000 + 1000 * i for i in range(size)]
+	if key_set == "strided":
+		return [STRIDE * i for i in range(size)]
+	if key_set == "shifted":
+		return [i << min(20, bits - 1 - size.bit_length()) for i in range(size)]
+	if key_set == "clustered":
+		starts = rng.sample(range(top >> 12), -(-size // RUN_LEN))
+		return [(s << 12) + j for s in starts for j in range(RUN_LEN)][:size]
+	if key_set == "high_bits":
+		return [i << (bits - 1 - size.bit_length()) for i in range(size)]
+	if key_set == "collide":
+		num_buckets = _final_num_buckets(dtype, size) # The power of two masking the identity hash.
+		while num_buckets * size > 2 * top: # Keeps the keys distinct, at the cost of a few different buckets.
+			num_buckets >>= 1
+		home = rng.randrange(num_buckets)
+		return [((home + num_buckets * i + top) % (2 * top)) - top for i in range(size)]
+	raise ValueError("Unknown key set %r" % key_set)
+
+
+def str_keys(key_set, size, seed=0):
+	"""
+	Returns size distinct keys of key_set for the str key types. Since wyhash is seeded per microdict, keys can not be crafted to
+	collide from the outside, so these are the kinds of keys that weak string hashes handle badly :
+
+	uniform        random 16 character keys, for reference
+	sequential     zero padded decimal numbers
+	timestamps     consecutive ISO 8601 timestamps, one per second
+	shared_prefix  64 character keys sharing a 48 character prefix
+	binary         24 character strings of 'a' and 'b'
+	long           256 character keys that only differ in their last 6 characters
+	"""
+
+	rng = random.Random(seed)
+	if key_set == "uniform":
+		keys = set()
+		while len(keys) < size:
+			keys.add("".join(rng.choices(string.ascii_letters + string.digits, k=16)))
+		return list(keys)
+	if key_set == "sequential":
+		return ["%016d" % i for i in range(size)]
+	if key_set == "timestamps":
+		start = datetime.datetime(2020, 1, 1)
+		return [(start + datetime.timedelta(seconds=i)).isoformat() for i in range(size)]
+	if key_set == "shared_prefix":
+		return ["session:" + "0" * 40 + "%016x" % i for i in range(size)]
+	if key_set == "binary":
+		return [format(i, "024b").replace("0", "a").replace("1", "b") for i in range(size)]
+	if key_set == "long":
+		return ["k" * 250 + "%06d" % i for i in range(size)]
+	raise ValueError("Unknown key set %r" % key_set)
+
+
+def stress(dtype, key_set, size, time_limit=10.0, seed=0):
+	"""
+	Inserts the size keys of key_set into an empty microdict of type dtype, checks that every item reads back, and
+	returns a {"type", "key_set", "size", "inserted", "truncated", "insert_ns", "get_ns", "max_psl", "mean_psl",
+	"num_buckets"} dictionary. Inserting stops early (truncated is True) once it has taken time_limit seconds, which
+	pathological key sets can reach at large sizes.
+	"""
+
+	k_type, v_type = dtype.split(":")
+	if k_type == "str":
+		keys = str_keys(key_set, size, seed)
+		d = mdict.create(dtype, max(len(k) for k in keys), 8)
+	else:
+		keys = int_keys(dtype, key_set, size, seed)
+		d = mdict.create(dtype, None, 8)
+	vals = _vals(v_type, size)
+
+	inserted, elapsed, chunk = 0, 0.0, 1000
+	while inserted < size and elapsed < time_limit:
+		items = list(zip(keys[inserted:inserted + chunk], vals[inserted:inserted + chunk]))
+		start = time.perf_counter()
+		benchmarks._set(d, items)
+		elapsed += time.perf_counter() - start
+		inserted += len(items)
+
+	keys = keys[:inserted]
+	start = time.perf_counter()
+	benchmarks._get(d, keys)
+	get_seconds = time.perf_counter() - start
+
+	if len(d) != inserted or any(d[k] != v for k, v in zip(keys, vals)):
+		raise AssertionError("%s %s %d : items were lost or corrupted" % (dtype, key_set, size))
+
+	st = d.stats()
+	probes = st["probe_lengths"]
+	return {
+		"type": dtype,
+		"key_set": key_set,
+		"size": size,
+		"inserted": inserted,
+		"truncated": inserted < size,
+		"insert_ns": elapsed * 1e9 / inserted,
+		"get_ns": get_seconds * 1e9 / inserted,
+		"max_psl": len(probes) - 1 if probes else 0,
+		"mean_psl": sum(s * c for s, c in enumerate(probes)) / inserted,
+		"num_buckets": st["num_buckets"],
+	}
+
+
+def run(types=TYPES, sizes=(1000, 10000, 100000), key_sets=None, time_limit=10.0, seed=0, log=sys.stderr):
+	"""
+	Runs stress for every type, key set (every key set of the type when key_sets is None) and size. Returns the list of
+	results. Progress is written to log (None for silence).
+	"""
+
+	results = []
+	for dtype in types:
+		available = STR_KEY_SETS if dtype.split(":")[0] == "str" else INT_KEY_SETS
+		for key_set in (available if key_sets is None else [s for s in key_sets if s in available]):
+			for size in sizes:
+				r = stress(dtype, key_set, size, time_limit, seed)
+				results.append(r)
+				if log:
+					print("%-8s %-14s %9d  insert %9.1f ns  get %9.1f ns  max psl %7d%s" % (dtype, key_set, size, r["insert_ns"], r["get_ns"],
+						r["max_psl"], "  (stopped after %d items)" % r["inserted"] if r["truncated"] else ""), file=log)
+	return results
+
+
+def compare(old, new, threshold=0.1):
+	"""
+	Compares two results of run() and returns the list of (type, key_set, size, what, old, new) for the key sets whose
+	max PSL grew, whose inserts got slower by more than threshold (a fraction) or that newly hit the time limit.
+	"""
+
+	before = {(r["type"], r["key_set"], r["size"]): r for r in old}
+	worse = []
+	for r in new:
+		key = (r["type"], r["key_set"], r["size"])
+		if key not in before:
+			continue
+		b = before[key]
+		if r["truncated"] and not b["truncated"]:
+			worse.append(key + ("inserted", b["inserted"], r["inserted"]))
+		elif r["max_psl"] > b["max_psl"]:
+			worse.append(key + ("max_psl", b["max_psl"], r["max_psl"]))
+		if r["insert_ns"] > b["insert_ns"] * (1 + threshold):
+			worse.append(key + ("insert_ns", b["insert_ns"], r["insert_ns"]))
+	return worse
+
+
+def main(argv=None):
+	parser = argparse.ArgumentParser(prog="python -m microdict.benchmarks.adversarial", description="Stresses the microdict types with adversarial key sets.")
+	parser.add_argument("--types", nargs="+", default=TYPES, choices=TYPES, help="dictionary types to stress")
+	parser.add_argument("--sizes", nargs="+", type=int, default=[1000, 10000, 100000], help="numbers of keys")
+	parser.add_argument("--key-sets", nargs="+", choices=sorted(set(INT_KEY_SETS + STR_KEY_SETS)), help="key sets to use, all by default")
+	parser.add_argument("--time-limit", type=float, default=10.0, help="seconds after which inserting a key set stops")
+	parser.add_argument("--seed", type=int, default=0, help="seed of the random key sets")
+	parser.add_argument("--max-psl", type=int, help="exits with status 1 if a key set has a longer probe sequence")
+	parser.add_argument("--output", help="writes the JSON results to this file instead of the standard output")
+	parser.add_argument("--compare", metavar="OLD_JSON", help="reports the key sets that got worse than in OLD_JSON and exits with status 1 if any did")
+	args = parser.parse_args(argv)
+
+	results = run(args.types, args.sizes, args.key_sets, args.time_limit, args.seed)
+
+	if args.output:
+		with open(args.output, "w") as f:
+			json.dump(results, f, indent=1)
+	else:
+		json.dump(results, sys.stdout, indent=1)
+		print()
+
+	status = 0
+	if args.max_psl is not None:
+		for r in results:
+			if r["max_psl"] > args.max_psl or r["truncated"]:
+				print("%-8s %-14s %9d  max psl %d over the limit of %d%s" % (r["type"], r["key_set"], r["size"], r["max_psl"], args.max_psl,
+					" (stopped after %d items)" % r["inserted"] if r["truncated"] else ""), file=sys.stderr)
+				status = 1
+	if args.compare:
+		with open(args.compare) as f:
+			worse = compare(json.load(f), results)
+		for dtype, key_set, size, what, old, new in worse:
+			print("%-8s %-14s %9d  %s %s -> %s" % (dtype, key_set, size, what, old, new), file=sys.stderr)
+		if worse:
+			status = 1
+	return status
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,197 @@
+#include <Python.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+	Python side of the key and value types, for the bindings that are compiled once per (dtype_key, dtype_val) pair
+	(int_int_Py.c and str_Py.c, see setup.py). The dtype codes are those of hash_funcs.h. For an integer side, with
+	KEY_ standing for VAL_ as well :
+
+	KEY_TAG         token naming the type in the symbols, e.g. u16 in dictType_i64_u16
+	KEY_NAME        the same as a string, as used in the dtype strings of mdict.create
+	KEY_DESC        the width and signedness used in the error messages, e.g. "16 bit unsigned"
+	KEY_MIN/MAX     range of the type
+	KEY_IS_SIGNED   1 for the signed types
+	KEY_NUMPY       NumPy dtype of the exported arrays
+	KEY_FORMAT      buffer (struct module) format of the exported arrays
+	_key_to_py(k)   new Python int holding k
+
+	A string side only defines KEY_TAG, KEY_NAME, KEY_DESC and _key_to_py, which decodes the UTF-8 bytes of the box.
+
+	The type independent helpers both bindings share (_int_from_py, _fastcall_args) are defined at the end.
+*/
+
+#define _MDICT_CAT(a, b) a##b
+#define MDICT_CAT(a, b) _MDICT_CAT(a, b)
+#define _MDICT_STR(a) #a
+#define MDICT_STR(a) _MDICT_STR(a)
+
+#define _DT_TAG_1 i32
+#define _DT_DESC_1 "32 bit"
+#define _DT_MIN_1 INT32_MIN
+#define _DT_MAX_1 INT32_MAX
+#define _DT_SIGNED_1 1
+#define _DT_NUMPY_1 "int32"
+#define _DT_FORMAT_1 "i"
+
+#define _DT_TAG_2 i64
+#define _DT_DESC_2 "64 bit"
+#define _DT_MIN_2 INT64_MIN
+#define _DT_MAX_2 INT64_MAX
+#define _DT_SIGNED_2 1
+#define _DT_NUMPY_2 "int64"
+#define _DT_FORMAT_2 "q"
+
+#define _DT_TAG_5 str
+#define _DT_DESC_5 "string"
+
+#define _DT_TAG_6 u32
+#define _DT_DESC_6 "32 bit unsigned"
+#define _DT_MIN_6 0
+#define _DT_MAX_6 UINT32_MAX
+#define _DT_SIGNED_6 0
+#define _DT_NUMPY_6 "uint32"
+#define _DT_FORMAT_6 "I"
+
+#define _DT_TAG_7 u64
+#define _DT_DESC_7 "64 bit unsigned"
+#define _DT_MIN_7 0
+#define _DT_MAX_7 UINT64_MAX
+#define _DT_SIGNED_7 0
+#define _DT_NUMPY_7 "uint64"
+#define _DT_FORMAT_7 "Q"
+
+#define _DT_TAG_8 i16
+#define _DT_DESC_8 "16 bit"
+#define _DT_MIN_8 INT16_MIN
+#define _DT_MAX_8 INT16_MAX
+#define _DT_SIGNED_8 1
+#define _DT_NUMPY_8 "int16"
+#define _DT_FORMAT_8 "h"
+
+#define _DT_TAG_9 u16
+#define _DT_DESC_9 "16 bit unsigned"
+#define _DT_MIN_9 0
+#define _DT_MAX_9 UINT16_MAX
+#define _DT_SIGNED_9 0
+#define _DT_NUMPY_9 "uint16"
+#define _DT_FORMAT_9 "H"
+
+#define KEY_TAG MDICT_CAT(_DT_TAG_, dtype_key)
+#define KEY_NAME MDICT_STR(KEY_TAG)
+#define KEY_DESC MDICT_CAT(_DT_DESC_, dtype_key)
+#define VAL_TAG MDICT_CAT(_DT_TAG_, dtype_val)
+#define VAL_NAME MDICT_STR(VAL_TAG)
+#define VAL_DESC MDICT_CAT(_DT_DESC_, dtype_val)
+
+#if dtype_key == 5
+    #define _key_to_py(k) PyUnicode_DecodeUTF8((k).str, (k).len, NULL)
+#else
+    #define KEY_MIN MDICT_CAT(_DT_MIN_, dtype_key)
+    #define KEY_MAX MDICT_CAT(_DT_MAX_, dtype_key)
+    #define KEY_IS_SIGNED MDICT_CAT(_DT_SIGNED_, dtype_key)
+    #define KEY_NUMPY MDICT_CAT(_DT_NUMPY_, dtype_key)
+    #define KEY_FORMAT MDICT_CAT(_DT_FORMAT_, dtype_key)
+    #if KEY_IS_SIGNED
+        #define _key_to_py(k) PyLong_FromLongLong((long long) (k))
+    #else
+        #define _key_to_py(k) PyLong_FromUnsignedLongLong((unsigned long long) (k))
+    #endif
+#endif
+
+#if dtype_val == 5
+    #define _val_to_py(v) PyUnicode_DecodeUTF8((v).str, (v).len, NULL)
+#else
+    #define VAL_MIN MDICT_CAT(_DT_MIN_, dtype_val)
+    #define VAL_MAX MDICT_CAT(_DT_MAX_, dtype_val)
+    #define VAL_IS_SIGNED MDICT_CAT(_DT_SIGNED_, dtype_val)
+    #define VAL_NUMPY MDICT_CAT(_DT_NUMPY_, dtype_val)
+    #define VAL_FORMAT MDICT_CAT(_DT_FORMAT_, dtype_val)
+    #if VAL_IS_SIGNED
+        #define _val_to_py(v) PyLong_FromLongLong((long long) (v))
+    #else
+        #define _val_to_py(v) PyLong_FromUnsignedLongLong((unsigned long long) (v))
+    #endif
+#endif
+
+// Suffix of the symbols of the module, e.g. i64_u16, and its name within the _mdict_c package.
+#define MDICT_TAG MDICT_CAT(KEY_TAG, MDICT_CAT(_, VAL_TAG))
+#define MDICT_NAME MDICT_STR(MDICT_TAG)
+#define MDICT_SYM(name) MDICT_CAT(name, MDICT_CAT(_, MDICT_TAG))
+
+
+static inline int _int_from_py(PyObject* obj, bool is_signed, int64_t min, uint64_t max, uint64_t* out) {
+    /*
+    Converts the Python int obj into an integer of a type of the given signedness and range. The bits of the value are
+    written to out, to be cast back to the type. Returns -1, with an exception set, if obj is not an int or is out of
+    range.
+    */
+
+    if (is_signed) {
+        long long x = PyLong_AsLongLong(obj);
+        if (x == -1 && PyErr_Occurred())
+            return -1;
+        if (x < min || x > (long long) max) {
+            PyErr_SetString(PyExc_OverflowError, "int out of range");
+            return -1;
+        }
+        *out = (uint64_t) x;
+    } else {
+        unsigned long long x = PyLong_AsUnsignedLongLong(obj);
+        if (x == (unsigned long long) -1 && PyErr_Occurred())
+            return -1;
+        if (x > max) {
+            PyErr_SetString(PyExc_OverflowError, "int out of range");
+            return -1;
+        }
+        *out = (uint64_t) x;
+    }
+    return 0;
+}
+
+
+static int _fastcall_args(const char* name, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames, const char* const* kwlist, Py_ssize_t min_args, Py_ssize_t max_args, PyObject** out) {
+    /*
+    Argument parsing for the METH_FASTCALL methods, which receive their arguments as an array instead of a tuple. Sets
+    out[i] to the i-th of at most max_args arguments, min_args of which are required. Arguments may also be passed by
+    the names in kwlist, unless it is NULL. The entries of out for omitted arguments are left untouched. Raises a
+    TypeError and returns -1 on bad arguments, returns 0 otherwise.
+    */
+
+    Py_ssize_t num_kw = kwnames ? PyTuple_GET_SIZE(kwnames) : 0;
+
+    if (nargs > max_args || (!kwlist && nargs < min_args)) {
+        if (min_args == max_args)
+            PyErr_Format(PyExc_TypeError, "%s() takes exactly %zd argument%s (%zd given)", name, min_args, min_args == 1 ? "" : "s", nargs);
+        else
+            PyErr_Format(PyExc_TypeError, "%s() takes from %zd to %zd arguments (%zd given)", name, min_args, max_args, nargs);
+        return -1;
+    }
+
+    for (Py_ssize_t i = 0; i < nargs; ++i)
+        out[i] = args[i];
+
+    for (Py_ssize_t j = 0; j < num_kw; ++j) {
+        PyObject* kw = PyTuple_GET_ITEM(kwnames, j);
+        Py_ssize_t i = 0;
+        while (kwlist && i < max_args && PyUnicode_CompareWithASCIIString(kw, kwlist[i]) != 0)
+            ++i;
+        if (!kwlist || i == max_args) {
+            PyErr_Format(PyExc_TypeError, "%s() got an unexpected keyword argument '%U'", name, kw);
+            return -1;
+        }
+        if (i < nargs) {
+            PyErr_Format(PyExc_TypeError, "%s() got multiple values for argument '%s'", name, kwlist[i]);
+            return -1;
+        }
+        out[i] = args[nargs + j];
+    }
+
+    for (Py_ssize_t i = nargs; i < min_args; ++i) {
+        if (!out[i]) {
+            PyErr_Format(PyExc_TypeError, "%s() missing required argument '%s'", name, kwlist[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
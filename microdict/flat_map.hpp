@@ -0,0 +1,726 @@
+#ifndef MICRODICT_FLAT_MAP_HPP
+#define MICRODICT_FLAT_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "wyhash.h"
+
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+/*
+	Header-only C++17 version of the microdict hashtable, for C++ programs that can not use the C core because its key
+	and value types are fixed by the dtype_key / dtype_val macros at compile time of the whole translation unit.
+
+		#include "flat_map.hpp"
+
+		microdict::flat_map<int64_t, int64_t> m;
+		m[42] = 1;
+		m.insert_or_assign(7, 2);
+		for (auto [k, v] : m)
+			...
+
+	The table is laid out and probed like the hashed layout of mdict_ht.h : keys and values live in two separate
+	arrays, a bitmap marks the empty buckets, a probe sequence length is kept per group of 32 buckets, buckets are
+	probed in triangular steps (home, +1, +3, +6 ...), the table doubles from 32 buckets once it is PEAK_LOAD full and
+	halves once a deletion leaves it a quarter full. So a flat_map takes the same memory as a microdict of the same
+	size, and integer keys hash to themselves as they do there. std::string and std::string_view keys are hashed with
+	wyhash, seeded per table.
+
+	Key and value handling is chosen at compile time : tables of trivially copyable keys and values grow with realloc
+	and rehash in place, as the C core does, while other types (e.g. std::string) are moved into new arrays.
+
+	It follows the std::unordered_map interface for the common operations, with two differences :
+
+	* Dereferencing an iterator gives a std::pair<const K&, V&> proxy rather than a reference to a stored pair, since
+	  keys and values are stored apart. Loop with "for (auto [k, v] : m)" or "for (auto&& kv : m)".
+	* Inserting may rehash and so invalidates every iterator, reference and pointer. Erasing by key may shrink the
+	  table and invalidate them too, while erase(iterator) never shrinks it, so that erasing while iterating works.
+*/
+
+#ifndef MDICT_MALLOC
+	#define MDICT_MALLOC malloc
+	#define MDICT_CALLOC calloc
+	#define MDICT_REALLOC realloc
+	#define MDICT_FREE free
+#endif
+
+namespace microdict {
+
+
+template <typename K, typename Enable = void>
+struct hash : std::hash<K> {};
+
+
+template <typename K>
+struct hash<K, std::enable_if_t<std::is_integral_v<K> || std::is_enum_v<K>>> {
+	// Identity, as int_hash in hash_funcs.h
+	size_t operator()(K key) const noexcept { return (size_t) key; }
+};
+
+
+template <>
+struct hash<std::string_view> {
+	uint64_t seed;
+
+	hash() : seed(next_seed()) {}
+
+	size_t operator()(std::string_view s) const noexcept { return (size_t) wyhash(s.data(), s.size(), seed, _wyp); }
+
+	static uint64_t next_seed() {
+		// A random device read per thread, rather than per table.
+		static thread_local uint64_t state = ((uint64_t) std::random_device()() << 32) ^ std::random_device()();
+		return wyrand(&state);
+	}
+};
+
+
+template <>
+struct hash<std::string> : hash<std::string_view> {};
+
+
+template <typename K, typename V, typename Hash = microdict::hash<K>, typename KeyEqual = std::equal_to<K>>
+class flat_map {
+	static_assert(alignof(K) <= alignof(std::max_align_t) && alignof(V) <= alignof(std::max_align_t), "over-aligned keys and values are not supported");
+
+	static constexpr bool trivial = std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>; // Grows with realloc and rehashes in place.
+
+	template <bool Const>
+	class iter;
+
+public:
+	typedef K key_type;
+	typedef V mapped_type;
+	typedef std::pair<const K, V> value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef Hash hasher;
+	typedef KeyEqual key_equal;
+	typedef iter<false> iterator;
+	typedef iter<true> const_iterator;
+
+	static constexpr double PEAK_LOAD = 0.79; // As in hash_funcs.h
+	static constexpr size_t MIN_BUCKETS = 32;
+
+	flat_map() = default;
+
+	explicit flat_map(size_t n, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual()) : hash_(hash), equal_(equal) {
+		reserve(n);
+	}
+
+	// The constructors that insert delegate to flat_map(), so that the destructor cleans up if an insert throws.
+	flat_map(std::initializer_list<value_type> items) : flat_map() {
+		reserve(items.size());
+		insert(items.begin(), items.end());
+	}
+
+	template <typename InputIt>
+	flat_map(InputIt first, InputIt last) : flat_map() {
+		insert(first, last);
+	}
+
+	flat_map(const flat_map& other) : flat_map(0, other.hash_, other.equal_) {
+		/*
+		Copies the arrays bucket for bucket, the hash function (and so its seed) being copied along.
+		*/
+
+		if (!other.num_buckets_)
+			return;
+
+		allocate(other.num_buckets_, keys_, vals_, flags_, psl_);
+		num_buckets_ = other.num_buckets_;
+		upper_bound_ = other.upper_bound_;
+		std::memcpy(psl_, other.psl_, flags_size(num_buckets_) * sizeof(uint32_t));
+		if constexpr (trivial) {
+			std::memcpy(flags_, other.flags_, flags_size(num_buckets_) * sizeof(uint32_t));
+			std::memcpy((void*) keys_, other.keys_, num_buckets_ * sizeof(K));
+			std::memcpy((void*) vals_, other.vals_, num_buckets_ * sizeof(V));
+			size_ = other.size_;
+		} else {
+			for (size_t i = other.next_occupied(0); i < num_buckets_; i = other.next_occupied(i + 1)) {
+				new (keys_ + i) K(other.keys_[i]);
+				try {
+					new (vals_ + i) V(other.vals_[i]);
+				} catch (...) {
+					keys_[i].~K();
+					throw;
+				}
+				set_occupied(flags_, i); // Marked once both are constructed, for the destructor to clean up after a throw.
+				++size_;
+			}
+		}
+	}
+
+	flat_map(flat_map&& other) noexcept : hash_(std::move(other.hash_)), equal_(std::move(other.equal_)) {
+		steal(other);
+	}
+
+	flat_map& operator=(const flat_map& other) {
+		if (this != &other) {
+			flat_map copy(other);
+			swap(copy);
+		}
+		return *this;
+	}
+
+	flat_map& operator=(flat_map&& other) noexcept {
+		if (this != &other) {
+			release();
+			hash_ = std::move(other.hash_);
+			equal_ = std::move(other.equal_);
+			steal(other);
+		}
+		return *this;
+	}
+
+	~flat_map() {
+		release();
+	}
+
+	void swap(flat_map& other) noexcept {
+		std::swap(keys_, other.keys_);
+		std::swap(vals_, other.vals_);
+		std::swap(flags_, other.flags_);
+		std::swap(psl_, other.psl_);
+		std::swap(num_buckets_, other.num_buckets_);
+		std::swap(size_, other.size_);
+		std::swap(upper_bound_, other.upper_bound_);
+		std::swap(hash_, other.hash_);
+		std::swap(equal_, other.equal_);
+	}
+
+	iterator begin() noexcept { return iterator(this, next_occupied(0)); }
+	const_iterator begin() const noexcept { return const_iterator(this, next_occupied(0)); }
+	const_iterator cbegin() const noexcept { return begin(); }
+	iterator end() noexcept { return iterator(this, num_buckets_); }
+	const_iterator end() const noexcept { return const_iterator(this, num_buckets_); }
+	const_iterator cend() const noexcept { return end(); }
+
+	bool empty() const noexcept { return size_ == 0; }
+	size_t size() const noexcept { return size_; }
+	size_t bucket_count() const noexcept { return num_buckets_; }
+	double load_factor() const noexcept { return num_buckets_ ? (double) size_ / num_buckets_ : 0.0; }
+	hasher hash_function() const { return hash_; }
+	key_equal key_eq() const { return equal_; }
+
+	size_t table_bytes() const noexcept {
+		/*
+		Bytes taken by the arrays of the table, as the "bytes" entry of a microdict's stats().
+		*/
+
+		return num_buckets_ * (sizeof(K) + sizeof(V)) + 2 * flags_size(num_buckets_) * sizeof(uint32_t);
+	}
+
+	size_t max_psl() const noexcept {
+		/*
+		Longest probe sequence of the table, as len(d.stats()["probe_lengths"]) - 1 for a microdict.
+		*/
+
+		size_t m = 0;
+		for (size_t g = 0; g < flags_size(num_buckets_); ++g)
+			m = psl_[g] > m ? psl_[g] : m;
+		return m;
+	}
+
+	void reserve(size_t n) {
+		/*
+		Grows the table so that it holds n items without resizing.
+		*/
+
+		if (n <= upper_bound_)
+			return;
+		size_t nb = num_buckets_ ? num_buckets_ : MIN_BUCKETS;
+		while ((size_t) (nb * PEAK_LOAD) < n)
+			nb <<= 1;
+		resize(nb);
+	}
+
+	void clear() noexcept {
+		/*
+		Removes every item and keeps the arrays, as dict.clear() does on the Python side.
+		*/
+
+		if (!num_buckets_)
+			return;
+		destroy_all();
+		std::memset(flags_, 0xff, flags_size(num_buckets_) * sizeof(uint32_t));
+		std::memset(psl_, 0, flags_size(num_buckets_) * sizeof(uint32_t));
+		size_ = 0;
+	}
+
+	iterator find(const K& key) noexcept { return iterator(this, find_index(key)); }
+	const_iterator find(const K& key) const noexcept { return const_iterator(this, find_index(key)); }
+	bool contains(const K& key) const noexcept { return find_index(key) != num_buckets_; }
+	size_t count(const K& key) const noexcept { return contains(key); }
+
+	V& at(const K& key) {
+		size_t i = find_index(key);
+		if (i == num_buckets_)
+			throw std::out_of_range("microdict::flat_map::at : key not found");
+		return vals_[i];
+	}
+
+	const V& at(const K& key) const {
+		return const_cast<flat_map*>(this)->at(key);
+	}
+
+	V& operator[](const K& key) { return try_emplace(key).first.value(); }
+	V& operator[](K&& key) { return try_emplace(std::move(key)).first.value(); }
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(const K& key, Args&&... args) { return emplace_key(key, std::forward<Args>(args)...); }
+
+	template <typename... Args>
+	std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) { return emplace_key(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args) {
+		/*
+		Builds the key and value from args as a std::pair<K, V> would, then inserts them unless the key is present.
+		*/
+
+		std::pair<K, V> item(std::forward<Args>(args)...);
+		return emplace_key(std::move(item.first), std::move(item.second));
+	}
+
+	std::pair<iterator, bool> insert(const value_type& item) { return emplace_key(item.first, item.second); }
+	std::pair<iterator, bool> insert(value_type&& item) { return emplace_key(item.first, std::move(item.second)); }
+
+	template <typename InputIt>
+	void insert(InputIt first, InputIt last) {
+		for (; first != last; ++first)
+			emplace_key((*first).first, (*first).second);
+	}
+
+	void insert(std::initializer_list<value_type> items) { insert(items.begin(), items.end()); }
+
+	template <typename M>
+	std::pair<iterator, bool> insert_or_assign(const K& key, M&& val) {
+		auto ret = emplace_key(key, std::forward<M>(val));
+		if (!ret.second)
+			ret.first.value() = std::forward<M>(val);
+		return ret;
+	}
+
+	template <typename M>
+	std::pair<iterator, bool> insert_or_assign(K&& key, M&& val) {
+		auto ret = emplace_key(std::move(key), std::forward<M>(val));
+		if (!ret.second)
+			ret.first.value() = std::forward<M>(val);
+		return ret;
+	}
+
+	size_t erase(const K& key) {
+		/*
+		Removes key if present and returns the number of items removed. Like mdict_del_map, shrinks the table once it
+		is a quarter full.
+		*/
+
+		size_t i = find_index(key);
+		if (i == num_buckets_)
+			return 0;
+		remove_at(i);
+		if (size_ <= (num_buckets_ >> 2) && num_buckets_ > MIN_BUCKETS)
+			resize(num_buckets_ >> 1);
+		return 1;
+	}
+
+	iterator erase(const_iterator pos) {
+		/*
+		Removes the item at pos and returns an iterator to the next one. Never shrinks the table, so other iterators
+		stay valid.
+		*/
+
+		size_t i = pos.index();
+		remove_at(i);
+		return iterator(this, next_occupied(i + 1));
+	}
+
+	iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+private:
+	K* keys_ = nullptr;
+	V* vals_ = nullptr;
+	uint32_t* flags_ = nullptr; // One bit per bucket, set for the empty ones.
+	uint32_t* psl_ = nullptr; // Longest probe sequence of the keys whose home bucket is in each group of 32 buckets.
+	size_t num_buckets_ = 0, size_ = 0, upper_bound_ = 0;
+	Hash hash_;
+	KeyEqual equal_;
+
+	static size_t flags_size(size_t num_buckets) noexcept { return (num_buckets + 31) >> 5; }
+	static bool is_empty(const uint32_t* flags, size_t i) noexcept { return (flags[i >> 5] >> (i & 0x1f)) & 1; }
+	static void set_occupied(uint32_t* flags, size_t i) noexcept { flags[i >> 5] &= ~(1u << (i & 0x1f)); }
+	static void set_empty(uint32_t* flags, size_t i) noexcept { flags[i >> 5] |= 1u << (i & 0x1f); }
+
+	size_t next_occupied(size_t i) const noexcept {
+		/*
+		Returns the index of the first occupied bucket at or after i, or num_buckets_, as _flags_next_occupied does.
+		*/
+
+		if (i >= num_buckets_)
+			return num_buckets_;
+
+		size_t w = i >> 5, last_w = (num_buckets_ - 1) >> 5;
+		uint32_t word = ~flags_[w] & (0xffffffffu << (i & 0x1f)); // Set bits mark occupied buckets
+
+		while (!word) {
+			if (++w > last_w)
+				return num_buckets_;
+			word = ~flags_[w];
+		}
+
+		i = (w << 5) + ctz(word);
+		return i < num_buckets_ ? i : num_buckets_;
+	}
+
+	static unsigned ctz(uint32_t x) noexcept {
+#if defined(_MSC_VER)
+		unsigned long r;
+		_BitScanForward(&r, x);
+		return (unsigned) r;
+#else
+		return (unsigned) __builtin_ctz(x);
+#endif
+	}
+
+	size_t find_index(const K& key) const noexcept {
+		/*
+		Returns the bucket holding key, or num_buckets_ if absent. Same probing as mdict_get_map : the search stops
+		after as many steps as the longest probe sequence recorded for the group of the home bucket.
+		*/
+
+		if (!size_)
+			return num_buckets_;
+
+		size_t mask = num_buckets_ - 1, idx = hash_(key) & mask, step = 0;
+		uint32_t psl_val = psl_[idx >> 5];
+
+		while (is_empty(flags_, idx) || !equal_(keys_[idx], key)) {
+			idx = (idx + (++step)) & mask;
+			if (step > psl_val)
+				return num_buckets_;
+		}
+		return idx;
+	}
+
+	std::pair<size_t, bool> find_slot(const K& key) {
+		/*
+		Returns the bucket holding key and false, or the bucket where key should be inserted and true, after growing
+		the table if it is full. Same probing as mdict_set : deletions leave empty buckets in the middle of probe
+		sequences, so the search goes on for psl_val steps before settling for the first empty bucket met.
+		*/
+
+		if (size_ >= upper_bound_)
+			resize(num_buckets_ ? num_buckets_ << 1 : MIN_BUCKETS);
+
+		size_t mask = num_buckets_ - 1, idx = hash_(key) & mask, last = idx, step = 0, free_idx = num_buckets_, free_step = 0;
+		uint32_t psl_val = psl_[last >> 5];
+
+		while (true) {
+			bool empty = is_empty(flags_, idx);
+			if (!empty && equal_(keys_[idx], key))
+				return {idx, false};
+
+			if (empty && free_idx == num_buckets_) {
+				free_idx = idx;
+				free_step = step;
+			}
+			if (free_idx != num_buckets_ && step >= psl_val)
+				break;
+
+			idx = (idx + (++step)) & mask;
+		}
+
+		if (free_step > psl_val)
+			psl_[last >> 5] = (uint32_t) free_step;
+		return {free_idx, true};
+	}
+
+	template <typename KK, typename... Args>
+	std::pair<iterator, bool> emplace_key(KK&& key, Args&&... args) {
+		auto [i, is_new] = find_slot(key);
+		if (is_new) {
+			new (keys_ + i) K(std::forward<KK>(key));
+			try {
+				new (vals_ + i) V(std::forward<Args>(args)...);
+			} catch (...) {
+				keys_[i].~K();
+				throw;
+			}
+			set_occupied(flags_, i);
+			++size_;
+		}
+		return {iterator(this, i), is_new};
+	}
+
+	void remove_at(size_t i) noexcept {
+		keys_[i].~K();
+		vals_[i].~V();
+		set_empty(flags_, i);
+		--size_;
+	}
+
+	static void allocate(size_t num_buckets, K*& keys, V*& vals, uint32_t*& flags, uint32_t*& psl) {
+		/*
+		Allocates the arrays of a table of num_buckets empty buckets, or throws std::bad_alloc.
+		*/
+
+		keys = (K*) MDICT_MALLOC(num_buckets * sizeof(K));
+		vals = (V*) MDICT_MALLOC(num_buckets * sizeof(V));
+		flags = (uint32_t*) MDICT_MALLOC(flags_size(num_buckets) * sizeof(uint32_t));
+		psl = (uint32_t*) MDICT_CALLOC(flags_size(num_buckets), sizeof(uint32_t));
+		if (!keys || !vals || !flags || !psl) {
+			MDICT_FREE(keys);
+			MDICT_FREE(vals);
+			MDICT_FREE(flags);
+			MDICT_FREE(psl);
+			keys = nullptr;
+			vals = nullptr;
+			flags = psl = nullptr;
+			throw std::bad_alloc();
+		}
+		std::memset(flags, 0xff, flags_size(num_buckets) * sizeof(uint32_t));
+	}
+
+	void resize(size_t new_num_buckets) {
+		/*
+		Moves the items into a table of new_num_buckets buckets. Throws std::bad_alloc, leaving the table unchanged, if
+		an allocation fails.
+		*/
+
+		if (new_num_buckets < MIN_BUCKETS)
+			new_num_buckets = MIN_BUCKETS;
+
+		uint32_t* new_flags = (uint32_t*) MDICT_MALLOC(flags_size(new_num_buckets) * sizeof(uint32_t));
+		uint32_t* new_psl = (uint32_t*) MDICT_CALLOC(flags_size(new_num_buckets), sizeof(uint32_t));
+		if (!new_flags || !new_psl) {
+			MDICT_FREE(new_flags);
+			MDICT_FREE(new_psl);
+			throw std::bad_alloc();
+		}
+		std::memset(new_flags, 0xff, flags_size(new_num_buckets) * sizeof(uint32_t));
+
+		if constexpr (trivial) {
+			if (num_buckets_ < new_num_buckets) {
+				K* new_keys = (K*) MDICT_REALLOC((void*) keys_, new_num_buckets * sizeof(K));
+				if (new_keys)
+					keys_ = new_keys;
+				V* new_vals = new_keys ? (V*) MDICT_REALLOC((void*) vals_, new_num_buckets * sizeof(V)) : nullptr;
+				if (!new_vals) {
+					MDICT_FREE(new_flags);
+					MDICT_FREE(new_psl);
+					throw std::bad_alloc();
+				}
+				vals_ = new_vals;
+			}
+
+			rehash_in_place(new_flags, new_psl, new_num_buckets);
+
+			if (num_buckets_ > new_num_buckets) {
+				// Shrinking realloc can only fail by keeping the larger block, which is still valid.
+				K* new_keys = (K*) MDICT_REALLOC((void*) keys_, new_num_buckets * sizeof(K));
+				if (new_keys)
+					keys_ = new_keys;
+				V* new_vals = (V*) MDICT_REALLOC((void*) vals_, new_num_buckets * sizeof(V));
+				if (new_vals)
+					vals_ = new_vals;
+			}
+		} else {
+			K* new_keys = (K*) MDICT_MALLOC(new_num_buckets * sizeof(K));
+			V* new_vals = (V*) MDICT_MALLOC(new_num_buckets * sizeof(V));
+			if (!new_keys || !new_vals) {
+				MDICT_FREE(new_keys);
+				MDICT_FREE(new_vals);
+				MDICT_FREE(new_flags);
+				MDICT_FREE(new_psl);
+				throw std::bad_alloc();
+			}
+
+			size_t new_mask = new_num_buckets - 1;
+			for (size_t j = next_occupied(0); j < num_buckets_; j = next_occupied(j + 1)) {
+				size_t i = hash_(keys_[j]) & new_mask, last = i, step = 0;
+				while (!is_empty(new_flags, i))
+					i = (i + (++step)) & new_mask;
+				set_occupied(new_flags, i);
+				if (step > new_psl[last >> 5])
+					new_psl[last >> 5] = (uint32_t) step;
+
+				new (new_keys + i) K(std::move(keys_[j]));
+				new (new_vals + i) V(std::move(vals_[j]));
+				keys_[j].~K();
+				vals_[j].~V();
+			}
+
+			MDICT_FREE(keys_);
+			MDICT_FREE(vals_);
+			keys_ = new_keys;
+			vals_ = new_vals;
+		}
+
+		MDICT_FREE(flags_);
+		MDICT_FREE(psl_);
+		flags_ = new_flags;
+		psl_ = new_psl;
+		num_buckets_ = new_num_buckets;
+		upper_bound_ = (size_t) (num_buckets_ * PEAK_LOAD);
+	}
+
+	void rehash_in_place(uint32_t* new_flags, uint32_t* new_psl, size_t new_num_buckets) noexcept {
+		/*
+		Same as rehash_int : every item is carried to its bucket in the new table, and the item it finds there, if
+		it has not been moved yet, is carried on in turn. The keys and vals arrays are large enough for both tables.
+		*/
+
+		size_t new_mask = new_num_buckets - 1;
+
+		for (size_t j = 0; j < num_buckets_; ++j) {
+			if (is_empty(flags_, j))
+				continue;
+
+			K key = keys_[j];
+			V val = vals_[j];
+			set_empty(flags_, j);
+
+			while (true) {
+				size_t i = hash_(key) & new_mask, last = i, step = 0;
+				while (!is_empty(new_flags, i))
+					i = (i + (++step)) & new_mask;
+				set_occupied(new_flags, i);
+				if (step > new_psl[last >> 5])
+					new_psl[last >> 5] = (uint32_t) step;
+
+				if (i < num_buckets_ && !is_empty(flags_, i)) {
+					std::swap(key, keys_[i]);
+					std::swap(val, vals_[i]);
+					set_empty(flags_, i);
+				} else {
+					keys_[i] = key;
+					vals_[i] = val;
+					break;
+				}
+			}
+		}
+	}
+
+	void destroy_all() noexcept {
+		if constexpr (!std::is_trivially_destructible_v<K> || !std::is_trivially_destructible_v<V>) {
+			for (size_t i = next_occupied(0); i < num_buckets_; i = next_occupied(i + 1)) {
+				keys_[i].~K();
+				vals_[i].~V();
+			}
+		}
+	}
+
+	void release() noexcept {
+		destroy_all();
+		MDICT_FREE(keys_);
+		MDICT_FREE(vals_);
+		MDICT_FREE(flags_);
+		MDICT_FREE(psl_);
+		keys_ = nullptr;
+		vals_ = nullptr;
+		flags_ = nullptr;
+		psl_ = nullptr;
+		num_buckets_ = size_ = upper_bound_ = 0;
+	}
+
+	void steal(flat_map& other) noexcept {
+		keys_ = other.keys_;
+		vals_ = other.vals_;
+		flags_ = other.flags_;
+		psl_ = other.psl_;
+		num_buckets_ = other.num_buckets_;
+		size_ = other.size_;
+		upper_bound_ = other.upper_bound_;
+		other.keys_ = nullptr;
+		other.vals_ = nullptr;
+		other.flags_ = nullptr;
+		other.psl_ = nullptr;
+		other.num_buckets_ = other.size_ = other.upper_bound_ = 0;
+	}
+};
+
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+template <bool Const>
+class flat_map<K, V, Hash, KeyEqual>::iter {
+	/*
+	Forward iterator over the occupied buckets, in bucket order. Dereferences to a std::pair<const K&, V&> proxy (with
+	a const V& for const_iterator).
+	*/
+
+	typedef std::conditional_t<Const, const flat_map, flat_map> map_type;
+	typedef std::conditional_t<Const, const V, V> val_type;
+
+	map_type* map_ = nullptr;
+	size_t i_ = 0;
+
+	friend class flat_map;
+	friend class iter<!Const>;
+
+	iter(map_type* map, size_t i) noexcept : map_(map), i_(i) {}
+
+public:
+	typedef std::forward_iterator_tag iterator_category;
+	typedef std::pair<const K, V> value_type;
+	typedef ptrdiff_t difference_type;
+	typedef std::pair<const K&, val_type&> reference;
+
+	struct pointer {
+		reference ref;
+		reference* operator->() noexcept { return &ref; }
+	};
+
+	iter() = default;
+
+	template <bool C = Const, typename = std::enable_if_t<C>>
+	iter(const iter<false>& other) noexcept : map_(other.map_), i_(other.i_) {}
+
+	const K& key() const noexcept { return map_->keys_[i_]; }
+	val_type& value() const noexcept { return map_->vals_[i_]; }
+	size_t index() const noexcept { return i_; } // Bucket of the item.
+
+	reference operator*() const noexcept { return reference(key(), value()); }
+	pointer operator->() const noexcept { return pointer{**this}; }
+
+	iter& operator++() noexcept {
+		i_ = map_->next_occupied(i_ + 1);
+		return *this;
+	}
+
+	iter operator++(int) noexcept {
+		iter old = *this;
+		++*this;
+		return old;
+	}
+
+	template <bool C>
+	bool operator==(const iter<C>& other) const noexcept { return i_ == other.i_ && map_ == other.map_; }
+
+	template <bool C>
+	bool operator!=(const iter<C>& other) const noexcept { return !(*this == other); }
+};
+
+
+template <typename K, typename V, typename Hash, typename KeyEqual>
+void swap(flat_map<K, V, Hash, KeyEqual>& a, flat_map<K, V, Hash, KeyEqual>& b) noexcept {
+	a.swap(b);
+}
+
+} // namespace microdict
+
+#endif
@@ -1,13 +1,35 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
 #include <math.h>
 
+/*
+Allocator hooks : every allocation made by the hashtable goes through these macros. Defining them before
+including the headers routes the memory of the tables elsewhere, e.g. to PyMem_RawMalloc in the Python bindings
+so that tracemalloc accounts for it.
+*/
+#ifndef MDICT_MALLOC
+    #define MDICT_MALLOC malloc
+    #define MDICT_CALLOC calloc
+    #define MDICT_REALLOC realloc
+    #define MDICT_FREE free
+#endif
+
 /*
 dtype : 1 refers to int32
 dtype : 2 refers to int64
 dtype : 3 refers to float32
 dtype : 4 refers to float64
 dtype : 5 refers to string
+dtype : 6 refers to uint32
+dtype : 7 refers to uint64
+dtype : 8 refers to int16
+dtype : 9 refers to uint16
+
+The key and the value types are picked independently. The string side(s) of a table are defined by _string.h,
+which includes this file once k_t, v_t, kbox_t and vbox_t of its string side(s) are defined.
 */
 
 
@@ -15,70 +37,57 @@ typedef int32_t i_t;
 
 #if dtype_key == 1
     typedef int32_t k_t;
+#elif dtype_key == 2
+    typedef int64_t k_t;
+#elif dtype_key == 6
+    typedef uint32_t k_t;
+#elif dtype_key == 7
+    typedef uint64_t k_t;
+#elif dtype_key == 8
+    typedef int16_t k_t;
+#elif dtype_key == 9
+    typedef uint16_t k_t;
+#endif
 
-    #if dtype_val == 1
-        typedef int32_t v_t;
-
-    #elif dtype_val == 2
-        typedef int64_t v_t;
-
-    #elif dtype_val == 3
-        typedef float v_t;
-
-    #elif dtype_val == 4
-        typedef double v_t;
-
-    #endif
+#if dtype_val == 1
+    typedef int32_t v_t;
+#elif dtype_val == 2
+    typedef int64_t v_t;
+#elif dtype_val == 3
+    typedef float v_t;
+#elif dtype_val == 4
+    typedef double v_t;
+#elif dtype_val == 6
+    typedef uint32_t v_t;
+#elif dtype_val == 7
+    typedef uint64_t v_t;
+#elif dtype_val == 8
+    typedef int16_t v_t;
+#elif dtype_val == 9
+    typedef uint16_t v_t;
+#endif
 
+#if dtype_key != 5
     typedef k_t kbox_t;
-    typedef v_t vbox_t;
 
     #define _hash_func int_hash
     #define _key_equal int_key_equal
 
     #define _get_key(h, idx) h->keys[idx]  
-    #define _get_val(h, idx) h->vals[idx]  
-
     #define _set_key(h, idx, key) {h->keys[idx] = key;} 
-    #define _set_val(h, idx, val) {h->vals[idx] = val;}  
-
-    #define GET_PTR(idx, step_increment) idx
-
-    #define _rehash_func rehash_int
-
-#elif dtype_key == 2
-    typedef int64_t k_t;
-
-    #if dtype_val == 1
-        typedef int32_t v_t;
-
-    #elif dtype_val == 2
-        typedef int64_t v_t;
-
-    #elif dtype_val == 3
-        typedef float v_t;
-
-    #elif dtype_val == 4
-        typedef double v_t;
-
-    #endif
+#endif
 
-    typedef k_t kbox_t;
+#if dtype_val != 5
     typedef v_t vbox_t;
 
-    #define _hash_func int_hash
-    #define _key_equal int_key_equal
-
-    #define _get_key(h, idx) h->keys[idx]  
     #define _get_val(h, idx) h->vals[idx]  
-
-    #define _set_key(h, idx, key) {h->keys[idx] = key;} 
     #define _set_val(h, idx, val) {h->vals[idx] = val;}  
+#endif
 
+#if dtype_key != 5 && dtype_val != 5
     #define GET_PTR(idx, step_increment) idx
 
     #define _rehash_func rehash_int
-
 #endif
 
 const double PEAK_LOAD = 0.79;
@@ -93,6 +102,33 @@ typedef struct
   i_t val_step_increment;
 } ht_param;
 
+typedef struct
+{
+    i_t num_slots, slot_bits; // Frozen layout, with num_slots = 1 << slot_bits. See mdict_frozen.h
+    i_t *offsets;
+    void *shm_base; // Set if the arrays live inside a shared memory mapping. See mdict_shm.h
+    size_t shm_size;
+    volatile uint64_t seq; // Single writer / multiple readers mode. See mdict_seqlock.h
+    void **retired;
+    i_t num_retired;
+    int64_t key_base; // Direct layout. See mdict_direct.h
+    void *index; // Insertion ordered layout. See mdict_ordered.h
+    i_t index_size, index_width, num_entries;
+    i_t max_items; // Bounded capacity mode. See mdict_evict.h
+    int policy;
+    i_t *lru_links;
+    i_t lru_head, lru_tail;
+    i_t *ref_bits;
+    i_t clock_hand;
+    uint64_t *expiry; // Per item expiration mode. See mdict_ttl.h
+    i_t expire_hand;
+    uint64_t next_expiry; // No item expires before this time, so mdict_expire has nothing to do until then.
+    i_t expire_holds; // While nonzero, lookups leave the expired items they find in place.
+    size_t max_bytes; // Memory budget. See mdict_budget.h
+    int budget_policy;
+    uint64_t rng;
+} h_ext_t;
+
 typedef struct
 {
     i_t num_buckets, size, upper_bound, k_t_size, v_t_size, key_str_len, val_str_len, k_step_increment, v_step_increment, seed;
@@ -101,8 +137,23 @@ typedef struct
     k_t *keys;
     v_t *vals;
     bool is_map;
+    bool is_frozen; // See mdict_frozen.h
+    bool is_small; // See mdict_small.h
+    bool is_direct; // See mdict_direct.h
+    bool is_ordered; // See mdict_ordered.h
+    bool is_seqlocked; // See mdict_seqlock.h
+    bool has_holes; // Set by deletions, which can leave empty buckets inside probe sequences (see mdict_set).
+    i_t num_resizes; // Statistics. See mdict_stats.h
+    uint64_t rehash_ns;
+    uint64_t version; // Bumped whenever an item is inserted or deleted, so that iterators can detect modifications.
+    h_ext_t *ext; // Fields of the layouts and modes above, allocated by mdict_ext for the first one enabled.
+#ifdef MDICT_STATS
+    uint64_t num_lookups, lookup_probes, num_inserts, insert_probes;
+#endif
 } h_t;
 
+#define _ext(h, field) ((h)->ext ? (h)->ext->field : 0) // Field of the extension, or 0 if h has none.
+
 
 #define MIN(a,b) (((a)<(b))?(a):(b))
 #define MAX(a,b) (((a)>(b))?(a):(b))
@@ -130,6 +181,39 @@ inline void _flags_setTrue_isempty(i_t *flag, i_t i){
 }
 
 
+#if defined(_MSC_VER)
+    #include <intrin.h>
+    static __inline int _ctz32(uint32_t x) { unsigned long r; _BitScanForward(&r, x); return (int) r; }
+    #define _popcount32(x) __popcnt(x)
+#else
+    #define _ctz32(x) __builtin_ctz(x)
+    #define _popcount32(x) __builtin_popcount(x)
+#endif
+
+i_t _flags_next_occupied(i_t *flag, i_t i, i_t num_buckets);
+
+inline i_t _flags_next_occupied(i_t *flag, i_t i, i_t num_buckets){
+    /*
+    Returns the index of the first occupied bucket at or after i, or num_buckets if there is none.
+    Scans a whole flags word at a time, so long runs of empty buckets cost one load per 32 buckets.
+    */
+
+    if (i >= num_buckets)
+        return num_buckets;
+
+    i_t w = i >> 5, last_w = (num_buckets - 1) >> 5;
+    uint32_t word = ~(uint32_t) flag[w] & (0xffffffffU << (i & 0x1fU)); // Set bits mark occupied buckets
+
+    while (!word) {
+        if (++w > last_w)
+            return num_buckets;
+        word = ~(uint32_t) flag[w];
+    }
+
+    i = (w << 5) + _ctz32(word);
+    return MIN(i, num_buckets);
+}
+
 inline i_t _flags_size(i_t num_buckets){
 
     return (i_t) ceil(num_buckets / 32.0);
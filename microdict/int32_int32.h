@@ -1,11 +0,0 @@
-#define dtype_key 1
-#define dtype_val 1
-
-#define MAX_key 2147483647 
-#define MAX_val 2147483647
-#define MIN_key -2147483648
-#define MIN_val -2147483648
-
-#include "hash_funcs.h"
-#include "mdict_ht.h"
-
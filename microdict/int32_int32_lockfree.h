@@ -0,0 +1,223 @@
+
+#ifndef MDICT_INT32_INT32_LOCKFREE_H
+#define MDICT_INT32_INT32_LOCKFREE_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "mdict_atomic.h"
+
+/*
+	Lock-free int32->int32 hashtable.
+
+	A key/value pair is packed into a single 64 bit slot (key in the high half, value in the low half),
+	so inserts and updates are one compare-and-swap and lookups are a plain atomic load per probe.
+	Once a slot has been claimed by a key it is never given to another key, which keeps the linear
+	probe sequences stable :
+
+	* mdict_lf_get is wait-free : it probes at most num_buckets slots and never retries.
+	* mdict_lf_set and mdict_lf_add are lock-free : a failed CAS means another thread made progress.
+
+	The key LF_EMPTY_KEY (INT32_MIN) marks empty slots and can not be stored. Items can not be deleted.
+
+	Resizing is blocking : the table never grows by itself. Once it holds LF_PEAK_LOAD * num_buckets
+	keys, inserting a new key fails with -1, and the owner has to stop every other thread using the
+	table before calling mdict_lf_resize. Size the table up front with mdict_lf_create to avoid this.
+
+	This header does not depend on the rest of the library and can be included by native code directly.
+*/
+
+#define LF_EMPTY_KEY INT32_MIN
+#define LF_PEAK_LOAD 0.79
+#define LF_MIX 0x9E3779B97F4A7C15ULL
+
+#define LF_PACK(key, val) (((uint64_t) (uint32_t) (key) << 32) | (uint32_t) (val))
+#define LF_KEY(slot) ((int32_t) (uint32_t) ((slot) >> 32))
+#define LF_VAL(slot) ((int32_t) (uint32_t) (slot))
+#define LF_EMPTY LF_PACK(LF_EMPTY_KEY, 0)
+
+typedef struct
+{
+	volatile uint64_t *slots;
+	int64_t num_buckets, max_size;
+	int bits;
+	volatile int64_t size;
+} lf_t;
+
+
+static inline int64_t _lf_home(const lf_t *t, int32_t key) {
+	// Fibonacci hashing : identity int hashes would cluster badly under linear probing.
+	return (int64_t) (((uint64_t) (uint32_t) key * LF_MIX) >> (64 - t->bits));
+}
+
+
+static inline int _lf_alloc(lf_t *t, int64_t capacity) {
+	int bits = 1;
+	while (((int64_t) 1 << bits) * LF_PEAK_LOAD < capacity && bits < 62)
+		bits += 1;
+
+	int64_t num_buckets = (int64_t) 1 << bits;
+	volatile uint64_t* slots = (volatile uint64_t*) malloc(num_buckets * sizeof(uint64_t));
+	if (!slots)
+		return -1;
+
+	for (int64_t i = 0; i < num_buckets; ++i)
+		slots[i] = LF_EMPTY;
+
+	t->slots = slots;
+	t->bits = bits;
+	t->num_buckets = num_buckets;
+	t->max_size = (int64_t) (num_buckets * LF_PEAK_LOAD);
+	return 0;
+}
+
+
+static inline lf_t *mdict_lf_create(int64_t capacity) {
+	/*
+	Creates a table able to hold at least capacity keys without resizing. Returns NULL if the allocation fails.
+	*/
+
+	lf_t* t = (lf_t*) calloc(1, sizeof(lf_t));
+	if (!t)
+		return NULL;
+
+	if (_lf_alloc(t, capacity < 1 ? 1 : capacity) < 0) {
+		free(t);
+		return NULL;
+	}
+	return t;
+}
+
+
+static inline void mdict_lf_delete(lf_t *t) {
+	if (t) {
+		free((void*) t->slots);
+		free(t);
+	}
+}
+
+
+static inline bool mdict_lf_get(const lf_t *t, int32_t key, int32_t *val) {
+	/*
+	Wait-free lookup. Returns true and sets *val if key is present.
+	*/
+
+	int64_t mask = t->num_buckets - 1;
+	int64_t idx = _lf_home(t, key);
+
+	for (int64_t step = 0; step < t->num_buckets; ++step) {
+		uint64_t slot = mdict_atomic_load_u64(&t->slots[idx]);
+		int32_t k = LF_KEY(slot);
+		if (k == key && key != LF_EMPTY_KEY) {
+			*val = LF_VAL(slot);
+			return true;
+		}
+		if (k == LF_EMPTY_KEY)
+			return false;
+		idx = (idx + 1) & mask;
+	}
+	return false;
+}
+
+
+static inline int _lf_upsert(lf_t *t, int32_t key, int32_t val, bool is_add, int32_t *new_val) {
+	if (key == LF_EMPTY_KEY)
+		return -2;
+
+	int64_t mask = t->num_buckets - 1;
+	int64_t idx = _lf_home(t, key);
+
+	for (int64_t step = 0; step < t->num_buckets; ) {
+		uint64_t slot = mdict_atomic_load_u64(&t->slots[idx]);
+
+		if (LF_KEY(slot) == key) {
+			// The slot belongs to key for good : retry the CAS until our update lands.
+			while (1) {
+				int32_t v = is_add ? (int32_t) ((uint32_t) LF_VAL(slot) + (uint32_t) val) : val;
+				if (mdict_atomic_cas_u64(&t->slots[idx], &slot, LF_PACK(key, v))) {
+					if (new_val)
+						*new_val = v;
+					return 0;
+				}
+			}
+		}
+
+		if (LF_KEY(slot) == LF_EMPTY_KEY) {
+			if (t->size >= t->max_size)
+				return -1;
+
+			if (mdict_atomic_cas_u64(&t->slots[idx], &slot, LF_PACK(key, val))) {
+				mdict_atomic_add_i64(&t->size, 1);
+				if (new_val)
+					*new_val = val;
+				return 1;
+			}
+			continue; // Another thread claimed the slot first : look at what it stored before moving on.
+		}
+
+		idx = (idx + 1) & mask;
+		step += 1;
+	}
+	return -1;
+}
+
+
+static inline int mdict_lf_set(lf_t *t, int32_t key, int32_t val) {
+	/*
+	Lock-free insert or update. Returns 1 if key was inserted, 0 if its value was replaced, -1 if the table is
+	full (see mdict_lf_resize) and -2 if key is LF_EMPTY_KEY.
+	*/
+
+	return _lf_upsert(t, key, val, false, NULL);
+}
+
+
+static inline int mdict_lf_add(lf_t *t, int32_t key, int32_t delta, int32_t *new_val) {
+	/*
+	Lock-free atomic counter update : adds delta to the value of key (wrapping around on overflow), inserting
+	key with the value delta if it is absent. The resulting value is stored in *new_val if new_val is not NULL.
+	Same return values as mdict_lf_set.
+	*/
+
+	return _lf_upsert(t, key, delta, true, new_val);
+}
+
+
+static inline int64_t mdict_lf_size(const lf_t *t) {
+	return t->size;
+}
+
+
+static inline int mdict_lf_resize(lf_t *t, int64_t capacity) {
+	/*
+	Blocking resize : rehashes the table so that it can hold at least capacity keys (and at least the keys already
+	present). No other thread may use the table during the call. Returns -1 if the allocation fails, in which case
+	the table is left unchanged.
+	*/
+
+	lf_t old = *t;
+	if (capacity < t->size)
+		capacity = t->size;
+
+	if (_lf_alloc(t, capacity) < 0) {
+		*t = old;
+		return -1;
+	}
+
+	int64_t mask = t->num_buckets - 1;
+	for (int64_t i = 0; i < old.num_buckets; ++i) {
+		uint64_t slot = old.slots[i];
+		if (LF_KEY(slot) != LF_EMPTY_KEY) {
+			int64_t idx = _lf_home(t, LF_KEY(slot));
+			while (t->slots[idx] != LF_EMPTY)
+				idx = (idx + 1) & mask;
+			t->slots[idx] = slot;
+		}
+	}
+
+	free((void*) old.slots);
+	mdict_atomic_fence();
+	return 0;
+}
+
+#endif
@@ -1,11 +0,0 @@
-#define dtype_key 2
-#define dtype_val 1
-
-#define MAX_key 9223372036854775807 
-#define MAX_val 2147483647
-#define MIN_key -9223372036854775808
-#define MIN_val -2147483648
-
-
-#include "hash_funcs.h"
-#include "mdict_ht.h"
@@ -1,10 +0,0 @@
-#define dtype_key 2
-#define dtype_val 2
-
-#define MAX_key 9223372036854775807 
-#define MAX_val 9223372036854775807
-#define MIN_key -9223372036854775808
-#define MIN_val -9223372036854775808
-
-#include "hash_funcs.h"
-#include "mdict_ht.h"
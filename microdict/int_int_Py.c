@@ -0,0 +1,2949 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#define MDICT_MALLOC PyMem_RawMalloc // The hashtable arrays are then visible to tracemalloc.
+#define MDICT_CALLOC PyMem_RawCalloc
+#define MDICT_REALLOC PyMem_RawRealloc
+#define MDICT_FREE PyMem_RawFree
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "dtypes_Py.h"
+#include "hash_funcs.h"
+#include "mdict_ht.h"
+#if dtype_key == 1 && dtype_val == 1
+    #include "int32_int32_lockfree.h"
+#endif
+#include <stdbool.h>
+#include <inttypes.h>
+#include "flags.h"
+#include "microdict_api.h"
+
+
+typedef struct {
+    PyObject_HEAD
+    h_t* ht;
+    bool valid_ht;
+    kbox_t temp_key;
+    vbox_t temp_val;
+    bool temp_isvalid;
+    uint32_t flags;
+    int active_iters;   // Number of running iterators, which hold the expired items in place (see _hold_expired).
+    int active_readers; // Number of get_many calls currently running without the GIL.
+    int active_exports; // Number of keys_array/values_array/items_arrays calls currently running without the GIL.
+} dictObj;
+
+typedef struct
+{
+    PyObject_HEAD
+    dictObj* dict;
+    h_t* ht;            // dict->ht when the iterator was created
+    uint64_t version;   // ht->version when the iterator was created
+    i_t iter_idx;
+    i_t iter_num;
+    bool holds;         // Whether the iterator is counted by dict->active_iters
+} iterObj;
+
+
+static void iter_dealloc(iterObj* self);
+static PyObject* key_iternext(iterObj* self);
+static PyObject* value_iternext(iterObj* self);
+static PyObject* item_iternext(iterObj* self);
+
+
+static PyTypeObject MDICT_SYM(keyIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " key iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) key_iternext,
+};
+
+static PyTypeObject MDICT_SYM(valueIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " value iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) value_iternext,
+};
+
+static PyTypeObject MDICT_SYM(itemIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " item iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) item_iternext,
+};
+
+
+void _expire(dictObj* self);
+
+static void _hold_expired(dictObj* dict, bool* holds, bool hold) {
+    /*
+    Starts or ends the hold of an iterator over dict. Reclaiming an expired item changes the version of the hashtable
+    and would invalidate the running iterators, so while any of them holds, lookups and len leave the expired items in
+    place (see mdict_ttl.h) : ht->ext->expire_holds counts the holding iterators whenever ht has an expiry. An iterator
+    holds from its creation until it is exhausted, invalidated or deallocated.
+    */
+
+    if (*holds == hold)
+        return;
+    *holds = hold;
+    dict->active_iters += hold ? 1 : -1;
+    if (_ext(dict->ht, expiry))
+        dict->ht->ext->expire_holds += hold ? 1 : -1;
+}
+
+static PyObject* _new_iter(dictObj* dict, PyTypeObject* type) {
+    /*
+    Returns a new iterator of the given type over dict. Every call to iter(dict), dict.values() or dict.items() gets its
+    own iterator, so nested and interleaved iterations do not share a cursor.
+    */
+
+    _expire(dict);
+    iterObj* self = PyObject_New(iterObj, type);
+    if (!self)
+        return NULL;
+
+    Py_INCREF(dict);
+    self->dict = dict;
+    self->ht = dict->ht;
+    self->version = dict->ht->version;
+    self->iter_idx = 0;
+    self->iter_num = 0;
+    self->holds = false;
+    _hold_expired(dict, &self->holds, true);
+    return (PyObject*) self;
+}
+
+static void iter_dealloc(iterObj* self) {
+    _hold_expired(self->dict, &self->holds, false);
+    Py_DECREF(self->dict);
+    PyObject_Del(self);
+}
+
+static int _iter_check(iterObj* self) {
+    /*
+    Raises a RuntimeError and returns -1 if an item was inserted into or deleted from the dictionary (or the dictionary
+    was cleared or frozen) since the iterator was created.
+    */
+
+    if (self->dict->ht != self->ht || self->ht->version != self->version) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetString(PyExc_RuntimeError, "microdictionary changed size during iteration");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject* value_iternext(iterObj* self) {
+    /*
+    Iterates over the values when __next__ is called on the iterator. Each time this function is called by __next__, the next value is returned.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    vbox_t val;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    val = h->vals[i];
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+
+    return _val_to_py(val);
+}
+
+
+static PyObject* item_iternext(iterObj* self) {
+    /*
+    Iterates over the items when __next__ is called on the iterator. Each time this function is called by __next__, the next item (key, value) is returned.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    kbox_t key; vbox_t val;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    key = h->keys[i];
+    val = h->vals[i];
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+
+    return Py_BuildValue("(NN)", _key_to_py(key), _val_to_py(val));
+}
+
+
+void _set_default_flags(dictObj* self) {
+    self->flags = 0;
+    _set_flag(&self->flags, FLAG_POP_ARG_EXC, true);
+    _set_flag(&self->flags, FLAG_POP_RET_EXC, true);
+}
+
+void _destroy(dictObj* self){
+    /*
+    Called by the destructor for deleting the hashtable.
+    */
+
+    if (self->valid_ht == true){
+        mdict_delete_ht(self->ht);
+        self->valid_ht = false;
+    }
+}
+
+int _check_mutable(dictObj* self) {
+    /*
+    Raises a TypeError and returns -1 if the hashtable has been frozen by dict.freeze(), and a RuntimeError if another
+    thread is exporting it into arrays. Returns 0 otherwise.
+    */
+
+    if (self->ht->is_frozen) {
+        PyErr_SetString(PyExc_TypeError, "Cannot modify a frozen microdictionary");
+        return -1;
+    }
+    if (self->active_exports > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Cannot modify a microdictionary while it is being exported in another thread");
+        return -1;
+    }
+    return 0;
+}
+
+int _parse_key(PyObject* obj, kbox_t* k) {
+    /*
+    Converts obj into a key. Raises a TypeError and returns -1 if obj is not an Int in the range of the key type.
+    */
+
+    uint64_t x;
+    if (_int_from_py(obj, KEY_IS_SIGNED, KEY_MIN, KEY_MAX, &x) == -1) {
+        PyErr_SetString(PyExc_TypeError, "Key needs to be a " KEY_DESC " Int");
+        return -1;
+    }
+    *k = (kbox_t) x;
+    return 0;
+}
+
+int _parse_val(PyObject* obj, vbox_t* v) {
+    /*
+    Converts obj into a value. Raises a TypeError and returns -1 if obj is not an Int in the range of the value type.
+    */
+
+    uint64_t x;
+    if (_int_from_py(obj, VAL_IS_SIGNED, VAL_MIN, VAL_MAX, &x) == -1) {
+        PyErr_SetString(PyExc_TypeError, "Value needs to be a " VAL_DESC " Int");
+        return -1;
+    }
+    *v = (vbox_t) x;
+    return 0;
+}
+
+void _key_error(kbox_t k) {
+    /*
+    Raises a KeyError for the absent key k.
+    */
+
+    char msg[24];
+#if KEY_IS_SIGNED
+    sprintf(msg, "%" PRId64, (int64_t) k);
+#else
+    sprintf(msg, "%" PRIu64, (uint64_t) k);
+#endif
+    PyErr_SetString(PyExc_KeyError, msg);
+}
+
+void _expire(dictObj* self) {
+    /*
+    Reclaims the expired items (see mdict_ttl.h) before a full scan of the hashtable, so that the scan does not return
+    them. Skipped while another thread is exporting the hashtable without the GIL, or while an iterator holds (see
+    _hold_expired).
+    */
+
+    if (_ext(self->ht, expiry) && self->active_exports == 0 && self->active_iters == 0 && mdict_expire(self->ht) > 0)
+        self->temp_isvalid = false;
+}
+
+int _get_int_buffer(PyObject* obj, Py_buffer* view, Py_ssize_t itemsize, bool is_signed, bool writable, const char* name) {
+    /*
+    Acquires a C contiguous buffer (e.g. a NumPy array or an array.array) of signed or unsigned integers of the given
+    item size. Raises a TypeError and returns -1 if obj does not export such a buffer. The caller must release the buffer.
+    */
+
+    int flags = PyBUF_FORMAT | PyBUF_C_CONTIGUOUS | (writable ? PyBUF_WRITABLE : 0);
+    if (PyObject_GetBuffer(obj, view, flags) < 0)
+        return -1;
+
+    const char* fmt = view->format ? view->format : "B";
+    if (*fmt == '<' || *fmt == '=' || *fmt == '@')
+        fmt += 1;
+
+    if (view->itemsize != itemsize || *fmt == '\0' || !strchr(is_signed ? "bhilqn" : "BHILQN", *fmt) || fmt[1] != '\0') {
+        char msg[80];
+        sprintf(msg, "%s must be a contiguous buffer of %d bit %s integers", name, (int) (itemsize * 8), is_signed ? "signed" : "unsigned");
+        PyErr_SetString(PyExc_TypeError, msg);
+        PyBuffer_Release(view);
+        return -1;
+    }
+
+    return 0;
+}
+
+void _create(dictObj* self){
+    /*
+    Called by the constructor for allocating and initializing the hashtable.
+    */
+
+    if (self->valid_ht == false){
+        self->ht = mdict_create(NULL);  
+        self->valid_ht = true;
+        self->temp_isvalid = false;
+    }    
+}
+
+
+static void custom_dealloc(dictObj* self) {
+    /*
+    The destructor
+    */
+
+    _destroy(self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject* custom_new(PyTypeObject *type, PyObject *args) {
+    /*
+    Allocates the dictObj
+    */
+
+    dictObj* self = (dictObj*) type->tp_alloc(type, 0);
+    self->valid_ht = false;
+    self->ht = NULL;
+    _set_default_flags(self);
+    return (PyObject*) self;
+}
+
+static int custom_init(dictObj* self, PyObject *args, PyObject *kwds) {
+    /*
+    Constructor for allocating and initializing the hashtable along with the iterators.
+    If concurrent_reads is true, the hashtable is put in the seqlock mode of mdict_seqlock.h so that get_many
+    can run without the GIL while another thread keeps modifying the dictionary.
+    If key_range is a tuple (key_min, key_max), the hashtable starts in the direct address layout of mdict_direct.h
+    for keys in [key_min, key_max). It switches to hashing by itself when a key outside of that range is inserted.
+    If ordered is true, the hashtable uses the insertion ordered layout of mdict_ordered.h.
+    If max_items is positive, the hashtable holds at most that many items and inserting a new key into a full
+    hashtable first evicts an item according to policy ("lru" or "clock", see mdict_evict.h).
+    If max_bytes is positive, the arrays of the hashtable take at most that many bytes (see mdict_budget.h). An insert
+    that would grow them past it either raises MemoryError (policy "fail", the default) or first removes a random item
+    (policy "random") or the item with the lowest value (policy "lowest"). With "lru" or "clock", the capacity is the
+    largest one that fits max_bytes. A max_bytes smaller than the arrays of an empty hashtable raises a ValueError.
+    */
+
+    static char* kwlist[] = {"concurrent_reads", "key_range", "ordered", "max_items", "policy", "max_bytes", NULL};
+    int concurrent_reads = 0, ordered = 0, max_items = 0, policy = EVICT_NONE, budget_policy = BUDGET_FAIL;
+    const char* policy_name = NULL;
+    Py_ssize_t max_bytes = 0;
+    PyObject* key_range = NULL;
+    long long key_min, key_max;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pOpizn", kwlist, &concurrent_reads, &key_range, &ordered, &max_items, &policy_name, &max_bytes))
+        return -1;
+
+    if (key_range == Py_None)
+        key_range = NULL;
+
+    if (ordered && (concurrent_reads || key_range)) {
+        PyErr_SetString(PyExc_ValueError, "ordered can not be combined with concurrent_reads or key_range");
+        return -1;
+    }
+
+    if (max_items < 0 || max_bytes < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_items and max_bytes must be positive");
+        return -1;
+    }
+
+    if (max_items || max_bytes) {
+        if (!policy_name)
+            policy_name = max_items ? "lru" : "fail";
+        policy = mdict_evict_policy(policy_name);
+        if (policy < 0) {
+            policy = EVICT_NONE;
+            budget_policy = max_items ? -1 : mdict_budget_policy(policy_name);
+        }
+        if (budget_policy < 0) {
+            PyErr_SetString(PyExc_ValueError, "policy must be \"lru\" or \"clock\", or with max_bytes alone \"fail\", \"random\" or \"lowest\"");
+            return -1;
+        }
+    }
+
+    if ((max_items || max_bytes) && (concurrent_reads || key_range || ordered)) {
+        PyErr_SetString(PyExc_ValueError, "max_items and max_bytes can not be combined with concurrent_reads, key_range or ordered");
+        return -1;
+    }
+
+    if (key_range) {
+        if (!PyTuple_Check(key_range)) {
+            PyErr_SetString(PyExc_TypeError, "key_range must be a tuple (key_min, key_max)");
+            return -1;
+        }
+        if (!PyArg_ParseTuple(key_range, "LL", &key_min, &key_max))
+            return -1;
+        if (key_min >= key_max || (uint64_t) key_max - (uint64_t) key_min > DIRECT_MAX_BUCKETS) {
+            PyErr_Format(PyExc_ValueError, "key_range must satisfy key_min < key_max <= key_min + %d", DIRECT_MAX_BUCKETS);
+            return -1;
+        }
+        if (concurrent_reads) {
+            PyErr_SetString(PyExc_ValueError, "key_range can not be combined with concurrent_reads");
+            return -1;
+        }
+    }
+
+    _create(self);
+    if (key_range && mdict_direct_enable(self->ht, key_min, key_max) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (ordered && mdict_ordered_enable(self->ht) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (policy && max_bytes) {
+        i_t budget_items = mdict_budget_max_items(self->ht, max_bytes, policy);
+        if (!budget_items) {
+            PyErr_SetString(PyExc_ValueError, "max_bytes is too small for the lru and clock policies");
+            return -1;
+        }
+        if (!max_items || budget_items < max_items)
+            max_items = budget_items;
+    }
+    if (policy && mdict_evict_enable(self->ht, max_items, policy) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    int ret_val = max_bytes ? mdict_budget_enable(self->ht, max_bytes, budget_policy) : 0;
+    if (ret_val == -2) {
+        PyErr_SetString(PyExc_ValueError, "max_bytes is too small for the arrays of an empty microdictionary");
+        return -1;
+    } else if (ret_val < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (concurrent_reads && mdict_seqlock_enable(self->ht) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    return 0;    
+}
+
+
+static PyObject* del(dictObj* self, PyObject* key){
+    /*
+    dict.pop() invokes this function. Only accepts a python string object of size at most key_str_len.
+    If the key argument is present, then this function deletes it. Otherwise it will either raise a KeyError
+    or return a None object depending on whether FLAG_POP_RET_EXC flag is set or not. 
+    By default, FLAG_POP_RET_EXC flag is set. 
+    */
+
+    kbox_t k; vbox_t v; int ret_val;
+
+    if (_parse_key(key, &k) == -1)
+        return NULL;
+
+    if (_check_mutable(self) == -1)
+        return NULL;
+
+    if (self->temp_isvalid && k == self->temp_key)
+        self->temp_isvalid = false;
+
+    if (mdict_del_map(self->ht, k, &v) == -2) {
+        if (!_get_flag(self->flags, FLAG_POP_RET_EXC))
+            return Py_BuildValue("");
+        _key_error(k);
+        return NULL;
+    }
+    else {
+        return _val_to_py(v);
+    }
+}
+
+static PyObject* clear(dictObj* self, PyObject* const* args, Py_ssize_t nargs){
+    /*
+    This function is called when dict.clear() is invoked. It takes an optional list argument which (if given)
+    must contain keys of int type. Goals is to delete all the keys present
+    in the given list. If the key type constraint is not met then either it will raise a TypeError
+    the first time the constraint is violated or just skip that key depending on whether FLAG_CLEAR_RET_EXC
+    is set. FLAG_CLEAR_RET_EXC is set by default.
+
+    If no argument is provided then, then a empty hashtable is created. Note that the PyObject is the same.
+    */
+
+    kbox_t k; int ret_val;
+    PyObject* list=NULL;
+
+    if (_fastcall_args("clear", args, nargs, NULL, NULL, 0, 1, &list) == -1)
+        return NULL;
+
+    if (_check_mutable(self) == -1)
+        return NULL;
+
+    if (!list && self->ht->is_seqlocked) {
+        mdict_seqlock_clear(self->ht); // get_many calls may still be reading the arrays.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list && _ext(self->ht, policy)) {
+        mdict_evict_clear(self->ht); // Keeps the capacity and the eviction policy.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list && self->ht->is_ordered) {
+        mdict_ordered_clear(self->ht); // Keeps the insertion ordered layout.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list && self->ht->is_direct) {
+        mdict_direct_clear(self->ht); // Keeps the direct address layout.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list) {
+        uint64_t version = self->ht->version;
+        size_t max_bytes = _ext(self->ht, max_bytes);
+        int budget_policy = _ext(self->ht, budget_policy);
+        _destroy(self);
+        _create(self);
+        self->ht->version = version + 1; // Invalidates the running iterators.
+        if (max_bytes && mdict_budget_enable(self->ht, max_bytes, budget_policy) < 0) // Keeps the memory budget.
+            return PyErr_NoMemory();
+        return Py_BuildValue("");
+    }
+
+    if (!PyList_CheckExact(list)) {
+        PyErr_SetString(PyExc_TypeError, "The first optional argument must be a list");
+        return NULL;
+    }
+
+    Py_ssize_t len = PyList_Size(list);
+    for (Py_ssize_t i=0; i<len; ++i){
+        PyObject* item = PyList_GetItem(list, i);
+        if (_parse_key(item, &k) == 0) {
+            mdict_del_map(self->ht, k, NULL);
+        } else if (_get_flag(self->flags, FLAG_CLEAR_RET_EXC)) {
+            return NULL;
+        }
+    }
+
+    self->temp_isvalid = false;
+    PyErr_Clear();
+    return Py_BuildValue("");
+}
+
+
+static PyObject* get_keys(dictObj* self) {
+    /*
+    This is called when dict.get_keys() is called. It returns a list containing all keys.
+    In case it fails to add a key into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        kbox_t key = h->keys[i];
+        PyObject* key_obj = _key_to_py(key);
+        if (key_obj != NULL)
+            PyList_SET_ITEM(list, idx, key_obj);
+        else {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to add all Keys to the list");
+            Py_DECREF(list);
+            return NULL;
+        }
+
+        idx += 1;
+    }
+
+    return list;
+}
+
+static PyObject* get_values(dictObj* self) {
+    /*
+    This is called when dict.get_values() is called. It returns a list containing all values.
+    In case it fails to add a value into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        vbox_t val = h->vals[i];
+        PyObject* val_obj = _val_to_py(val);
+        if (val_obj != NULL)
+            PyList_SET_ITEM(list, idx, val_obj);
+        else {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to add all Values to the list");
+            Py_DECREF(list);
+            return NULL;                
+        }
+        idx += 1;
+    }
+
+    return list;
+}
+
+static PyObject* get_items(dictObj* self) {
+    /*
+    This is called when dict.get_items() is called. It returns a list containing all items (key,value).
+    In case it fails to add an item into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        kbox_t key = h->keys[i];
+        vbox_t val = h->vals[i];
+        PyObject* item_obj = Py_BuildValue("(NN)", _key_to_py(key), _val_to_py(val));
+        if (item_obj != NULL)
+            PyList_SET_ITEM(list, idx, item_obj);
+        else {                
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to add all (Key, value) pairs to the list");
+            Py_DECREF(list);
+            return NULL;                
+        }
+        idx += 1;
+    }
+
+    return list;
+}
+
+int _update_from_Pydict(dictObj* self, PyObject* dict) {
+    /*
+    This function updates the hashtable with items from a given Python Dictionary. In case the python
+    dictionary contains an item with non-matching types, then either that item will be skipped or TypeError
+    will be raised depending on whether FLAG_UPDATE_ARG_EXC is set or not. FLAG_UPDATE_ARG_EXC is set by default.
+    */
+
+    PyObject *key_obj, *value_obj;
+    Py_ssize_t pos = 0;
+
+    while (PyDict_Next(dict, &pos, &key_obj, &value_obj)) {
+        kbox_t key;
+        vbox_t val;
+        if (_parse_key(key_obj, &key) == -1) {
+            if (_get_flag(self->flags, FLAG_UPDATE_ARG_EXC)) {
+                PyErr_SetString(PyExc_TypeError, "Python Dictionary contains key objects of Non Integer type");
+                return -1;
+            } else
+                continue;
+        }
+        
+        if (_parse_val(value_obj, &val) == -1) {
+            if (_get_flag(self->flags, FLAG_UPDATE_ARG_EXC)) {
+                PyErr_SetString(PyExc_TypeError, "Python Dictionary contains value objects of Non Integer type");
+                return -1;
+            } else
+                continue;
+        }
+
+        if (mdict_set(self->ht, key, val) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+            return -1;
+        }
+    }
+    return 0;    
+}
+
+int _update_from_mdict(dictObj* self, dictObj* dict) {
+    /*
+    This function updates the hashtable with all the items from another dictionary (dict) of the same key, value type.
+    Returns -1 and raises MemoryError if an item could not be inserted.
+    */
+
+    _expire(dict);
+    h_t* h = self->ht;
+    h_t* h2 = dict->ht;
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h2->flags, 0, h2->num_buckets); idx<h2->size; i=_flags_next_occupied(h2->flags, i+1, h2->num_buckets)) {
+        kbox_t key = h2->keys[i];
+        vbox_t val = h2->vals[i];
+        if (mdict_set(h, key, val) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+            return -1;
+        }
+        idx += 1;     
+    }
+    return 0;
+}
+
+
+static PyObject* to_Pydict(dictObj* self) {
+    /*
+    Returns a newly created python dictionary after updating it with all the items from the hashtable.
+    Raises MemoryError if the dictionary could not successfully populated.
+    */
+
+    _expire(self);
+    h_t* h = self->ht;
+    PyObject* dict = PyDict_New();
+
+    if (dict != NULL) {
+        Py_ssize_t idx = 0;
+        for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<h->size; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+            kbox_t key = h->keys[i];
+            vbox_t val = h->vals[i];
+            if (PyDict_SetItem(dict, _key_to_py(key), _val_to_py(val)) == -1) {
+                if (_get_flag(self->flags, FLAG_PYDICT_ARG_EXC)) {    
+                    PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Could not add all (key, value) pairs to the Python Dictionary object");
+                    Py_DECREF(dict);
+                    return NULL;
+                } else
+                    return dict;
+            }
+            idx += 1;
+        }
+        return dict;
+    } else {
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the Python Dictionary object");
+        return NULL;
+    }
+}
+
+
+static int _contains_(dictObj* self, PyObject* key) {
+    /*
+    This function is called for the python expression 'k in dict' . k must be of the same type as the hashtable keys.
+    */
+
+    kbox_t k; i_t idx;
+    
+    if (_parse_key(key, &k) == -1)
+        return -1;
+
+    mdict_get_map(self->ht, k, &idx);
+    if (idx != self->ht->num_buckets)
+        return 1;
+    else
+        return 0;
+}
+
+static int _len_(dictObj* self) {
+    /*
+    This function is called when len(dict) is called. It returns the total number of items present.
+    */
+
+    _expire(self); // Expired items are not counted.
+    return self->ht->size;
+}
+
+
+static bool _cache_hit(dictObj* self, kbox_t k) {
+    /*
+    True if k is the key of the item cached by the key iterator (see key_iternext). Tables with expiring items do not
+    use the cache, since the cached item may have expired since it was cached, nor do bounded tables, whose lookups
+    must mark the item as recently used (see mdict_evict.h).
+    */
+
+    return self->temp_isvalid && !_ext(self->ht, expiry) && !_ext(self->ht, policy) && k == self->temp_key;
+}
+
+static PyObject* mapping_get(dictObj* self, PyObject* key){
+    /*
+    This function is invoked when dict[k] is called to return the corresponding value if present. If not present, a KeyError
+    is raised if flag FLAG_GET_RET_EXC is set and otherwise, a None is returned. By default FLAG_GET_RET_EXC 
+    is not set.
+    */
+
+    kbox_t k; vbox_t v; i_t idx;
+
+    if (_parse_key(key, &k) == -1)
+        return NULL;
+
+    if (_cache_hit(self, k)) {
+        return _val_to_py(self->temp_val);
+    } else {
+        v = mdict_get_map(self->ht, k, &idx);
+        if (idx != self->ht->num_buckets)
+            return _val_to_py(v);
+        else {
+            if (!_get_flag(self->flags, FLAG_GET_RET_EXC))
+                return Py_BuildValue("");
+
+            _key_error(k);
+            return NULL;
+        }
+    }
+}
+
+static PyObject* get(dictObj* self, PyObject* const* args, Py_ssize_t nargs) {
+    /*
+    Invoked for d.get(key, default=None). Returns the value of key if present and default otherwise, whether or not
+    FLAG_GET_RET_EXC is set.
+    */
+
+    kbox_t k; vbox_t v; i_t idx;
+    PyObject* params[2] = {NULL, Py_None};
+
+    if (_fastcall_args("get", args, nargs, NULL, NULL, 1, 2, params) == -1 || _parse_key(params[0], &k) == -1)
+        return NULL;
+
+    if (_cache_hit(self, k))
+        return _val_to_py(self->temp_val);
+
+    v = mdict_get_map(self->ht, k, &idx);
+    if (idx != self->ht->num_buckets)
+        return _val_to_py(v);
+
+    Py_INCREF(params[1]);
+    return params[1];
+}
+
+static int _set_item(dictObj* self, kbox_t k, vbox_t v) {
+    /*
+    Inserts k -> v into the (mutable) hashtable and keeps the cached item consistent. Raises a MemoryError and returns
+    -1 if the insertion fails.
+    */
+
+    if (mdict_set(self->ht, k, v) == -1) {     // insert a key to the hash table
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+        return -1;
+    }
+
+    if (self->temp_isvalid && k == self->temp_key) { // This logic supports that setting a value does not necessarily cache (key, val) pair and that the cache is mainly for the iterator.
+        self->temp_val = v;
+    } else if (_ext(self->ht, policy) || _ext(self->ht, max_bytes) || _ext(self->ht, expiry)) {
+        self->temp_isvalid = false; // The cached item may have been evicted or reclaimed.
+    }
+
+    return 0;
+}
+
+static int mapping_set(dictObj* self, PyObject* key, PyObject* val){
+    /*
+    This is invoked for the python expression d[key] = value. Both key and value must be of the hashtable type.
+    */
+
+    vbox_t v; kbox_t k;
+
+    if (_check_mutable(self) == -1)
+        return -1;
+    
+    if (_parse_key(key, &k) == -1)
+        return -1;
+
+    if (_parse_val(val, &v) == -1)
+        return -1;
+
+    return _set_item(self, k, v);
+}
+
+static PyObject* set(dictObj* self, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames) {
+    /*
+    Invoked for d.set(key, value, ttl=None). Same as d[key] = value, except that if ttl is given the item expires ttl
+    seconds later : it is then treated as absent and reclaimed lazily (see mdict_ttl.h). Setting a key without a ttl
+    makes it permanent again.
+    */
+
+    static const char* kwlist[] = {"key", "value", "ttl"};
+    PyObject* params[3] = {NULL, NULL, Py_None};
+    double seconds = 0;
+
+    if (_fastcall_args("set", args, nargs, kwnames, kwlist, 2, 3, params) == -1)
+        return NULL;
+    PyObject *key = params[0], *val = params[1], *ttl = params[2];
+
+    if (ttl != Py_None) {
+        if (_check_mutable(self) == -1)
+            return NULL;
+
+        seconds = PyFloat_AsDouble(ttl);
+        if (seconds == -1 && PyErr_Occurred())
+            return NULL;
+        if (!(seconds > 0)) {
+            PyErr_SetString(PyExc_ValueError, "ttl must be a positive number of seconds");
+            return NULL;
+        }
+
+        bool had_expiry = _ext(self->ht, expiry) != NULL;
+        int ret_val = mdict_ttl_enable(self->ht);
+        if (ret_val == -2) {
+            PyErr_SetString(PyExc_ValueError, "ttl is not supported by ordered, key_range or concurrent_reads microdictionaries");
+            return NULL;
+        } else if (ret_val < 0) {
+            return PyErr_NoMemory();
+        }
+        if (!had_expiry)
+            self->ht->ext->expire_holds += self->active_iters; // The running iterators now hold (see _hold_expired).
+    }
+
+    if (mapping_set(self, key, val) < 0)
+        return NULL;
+
+    if (ttl != Py_None) {
+        kbox_t k;
+        _parse_key(key, &k); // Cannot fail, mapping_set parsed it already.
+        mdict_ttl_expire_at(self->ht, k, mdict_now_ns() + (uint64_t) (MIN(seconds, 1e9) * 1e9));
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* expire(dictObj* self) {
+    /*
+    Invoked for d.expire(). Removes all the expired items right away and returns how many were removed.
+    */
+
+    if (_ext(self->ht, expiry) && _check_mutable(self) == -1)
+        return NULL;
+
+    i_t removed = mdict_expire(self->ht);
+    if (removed > 0)
+        self->temp_isvalid = false;
+    return PyLong_FromLong((long) removed);
+}
+
+static PyObject* mdict_iter(dictObj* self) {
+    /*
+    Returns a new iterator over the keys when __iter__(dict) is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(keyIterType));
+}
+
+
+static PyObject* key_iternext(iterObj* self) {
+    /*
+    Iterates over the keys. Each time __next__ is called on the key iterator, this function returns the next key.
+    The current item is cached in the dictionary, so that d[k] is free within a "for k in d" loop.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        self->dict->temp_isvalid = false;
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    kbox_t key;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    self->dict->temp_key = h->keys[i];
+    self->dict->temp_val = h->vals[i];
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+    self->dict->temp_isvalid = true;
+
+    return _key_to_py(self->dict->temp_key);
+}
+
+
+static PyObject* update(dictObj* self, PyObject* dict);
+
+static PyObject* get_value_iterator(dictObj* self) {
+    /*
+    Returns a new iterator over the values when dict.values() is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(valueIterType));
+}
+
+static PyObject* get_item_iterator(dictObj* self) {
+    /*
+    Returns a new iterator over the (key, value) items when dict.items() is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(itemIterType));
+}
+
+static PyObject* copy(dictObj* self) {
+    /*
+    Returns a new microdictionary object containing all items present in this hashtable when dict.copy() is called.
+    */
+
+    dictObj* new_obj = (dictObj *) PyObject_CallObject(((PyObject *) self)->ob_type, NULL);
+    if (!new_obj)
+        return NULL;
+    h_ext_t* ext = self->ht->ext;
+    if ((self->ht->is_ordered && mdict_ordered_enable(new_obj->ht) < 0) ||
+        (ext && ext->policy && mdict_evict_enable(new_obj->ht, ext->max_items, ext->policy) < 0) ||
+        (ext && ext->max_bytes && mdict_budget_enable(new_obj->ht, ext->max_bytes, ext->budget_policy) < 0)) {
+        Py_DECREF(new_obj);
+        return PyErr_NoMemory();
+    }
+    if (_update_from_mdict(new_obj, self) == -1) {
+        Py_DECREF(new_obj);
+        return NULL;
+    }
+    if (mdict_ttl_copy(new_obj->ht, self->ht) < 0) {
+        Py_DECREF(new_obj);
+        return PyErr_NoMemory();
+    }
+    return (PyObject*) new_obj;
+}
+
+static PyObject* freeze(dictObj* self) {
+    /*
+    Invoked when dict.freeze() is called. Converts the hashtable into the compact read-only layout described in
+    mdict_frozen.h. Lookups and iteration keep working as before while any modification raises a TypeError.
+    Freezing an already frozen dictionary does nothing. Raises a ValueError if the dictionary is ordered, since the
+    frozen layout groups the items by hash slot and would lose their insertion order.
+    */
+
+    if (self->ht->is_ordered) {
+        PyErr_SetString(PyExc_ValueError, "Cannot freeze an ordered microdictionary");
+        return NULL;
+    }
+
+    if (self->active_readers > 0 || self->active_exports > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Cannot freeze a microdictionary while another thread is reading it without the GIL");
+        return NULL;
+    }
+
+    if (!self->ht->is_frozen) {
+        _expire(self); // A frozen hashtable has no expiration.
+        h_t* f = mdict_freeze(self->ht);
+        if (!f) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the frozen hashtable");
+            return NULL;
+        }
+
+        f->version = self->ht->version + 1; // Invalidates the running iterators.
+        mdict_delete_ht(self->ht);
+        self->ht = f;
+        self->temp_isvalid = false;
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* is_frozen(dictObj* self) {
+    /*
+    Returns True if dict.freeze() has been called on this dictionary.
+    */
+
+    return PyBool_FromLong(self->ht->is_frozen);
+}
+
+static PyObject* _stats_list(const i_t* values, i_t len) {
+    /*
+    Returns a python list holding the len integers of values.
+    */
+
+    PyObject* list = PyList_New(len);
+    if (!list)
+        return NULL;
+    for (i_t i=0; i<len; ++i) {
+        PyObject* obj = PyLong_FromLong((long) values[i]);
+        if (!obj) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, obj);
+    }
+    return list;
+}
+
+static PyObject* stats(dictObj* self) {
+    /*
+    Invoked when dict.stats() is called. Returns a python dictionary describing the hashtable (see mdict_stats.h) : its
+    layout, size, bucket count and load factor, the bytes taken by each of its arrays, a histogram of the probe lengths
+    of the items, the max probe length of each group of 32 buckets, and how many resizes took place and for how long.
+    Builds compiled with MDICT_STATS also report how many lookups and inserts were made and their total probe steps.
+    */
+
+    h_t* h = self->ht;
+    size_t bytes[MDICT_NUM_ARRAYS], total_bytes = 0;
+    i_t *hist, hist_len;
+
+    if (mdict_probe_histogram(h, &hist, &hist_len) < 0)
+        return PyErr_NoMemory();
+    PyObject* probe_lengths = _stats_list(hist, hist_len);
+    MDICT_FREE(hist);
+    PyObject* group_max_psl = _stats_list(h->psl, (h->psl && !h->is_frozen) ? _flags_size(h->num_buckets) : 0);
+
+    PyObject* array_bytes = PyDict_New();
+    mdict_array_bytes(h, bytes);
+    for (int a=0; array_bytes && a<MDICT_NUM_ARRAYS; ++a) {
+        if (bytes[a] == 0)
+            continue;
+        total_bytes += bytes[a];
+        PyObject* obj = PyLong_FromSize_t(bytes[a]);
+        if (!obj || PyDict_SetItemString(array_bytes, mdict_array_names[a], obj) < 0)
+            Py_CLEAR(array_bytes);
+        Py_XDECREF(obj);
+    }
+
+    PyObject* dict = Py_BuildValue("{s:s,s:n,s:n,s:d,s:n,s:N,s:N,s:N,s:n,s:d}",
+        "layout", mdict_layout_name(h),
+        "size", (Py_ssize_t) h->size,
+        "num_buckets", (Py_ssize_t) h->num_buckets,
+        "load_factor", h->num_buckets ? (double) h->size / h->num_buckets : 0.0,
+        "bytes", (Py_ssize_t) total_bytes,
+        "array_bytes", array_bytes,
+        "probe_lengths", probe_lengths,
+        "group_max_psl", group_max_psl,
+        "num_resizes", (Py_ssize_t) h->num_resizes,
+        "rehash_seconds", h->rehash_ns * 1e-9);
+
+#ifdef MDICT_STATS
+    if (dict) {
+        PyObject* counters = Py_BuildValue("{s:K,s:K,s:K,s:K}", "num_lookups", h->num_lookups, "lookup_probes", h->lookup_probes,
+                                           "num_inserts", h->num_inserts, "insert_probes", h->insert_probes);
+        if (!counters || PyDict_Update(dict, counters) < 0)
+            Py_CLEAR(dict);
+        Py_XDECREF(counters);
+    }
+#endif
+
+    return dict;
+}
+
+static PyObject* size_of(dictObj* self) {
+    /*
+    Invoked by sys.getsizeof. Returns the size of the dictObj plus everything allocated for its hashtable, see
+    mdict_sizeof in mdict_stats.h. Iterators own no memory besides their object and are not counted.
+    */
+
+    size_t size = Py_TYPE(self)->tp_basicsize;
+    if (self->valid_ht)
+        size += mdict_sizeof(self->ht);
+    return PyLong_FromSize_t(size);
+}
+
+static PyObject* share(dictObj* self, PyObject* args) {
+    /*
+    Invoked when dict.share(name) is called. Publishes a frozen snapshot of the hashtable into the POSIX shared memory
+    segment called name (see mdict_shm.h), replacing any previous segment of that name. Other processes can then map it
+    read-only using mdict.attach. The dictionary itself is left unchanged. Raises OSError if the segment can not be written.
+    */
+
+    const char* name;
+    bool failed = false;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    h_t* f = self->ht->is_frozen ? self->ht : mdict_freeze(self->ht);
+    if (!f) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the frozen hashtable");
+        return NULL;
+    }
+
+    if (mdict_shm_publish(f, name) < 0) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+        failed = true;
+    }
+
+    if (f != self->ht)
+        mdict_delete_ht(f);
+
+    if (failed)
+        return NULL;
+
+    return Py_BuildValue("");
+}
+
+static PyObject* get_many(dictObj* self, PyObject* args) {
+    /*
+    Invoked for d.get_many(keys, out, default=0). keys must be a contiguous buffer of integers of the key type and out
+    a writable one of integers of the value type, of the same length. out[i] receives the value of keys[i], or default
+    if keys[i] is absent. Returns the number of keys found. The GIL is released during the lookups if the dictionary was
+    created with concurrent_reads=True or is frozen, so that several reader threads run in parallel with the writer.
+    */
+
+    PyObject *keys_obj, *out_obj, *default_obj = NULL;
+    Py_buffer kb, ob;
+    vbox_t default_val = 0;
+    int64_t n, num_found = 0;
+
+    if (!PyArg_ParseTuple(args, "OO|O", &keys_obj, &out_obj, &default_obj))
+        return NULL;
+
+    if (default_obj && _parse_val(default_obj, &default_val) == -1)
+        return NULL;
+
+    if (_get_int_buffer(keys_obj, &kb, sizeof(k_t), KEY_IS_SIGNED, false, "keys") < 0)
+        return NULL;
+
+    if (_get_int_buffer(out_obj, &ob, sizeof(v_t), VAL_IS_SIGNED, true, "out") < 0) {
+        PyBuffer_Release(&kb);
+        return NULL;
+    }
+
+    n = kb.len / kb.itemsize;
+    if (n != ob.len / ob.itemsize) {
+        PyErr_SetString(PyExc_ValueError, "keys and out must have the same length");
+        PyBuffer_Release(&kb);
+        PyBuffer_Release(&ob);
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    kbox_t* keys = (kbox_t*) kb.buf;
+    vbox_t* out = (vbox_t*) ob.buf;
+
+    if (h->is_seqlocked || h->is_frozen) {
+        self->active_readers += 1;
+        Py_BEGIN_ALLOW_THREADS
+        for (int64_t j = 0; j < n; ++j) {
+            bool found;
+            if (h->is_frozen) {
+                i_t idx;
+                out[j] = mdict_get_map(h, keys[j], &idx);
+                found = idx != h->num_buckets;
+            } else
+                found = mdict_seqlock_get_map(h, keys[j], &out[j]);
+
+            if (found)
+                num_found += 1;
+            else
+                out[j] = default_val;
+        }
+        Py_END_ALLOW_THREADS
+        self->active_readers -= 1;
+    } else {
+        for (int64_t j = 0; j < n; ++j) {
+            i_t idx;
+            out[j] = mdict_get_map(h, keys[j], &idx);
+            if (idx != h->num_buckets)
+                num_found += 1;
+            else
+                out[j] = default_val;
+        }
+    }
+
+    PyBuffer_Release(&kb);
+    PyBuffer_Release(&ob);
+    return PyLong_FromLongLong(num_found);
+}
+
+#define EXPORT_MIN_ITEMS_PER_THREAD (1 << 14)
+
+typedef struct {
+    h_t* h;
+    i_t w_start, w_end, num_items;
+    kbox_t* keys;
+    vbox_t* vals;
+    PyThread_type_lock done;
+} exportJob;
+
+static void _export_job(void* arg) {
+    exportJob* job = (exportJob*) arg;
+    mdict_export_words(job->h, job->w_start, job->w_end, job->keys, job->vals, job->num_items);
+    if (job->done)
+        PyThread_release_lock(job->done);
+}
+
+static void _export(h_t* h, kbox_t* keys, vbox_t* vals, int num_threads) {
+    /*
+    Fills keys and/or vals (each with room for h->size items) with the items of h in bucket order, using up to
+    num_threads threads that each export a contiguous range of flags words (see mdict_export.h). Small tables are
+    exported by the calling thread only. Runs without the GIL.
+    */
+
+    i_t num_words = _flags_size(h->num_buckets);
+    num_threads = MAX(1, MIN(num_threads, h->size / EXPORT_MIN_ITEMS_PER_THREAD));
+
+    exportJob* jobs = num_threads > 1 ? (exportJob*) calloc(num_threads, sizeof(exportJob)) : NULL;
+    if (!jobs) {
+        mdict_export_words(h, 0, num_words, keys, vals, h->size);
+        return;
+    }
+
+    i_t offset = 0;
+    for (int t = 0; t < num_threads; ++t) {
+        exportJob* job = &jobs[t];
+        job->h = h;
+        job->w_start = (i_t) ((int64_t) num_words * t / num_threads);
+        job->w_end = (i_t) ((int64_t) num_words * (t + 1) / num_threads);
+        job->num_items = mdict_count_words(h, job->w_start, job->w_end);
+        job->keys = keys ? keys + offset : NULL;
+        job->vals = vals ? vals + offset : NULL;
+        offset += job->num_items;
+    }
+
+    // Job 0 runs on the calling thread, as does any job whose thread could not be started.
+    for (int t = 1; t < num_threads; ++t) {
+        exportJob* job = &jobs[t];
+        job->done = PyThread_allocate_lock();
+        if (job->done && PyThread_acquire_lock(job->done, NOWAIT_LOCK) &&
+            PyThread_start_new_thread(_export_job, job) != PYTHREAD_INVALID_THREAD_ID)
+            continue;
+
+        if (job->done) {
+            PyThread_free_lock(job->done);
+            job->done = NULL;
+        }
+        _export_job(job);
+    }
+
+    _export_job(&jobs[0]);
+
+    for (int t = 1; t < num_threads; ++t) {
+        if (jobs[t].done) {
+            PyThread_acquire_lock(jobs[t].done, WAIT_LOCK);
+            PyThread_release_lock(jobs[t].done);
+            PyThread_free_lock(jobs[t].done);
+        }
+    }
+    free(jobs);
+}
+
+static PyObject* _wrap_array(PyObject* buffer, const char* numpy_dtype, const char* fmt) {
+    /*
+    Returns numpy.frombuffer(buffer, numpy_dtype) if NumPy can be imported and memoryview(buffer).cast(fmt) otherwise.
+    Neither copies the data. Steals the reference to buffer.
+    */
+
+    static PyObject* numpy = NULL;
+    static bool numpy_missing = false;
+    PyObject* array = NULL;
+
+    if (!numpy && !numpy_missing) {
+        numpy = PyImport_ImportModule("numpy");
+        if (!numpy && PyErr_ExceptionMatches(PyExc_ImportError)) {
+            PyErr_Clear();
+            numpy_missing = true;
+        }
+    }
+
+    if (numpy)
+        array = PyObject_CallMethod(numpy, "frombuffer", "Os", buffer, numpy_dtype);
+    else if (numpy_missing) {
+        PyObject* view = PyMemoryView_FromObject(buffer);
+        if (view) {
+            array = PyObject_CallMethod(view, "cast", "s", fmt);
+            Py_DECREF(view);
+        }
+    }
+
+    Py_DECREF(buffer);
+    return array;
+}
+
+static PyObject* _export_arrays(dictObj* self, PyObject* args, PyObject* kwds, bool with_keys, bool with_vals) {
+    /*
+    Shared implementation of keys_array, values_array and items_arrays. The items are copied into freshly allocated
+    bytearrays with the GIL released, which are then wrapped (without copying) by _wrap_array.
+    */
+
+    static char* kwlist[] = {"threads", NULL};
+    int num_threads = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|i", kwlist, &num_threads))
+        return NULL;
+
+    if (num_threads < 1) {
+        PyErr_SetString(PyExc_ValueError, "threads must be positive");
+        return NULL;
+    }
+
+    _expire(self);
+    h_t* h = self->ht;
+    PyObject* keys_buf = with_keys ? PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) h->size * sizeof(k_t)) : NULL;
+    PyObject* vals_buf = with_vals ? PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) h->size * sizeof(v_t)) : NULL;
+
+    if ((with_keys && !keys_buf) || (with_vals && !vals_buf)) {
+        Py_XDECREF(keys_buf);
+        Py_XDECREF(vals_buf);
+        return NULL;
+    }
+
+    kbox_t* keys = keys_buf ? (kbox_t*) PyByteArray_AS_STRING(keys_buf) : NULL;
+    vbox_t* vals = vals_buf ? (vbox_t*) PyByteArray_AS_STRING(vals_buf) : NULL;
+
+    self->active_exports += 1;
+    if (h->ext)
+        h->ext->expire_holds += 1; // Lookups made meanwhile must not remove the items being exported.
+    Py_BEGIN_ALLOW_THREADS
+    _export(h, keys, vals, num_threads);
+    Py_END_ALLOW_THREADS
+    if (h->ext)
+        h->ext->expire_holds -= 1;
+    self->active_exports -= 1;
+
+    PyObject* keys_array = keys_buf ? _wrap_array(keys_buf, KEY_NUMPY, KEY_FORMAT) : NULL;
+    PyObject* vals_array = vals_buf ? _wrap_array(vals_buf, VAL_NUMPY, VAL_FORMAT) : NULL;
+
+    if ((with_keys && !keys_array) || (with_vals && !vals_array)) {
+        Py_XDECREF(keys_array);
+        Py_XDECREF(vals_array);
+        return NULL;
+    }
+
+    if (!with_vals)
+        return keys_array;
+    if (!with_keys)
+        return vals_array;
+
+    PyObject* result = PyTuple_Pack(2, keys_array, vals_array);
+    Py_DECREF(keys_array);
+    Py_DECREF(vals_array);
+    return result;
+}
+
+static PyObject* keys_array(dictObj* self, PyObject* args, PyObject* kwds) {
+    /*
+    Invoked for d.keys_array(threads=1). Returns all the keys, in iteration order, as a NumPy array of the key type, e.g.
+    int64 (or as a memoryview of format KEY_FORMAT, e.g. "q", if NumPy is not installed). Up to threads threads fill
+    the array on large tables.
+    */
+
+    return _export_arrays(self, args, kwds, true, false);
+}
+
+static PyObject* values_array(dictObj* self, PyObject* args, PyObject* kwds) {
+    /*
+    Invoked for d.values_array(threads=1). Same as keys_array for the values.
+    */
+
+    return _export_arrays(self, args, kwds, false, true);
+}
+
+static PyObject* items_arrays(dictObj* self, PyObject* args, PyObject* kwds) {
+    /*
+    Invoked for d.items_arrays(threads=1). Returns the (keys, values) pair of arrays, exported in a single pass so
+    that keys[i] maps to values[i].
+    */
+
+    return _export_arrays(self, args, kwds, true, true);
+}
+
+typedef struct {
+    PyObject_HEAD
+    dictObj* dict;
+    h_t* ht;
+    uint64_t version;
+    i_t iter_idx;
+    i_t iter_num;
+    i_t chunk_size;
+    bool holds;
+} chunkIterObj;
+
+static void chunk_iter_dealloc(chunkIterObj* self) {
+    _hold_expired(self->dict, &self->holds, false);
+    Py_XDECREF(self->dict);
+    PyObject_Del(self);
+}
+
+static PyObject* chunk_iternext(chunkIterObj* self) {
+    /*
+    Returns the next (keys, values) pair of arrays, holding at most chunk_size items copied straight from the bucket
+    arrays, starting after the last bucket of the previous chunk. Stops once every item has been returned.
+    */
+
+    if (self->dict->ht != self->ht || self->ht->version != self->version) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetString(PyExc_RuntimeError, "microdictionary changed size during iteration");
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    i_t n = MIN(self->chunk_size, h->size - self->iter_num);
+    if (n <= 0) {
+        _hold_expired(self->dict, &self->holds, false);
+        return NULL;
+    }
+
+    PyObject* keys_buf = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) n * sizeof(k_t));
+    PyObject* vals_buf = PyByteArray_FromStringAndSize(NULL, (Py_ssize_t) n * sizeof(v_t));
+    if (!keys_buf || !vals_buf) {
+        Py_XDECREF(keys_buf);
+        Py_XDECREF(vals_buf);
+        return NULL;
+    }
+
+    i_t written = mdict_export_from(h, &self->iter_idx, (kbox_t*) PyByteArray_AS_STRING(keys_buf), (vbox_t*) PyByteArray_AS_STRING(vals_buf), n);
+    self->iter_num += written;
+
+    if (written == 0 || (written < n && (PyByteArray_Resize(keys_buf, (Py_ssize_t) written * sizeof(k_t)) < 0 ||
+                                         PyByteArray_Resize(vals_buf, (Py_ssize_t) written * sizeof(v_t)) < 0))) {
+        Py_DECREF(keys_buf);
+        Py_DECREF(vals_buf);
+        return NULL;
+    }
+
+    PyObject* keys_array = _wrap_array(keys_buf, KEY_NUMPY, KEY_FORMAT);
+    PyObject* vals_array = _wrap_array(vals_buf, VAL_NUMPY, VAL_FORMAT);
+    PyObject* result = (keys_array && vals_array) ? PyTuple_Pack(2, keys_array, vals_array) : NULL;
+    Py_XDECREF(keys_array);
+    Py_XDECREF(vals_array);
+    return result;
+}
+
+static PyTypeObject MDICT_SYM(chunkIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " chunk iterator",
+    .tp_doc = "Iterator over (keys, values) array batches returned by dict.iter_chunks()",
+    .tp_basicsize = sizeof(chunkIterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) chunk_iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) chunk_iternext,
+};
+
+static PyObject* iter_chunks(dictObj* self, PyObject* args) {
+    /*
+    Invoked for d.iter_chunks(chunk_size). Returns a new iterator yielding the items as (keys_array, values_array)
+    batches of at most chunk_size items (see keys_array for the array types), so that a whole dictionary can be
+    streamed with a constant amount of extra memory. Each call returns an independent iterator.
+    */
+
+    Py_ssize_t chunk_size;
+
+    if (!PyArg_ParseTuple(args, "n", &chunk_size))
+        return NULL;
+
+    if (chunk_size < 1) {
+        PyErr_SetString(PyExc_ValueError, "chunk_size must be positive");
+        return NULL;
+    }
+
+    _expire(self);
+    chunkIterObj* it = PyObject_New(chunkIterObj, &MDICT_SYM(chunkIterType));
+    if (!it)
+        return NULL;
+
+    Py_INCREF(self);
+    it->dict = self;
+    it->ht = self->ht;
+    it->version = self->ht->version;
+    it->iter_idx = 0;
+    it->iter_num = 0;
+    it->chunk_size = (i_t) MIN(chunk_size, INT32_MAX);
+    it->holds = false;
+    _hold_expired(self, &it->holds, true);
+    return (PyObject*) it;
+}
+
+static PyObject* map(dictObj* self, PyObject* args) {
+    /*
+    Experimental status.
+    */
+
+    PyObject* list = NULL;
+    PyObject* func = NULL;
+    PyObject* output_list;
+
+    if (!PyArg_ParseTuple(args, "O|O", &list, &func))
+        return NULL;
+
+    if (!PyList_CheckExact(list)) {
+        return NULL;
+    }
+
+    Py_ssize_t size = PyList_Size(list);
+    output_list = PyList_New(size);
+    for (int i=0; i<size; ++i){
+        kbox_t key;
+        if (_parse_key(PyList_GET_ITEM(list, i), &key) == -1) {
+            PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+            continue;
+        }
+        int ret_idx;
+        vbox_t val = mdict_get_map(self->ht, key, &ret_idx);
+        if (ret_idx != self->ht->num_buckets) {
+            if (func == NULL)
+                PyList_SET_ITEM(output_list, i, _val_to_py(val));
+            else {
+                PyObject* result = PyObject_CallFunction(func, "N", _val_to_py(val));
+                if (result != NULL)
+                    PyList_SET_ITEM(output_list, i, result);                                        
+                else
+                    PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+            }
+        }
+        else
+            PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+    }
+
+    PyErr_Clear();
+    return output_list;
+}
+
+
+static PyMethodDef MDICT_SYM(methods)[] = {
+    // {"destroy", destroy_ht, METH_VARARGS, "destroys a hash table"},
+    {"pop", del, METH_O, "deletes a key-value pair and pops its value"},
+    {"get", (PyCFunction) get, METH_FASTCALL, "Returns the value of a key, or default (None if not given) if the key is absent"},
+    {"clear", (PyCFunction) clear, METH_FASTCALL, "clears the hashtable"},
+    {"get_keys", get_keys, METH_NOARGS, "returns a list of all keys"},
+    {"get_values", get_values, METH_NOARGS, "returns a list of all values"},
+    {"get_items", get_items, METH_NOARGS, "returns a list of all key-value pairs"},
+    {"to_Pydict", to_Pydict, METH_NOARGS, "returns a python dictionary created from the microdict"},
+    {"update", update, METH_O, "Updates the microdict with all key-value pairs within the given input: Either a Python dictionary or another microdict"},
+    {"values", get_value_iterator, METH_NOARGS, "Returns an iterator for iterating over values"},
+    {"items", get_item_iterator, METH_NOARGS, "Returns an iterator for iterating over items"},
+    {"copy", copy, METH_NOARGS, "Returns a deep copy of the hashtable"},
+    {"freeze", freeze, METH_NOARGS, "Converts the microdict into a compact read-only hashtable"},
+    {"set", (PyCFunction) set, METH_FASTCALL | METH_KEYWORDS, "Inserts a key-value pair, optionally expiring after ttl seconds"},
+    {"expire", expire, METH_NOARGS, "Removes all the expired items and returns how many were removed"},
+    {"is_frozen", is_frozen, METH_NOARGS, "Returns True if the microdict is frozen"},
+    {"stats", stats, METH_NOARGS, "Returns a dictionary of statistics about the hashtable layout, memory and probe lengths"},
+    {"__sizeof__", size_of, METH_NOARGS, "Returns the size of the microdict in bytes, hashtable arrays included"},
+    {"share", share, METH_VARARGS, "Publishes a read-only snapshot of the microdict into a named shared memory segment"},
+    {"get_many", get_many, METH_VARARGS, "Looks up a buffer of keys and writes their values into an output buffer"},
+    {"keys_array", (PyCFunction) keys_array, METH_VARARGS | METH_KEYWORDS, "Returns all the keys as a densely packed array"},
+    {"values_array", (PyCFunction) values_array, METH_VARARGS | METH_KEYWORDS, "Returns all the values as a densely packed array"},
+    {"items_arrays", (PyCFunction) items_arrays, METH_VARARGS | METH_KEYWORDS, "Returns all the keys and values as a pair of densely packed arrays"},
+    {"iter_chunks", iter_chunks, METH_VARARGS, "Returns an iterator over (keys, values) array batches of at most chunk_size items"},
+    // {"map", map, METH_VARARGS, "Updates the microdict with all key-value pairs within the given input: Either a Python dictionary or another microdict"},
+    {NULL, NULL, 0, NULL}
+};
+
+
+static PySequenceMethods MDICT_SYM(sequence) = {
+    _len_,                            /* sq_length */
+    0,                                  /* sq_concat */
+    0,                                  /* sq_repeat */
+    0,                                  /* sq_item */
+    0,                                  /* sq_slice */
+    0,                                  /* sq_ass_item */
+    0,                                  /* sq_ass_slice */
+    (objobjproc) _contains_,           /* sq_contains */
+};
+
+static PyMappingMethods MDICT_SYM(mapping) = {
+    0, /*mp_length*/
+    (binaryfunc)mapping_get, /*mp_subscript*/
+    (objobjargproc)mapping_set, /*mp_ass_subscript*/
+};
+
+
+static PyTypeObject MDICT_SYM(dictType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME "",
+    .tp_doc = KEY_NAME "->" VAL_NAME " microdictionary",
+    .tp_basicsize = sizeof(dictObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = custom_new,
+    .tp_init = (initproc) custom_init,
+    .tp_dealloc = (destructor) custom_dealloc,
+    .tp_methods = MDICT_SYM(methods),
+    .tp_as_sequence = &MDICT_SYM(sequence),
+    .tp_as_mapping = &MDICT_SYM(mapping),
+    .tp_iter = (getiterfunc) mdict_iter,
+};
+
+
+
+static PyObject* update(dictObj* self, PyObject* dict) {
+    /*
+    Invoked when dict.update() is called. It takes an argument which must be either a Python dictionary or a microdictionary
+    of the same type. It adds all the items from the argument dictionary given to its hashtable. See _update_from_Pydict and
+    _update_from_mdict for further documentation.
+    */
+
+    bool is_pydict;
+    h_t* h = self->ht;
+
+    if (_check_mutable(self) == -1)
+        return NULL;
+
+    if (!PyDict_Check(dict)) {
+        is_pydict = false;
+        if (PyObject_IsInstance(dict, (PyObject *) &MDICT_SYM(dictType)) != 1) {
+            PyErr_SetString(PyExc_TypeError, "Argument needs to be either a (" KEY_DESC " key, " VAL_DESC " value) Int microdictionary or (" KEY_DESC " key, " VAL_DESC " value) Int Python dictionary");
+            return NULL;
+        }
+ 
+    } else
+        is_pydict = true;
+
+    if (is_pydict) {
+        if (_update_from_Pydict(self, dict) == -1)
+            return NULL;
+    } else {
+        if (_update_from_mdict(self, (dictObj*) dict) == -1)
+            return NULL;
+    }
+
+    PyErr_Clear();
+    return Py_BuildValue("");
+}
+
+
+static PyObject* attach(PyObject* module, PyObject* args) {
+    /*
+    Called by mdict.attach. Returns a new frozen microdictionary backed by the POSIX shared memory segment called name,
+    which must have been published by dict.share from a dictionary of the same type. The segment is mapped read-only
+    and unmapped when the returned dictionary is deleted.
+    */
+
+    const char* name;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    h_t* h = mdict_shm_attach(name);
+    if (!h) {
+        if (errno == EPROTOTYPE)
+            PyErr_SetString(PyExc_TypeError, "The shared memory segment holds a microdictionary of a different type");
+        else if (errno == EINVAL)
+            PyErr_SetString(PyExc_ValueError, "The shared memory segment does not hold a published microdictionary");
+        else
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+        return NULL;
+    }
+
+    dictObj* obj = (dictObj *) PyObject_CallObject((PyObject *) &MDICT_SYM(dictType), NULL);
+    if (!obj) {
+        mdict_delete_ht(h);
+        return NULL;
+    }
+
+    _destroy(obj);
+    obj->ht = h;
+    obj->valid_ht = true;
+    return (PyObject*) obj;
+}
+
+static PyObject* unlink_segment(PyObject* module, PyObject* args) {
+    /*
+    Called by mdict.unlink. Removes the name of a shared memory segment published by dict.share. Dictionaries already
+    attached to it keep working until they are deleted.
+    */
+
+    const char* name;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    if (mdict_shm_unlink(name) < 0)
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+
+    return Py_BuildValue("");
+}
+
+
+/*
+    Sharded microdictionary (see mdict_sharded.h) created by mdict.create(dtype, shards=N). Every shard is protected by
+    its own lock, and the bulk methods set_many and get_many release the GIL while they work, so that several threads
+    can insert and look up in parallel. No Python object is created while a shard lock is held : the methods that
+    walk all the items (iteration, to_Pydict, copy, ...) first copy them out of the shards, one shard at a time.
+*/
+
+typedef struct {
+    PyObject_HEAD
+    sh_t* st;
+    PyThread_type_lock* locks;
+    i_t next_shard;
+} shardedObj;
+
+typedef struct
+{
+    PyObject_HEAD
+    kbox_t* keys;       // NULL when iterating over the values only
+    vbox_t* vals;       // NULL when iterating over the keys only
+    i_t num_items;
+    i_t iter_idx;
+} shardedIterObj;
+
+
+static void sharded_iter_dealloc(shardedIterObj* self);
+static PyObject* sharded_iternext(shardedIterObj* self);
+
+
+static PyTypeObject MDICT_SYM(shardedIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " sharded iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(shardedIterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) sharded_iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) sharded_iternext,
+};
+
+
+static void _lock_shard(shardedObj* self, i_t i) {
+    /*
+    Acquires the lock of shard i while holding the GIL. The GIL is only dropped when the lock is contended.
+    */
+
+    if (!PyThread_acquire_lock(self->locks[i], NOWAIT_LOCK)) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->locks[i], WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static void sharded_dealloc(shardedObj* self) {
+    /*
+    The destructor
+    */
+
+    if (self->locks) {
+        for (i_t i=0; i<self->st->num_shards; ++i) {
+            if (self->locks[i])
+                PyThread_free_lock(self->locks[i]);
+        }
+        MDICT_FREE(self->locks);
+    }
+
+    mdict_sharded_delete(self->st);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int sharded_init(shardedObj* self, PyObject *args) {
+    /*
+    Constructor. Takes the number of shards, which gets rounded up to a power of 2.
+    */
+
+    int num_shards;
+
+    if (!PyArg_ParseTuple(args, "i", &num_shards))
+        return -1;
+
+    if (num_shards < 1 || num_shards > SHARDS_MAX) {
+        char msg[50];
+        sprintf(msg, "shards must be in between 1 and %d", SHARDS_MAX);
+        PyErr_SetString(PyExc_ValueError, msg);
+        return -1;
+    }
+
+    if (self->st) {
+        PyErr_SetString(PyExc_TypeError, "The sharded microdictionary is already initialized");
+        return -1;
+    }
+
+    self->st = mdict_sharded_create(NULL, num_shards);
+    if (!self->st) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the shards");
+        return -1;
+    }
+
+    self->locks = (PyThread_type_lock*) MDICT_CALLOC(self->st->num_shards, sizeof(PyThread_type_lock));
+    if (!self->locks) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the shard locks");
+        return -1;
+    }
+
+    for (i_t i=0; i<self->st->num_shards; ++i) {
+        self->locks[i] = PyThread_allocate_lock();
+        if (!self->locks[i]) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the shard locks");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static bool _sharded_lookup(shardedObj* self, kbox_t k, vbox_t* v) {
+    /*
+    Looks k up in its shard, under the shard lock. Returns true and sets *v to its value if k is present.
+    */
+
+    i_t idx, s = mdict_shard_of(self->st, k);
+    _lock_shard(self, s);
+    h_t* h = self->st->shards[s]; // Read under the lock, clear may replace it.
+    *v = mdict_get_map(h, k, &idx);
+    bool found = idx != h->num_buckets;
+    PyThread_release_lock(self->locks[s]);
+
+    return found;
+}
+
+static PyObject* sharded_get(shardedObj* self, PyObject* key) {
+    /*
+    Invoked for d[k]. Returns None if k is not present.
+    */
+
+    kbox_t k; vbox_t v;
+
+    if (_parse_key(key, &k) == -1)
+        return NULL;
+
+    if (_sharded_lookup(self, k, &v))
+        return _val_to_py(v);
+    return Py_BuildValue("");
+}
+
+static PyObject* sharded_get_default(shardedObj* self, PyObject* const* args, Py_ssize_t nargs) {
+    /*
+    Invoked for d.get(key, default=None). Returns the value of key if present and default otherwise.
+    */
+
+    kbox_t k; vbox_t v;
+    PyObject* params[2] = {NULL, Py_None};
+
+    if (_fastcall_args("get", args, nargs, NULL, NULL, 1, 2, params) == -1 || _parse_key(params[0], &k) == -1)
+        return NULL;
+
+    if (_sharded_lookup(self, k, &v))
+        return _val_to_py(v);
+
+    Py_INCREF(params[1]);
+    return params[1];
+}
+
+static int sharded_set(shardedObj* self, PyObject* key, PyObject* val) {
+    /*
+    Invoked for d[k] = v and del d[k].
+    */
+
+    kbox_t k; vbox_t v; int ret_val;
+
+    if (_parse_key(key, &k) == -1)
+        return -1;
+
+    if (val != NULL && _parse_val(val, &v) == -1)
+        return -1;
+
+    i_t s = mdict_shard_of(self->st, k);
+    _lock_shard(self, s);
+    if (val != NULL)
+        ret_val = mdict_set(self->st->shards[s], k, v);
+    else
+        ret_val = mdict_del_map(self->st->shards[s], k, NULL);
+    PyThread_release_lock(self->locks[s]);
+
+    if (ret_val == -1) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to resize the hashtable");
+        return -1;
+    }
+    if (ret_val == -2 && val == NULL) {
+        _key_error(k);
+        return -1;
+    }
+
+    return 0;
+}
+
+static int sharded_contains(shardedObj* self, PyObject* key) {
+    /*
+    Invoked for 'k in d'.
+    */
+
+    kbox_t k; vbox_t v;
+
+    if (_parse_key(key, &k) == -1)
+        return -1;
+
+    return _sharded_lookup(self, k, &v);
+}
+
+static Py_ssize_t sharded_len(shardedObj* self) {
+    /*
+    Returns the total number of items over all the shards.
+    */
+
+    return mdict_sharded_size(self->st);
+}
+
+static PyObject* sharded_del(shardedObj* self, PyObject* key) {
+    /*
+    Invoked for d.pop(k). Raises a KeyError if k is not present.
+    */
+
+    kbox_t k; vbox_t v; int ret_val;
+
+    if (_parse_key(key, &k) == -1)
+        return NULL;
+
+    i_t s = mdict_shard_of(self->st, k);
+    _lock_shard(self, s);
+    ret_val = mdict_del_map(self->st->shards[s], k, &v);
+    PyThread_release_lock(self->locks[s]);
+
+    if (ret_val == -2) {
+        _key_error(k);
+        return NULL;
+    }
+
+    return _val_to_py(v);
+}
+
+static int _sharded_bulk(shardedObj* self, kbox_t* keys, vbox_t* vals, int64_t n, bool is_set, vbox_t default_val, i_t first_shard, int64_t* num_found) {
+    /*
+    Runs without holding the GIL. Groups the keys by shard and visits every shard once, starting from first_shard so
+    that concurrent calls start on different shards. If is_set, inserts keys[i] -> vals[i]. Otherwise, writes the value
+    of keys[i] (or default_val if absent) into vals[i] and counts the keys found in num_found.
+    Returns -1 if an allocation fails.
+    */
+
+    sh_t* st = self->st;
+    int64_t* order = (int64_t*) MDICT_MALLOC(MAX(n, 1) * sizeof(int64_t));
+    int64_t* shard_start = (int64_t*) MDICT_MALLOC((st->num_shards + 1) * sizeof(int64_t));
+    int ret_val = 0;
+
+    if (!order || !shard_start || mdict_sharded_partition(st, keys, n, order, shard_start) < 0) {
+        MDICT_FREE(order);
+        MDICT_FREE(shard_start);
+        return -1;
+    }
+
+    *num_found = 0;
+    for (i_t c=0; c<st->num_shards && ret_val == 0; ++c) {
+        i_t s = (first_shard + c) & (st->num_shards - 1);
+        if (shard_start[s] == shard_start[s+1])
+            continue;
+
+        PyThread_acquire_lock(self->locks[s], WAIT_LOCK);
+        h_t* h = st->shards[s];
+        for (int64_t j=shard_start[s]; j<shard_start[s+1]; ++j) {
+            int64_t i = order[j];
+            if (is_set) {
+                if (mdict_set(h, keys[i], vals[i]) == -1) {
+                    ret_val = -1;
+                    break;
+                }
+            } else {
+                i_t idx;
+                vbox_t v = mdict_get_map(h, keys[i], &idx);
+                if (idx != h->num_buckets) {
+                    vals[i] = v;
+                    *num_found += 1;
+                } else
+                    vals[i] = default_val;
+            }
+        }
+        PyThread_release_lock(self->locks[s]);
+    }
+
+    MDICT_FREE(order);
+    MDICT_FREE(shard_start);
+    return ret_val;
+}
+
+static PyObject* sharded_set_many(shardedObj* self, PyObject* args) {
+    /*
+    Invoked for d.set_many(keys, values). keys and values must be contiguous buffers of integers of the key and value
+    types (e.g. NumPy arrays or array.array objects) of the same length. The GIL is released while the items are inserted.
+    */
+
+    PyObject *keys_obj, *vals_obj;
+    Py_buffer kb, vb;
+    int64_t num_found;
+    int ret_val;
+
+    if (!PyArg_ParseTuple(args, "OO", &keys_obj, &vals_obj))
+        return NULL;
+
+    if (_get_int_buffer(keys_obj, &kb, sizeof(k_t), KEY_IS_SIGNED, false, "keys") < 0)
+        return NULL;
+
+    if (_get_int_buffer(vals_obj, &vb, sizeof(v_t), VAL_IS_SIGNED, false, "values") < 0) {
+        PyBuffer_Release(&kb);
+        return NULL;
+    }
+
+    if (kb.len / kb.itemsize != vb.len / vb.itemsize) {
+        PyErr_SetString(PyExc_ValueError, "keys and values must have the same length");
+        PyBuffer_Release(&kb);
+        PyBuffer_Release(&vb);
+        return NULL;
+    }
+
+    i_t first_shard = self->next_shard++;
+    Py_BEGIN_ALLOW_THREADS
+    ret_val = _sharded_bulk(self, (kbox_t*) kb.buf, (vbox_t*) vb.buf, kb.len / kb.itemsize, true, 0, first_shard, &num_found);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&kb);
+    PyBuffer_Release(&vb);
+
+    if (ret_val < 0) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert all the items");
+        return NULL;
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* sharded_get_many(shardedObj* self, PyObject* args) {
+    /*
+    Invoked for d.get_many(keys, out, default=0). keys must be a contiguous buffer of integers of the key type and out
+    a writable one of integers of the value type, of the same length. out[i] receives the value of keys[i], or default
+    if keys[i] is absent. Returns the number of keys found. The GIL is released during the lookups.
+    */
+
+    PyObject *keys_obj, *out_obj, *default_obj = NULL;
+    Py_buffer kb, ob;
+    vbox_t default_val = 0;
+    int64_t num_found;
+    int ret_val;
+
+    if (!PyArg_ParseTuple(args, "OO|O", &keys_obj, &out_obj, &default_obj))
+        return NULL;
+
+    if (default_obj && _parse_val(default_obj, &default_val) == -1)
+        return NULL;
+
+    if (_get_int_buffer(keys_obj, &kb, sizeof(k_t), KEY_IS_SIGNED, false, "keys") < 0)
+        return NULL;
+
+    if (_get_int_buffer(out_obj, &ob, sizeof(v_t), VAL_IS_SIGNED, true, "out") < 0) {
+        PyBuffer_Release(&kb);
+        return NULL;
+    }
+
+    if (kb.len / kb.itemsize != ob.len / ob.itemsize) {
+        PyErr_SetString(PyExc_ValueError, "keys and out must have the same length");
+        PyBuffer_Release(&kb);
+        PyBuffer_Release(&ob);
+        return NULL;
+    }
+
+    i_t first_shard = self->next_shard++;
+    Py_BEGIN_ALLOW_THREADS
+    ret_val = _sharded_bulk(self, (kbox_t*) kb.buf, (vbox_t*) ob.buf, kb.len / kb.itemsize, false, default_val, first_shard, &num_found);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&kb);
+    PyBuffer_Release(&ob);
+
+    if (ret_val < 0) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the scratch arrays");
+        return NULL;
+    }
+
+    return PyLong_FromLongLong(num_found);
+}
+
+static i_t _sharded_snapshot(shardedObj* self, kbox_t** keys, vbox_t** vals) {
+    /*
+    Copies the items of all the shards into newly allocated arrays, the keys into *keys unless keys is NULL and the
+    values into *vals unless vals is NULL, and returns their number. Each shard is copied under its lock, one at a
+    time, so that the Python objects can then be created without holding any shard lock. The arrays are freed with
+    MDICT_FREE (they are left NULL if there are no items). Returns -1 if an allocation fails.
+    */
+
+    sh_t* st = self->st;
+    kbox_t* k_out = NULL;
+    vbox_t* v_out = NULL;
+    i_t n = 0, cap = 0;
+
+    for (i_t s=0; s<st->num_shards; ++s) {
+        _lock_shard(self, s);
+        h_t* h = st->shards[s];
+        if (n + h->size > cap) {
+            cap = MAX(n + h->size, 2 * cap);
+            kbox_t* k_new = keys ? (kbox_t*) MDICT_REALLOC(k_out, cap * sizeof(kbox_t)) : NULL;
+            if (k_new)
+                k_out = k_new;
+            vbox_t* v_new = vals ? (vbox_t*) MDICT_REALLOC(v_out, cap * sizeof(vbox_t)) : NULL;
+            if (v_new)
+                v_out = v_new;
+            if ((keys && !k_new) || (vals && !v_new)) {
+                PyThread_release_lock(self->locks[s]);
+                MDICT_FREE(k_out);
+                MDICT_FREE(v_out);
+                return -1;
+            }
+        }
+        n += mdict_export_words(h, 0, _flags_size(h->num_buckets), k_out ? k_out + n : NULL, v_out ? v_out + n : NULL, h->size);
+        PyThread_release_lock(self->locks[s]);
+    }
+
+    if (keys)
+        *keys = k_out;
+    if (vals)
+        *vals = v_out;
+    return n;
+}
+
+static PyObject* sharded_to_Pydict(shardedObj* self) {
+    /*
+    Returns a newly created python dictionary containing all the items of all the shards.
+    */
+
+    kbox_t* keys; vbox_t* vals;
+    i_t n = _sharded_snapshot(self, &keys, &vals);
+    if (n < 0)
+        return PyErr_NoMemory();
+
+    PyObject* dict = PyDict_New();
+    if (!dict) {
+        MDICT_FREE(keys);
+        MDICT_FREE(vals);
+        PyErr_SetString(PyExc_MemoryError, "Could not allocate the Python Dictionary object");
+        return NULL;
+    }
+
+    for (i_t i=0; i<n; ++i) {
+        PyObject* key_obj = _key_to_py(keys[i]);
+        PyObject* val_obj = _val_to_py(vals[i]);
+        int ret_val = (!key_obj || !val_obj) ? -1 : PyDict_SetItem(dict, key_obj, val_obj);
+        Py_XDECREF(key_obj);
+        Py_XDECREF(val_obj);
+        if (ret_val == -1) {
+            Py_CLEAR(dict);
+            break;
+        }
+    }
+
+    MDICT_FREE(keys);
+    MDICT_FREE(vals);
+    return dict;
+}
+
+static PyObject* _sharded_new_iter(shardedObj* self, bool with_keys, bool with_vals) {
+    /*
+    Returns a new iterator over the keys, the values or the (key, value) items. The iterator walks a snapshot of the
+    items taken when it is created, so that other threads may keep modifying the shards meanwhile.
+    */
+
+    shardedIterObj* it = PyObject_New(shardedIterObj, &MDICT_SYM(shardedIterType));
+    if (!it)
+        return NULL;
+
+    it->keys = NULL;
+    it->vals = NULL;
+    it->iter_idx = 0;
+    it->num_items = _sharded_snapshot(self, with_keys ? &it->keys : NULL, with_vals ? &it->vals : NULL);
+    if (it->num_items < 0) {
+        it->num_items = 0;
+        Py_DECREF(it);
+        return PyErr_NoMemory();
+    }
+    return (PyObject*) it;
+}
+
+static void sharded_iter_dealloc(shardedIterObj* self) {
+    MDICT_FREE(self->keys);
+    MDICT_FREE(self->vals);
+    PyObject_Del(self);
+}
+
+static PyObject* sharded_iternext(shardedIterObj* self) {
+    /*
+    Returns the next key, value or (key, value) item of the snapshot.
+    */
+
+    if (self->iter_idx >= self->num_items) {
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+
+    i_t i = self->iter_idx++;
+    if (!self->vals)
+        return _key_to_py(self->keys[i]);
+    if (!self->keys)
+        return _val_to_py(self->vals[i]);
+    return Py_BuildValue("(NN)", _key_to_py(self->keys[i]), _val_to_py(self->vals[i]));
+}
+
+static PyObject* sharded_iter(shardedObj* self) {
+    /*
+    Invoked for iter(d) and d.keys(). Returns a new iterator over the keys.
+    */
+
+    return _sharded_new_iter(self, true, false);
+}
+
+static PyObject* sharded_value_iterator(shardedObj* self) {
+    /*
+    Invoked for d.values(). Returns a new iterator over the values.
+    */
+
+    return _sharded_new_iter(self, false, true);
+}
+
+static PyObject* sharded_item_iterator(shardedObj* self) {
+    /*
+    Invoked for d.items(). Returns a new iterator over the (key, value) items.
+    */
+
+    return _sharded_new_iter(self, true, true);
+}
+
+static PyObject* sharded_get_keys(shardedObj* self) {
+    /*
+    Invoked for d.get_keys(). Returns a list of all the keys.
+    */
+
+    PyObject* it = _sharded_new_iter(self, true, false);
+    if (!it)
+        return NULL;
+    PyObject* list = PySequence_List(it);
+    Py_DECREF(it);
+    return list;
+}
+
+static PyObject* sharded_get_values(shardedObj* self) {
+    /*
+    Invoked for d.get_values(). Returns a list of all the values.
+    */
+
+    PyObject* it = _sharded_new_iter(self, false, true);
+    if (!it)
+        return NULL;
+    PyObject* list = PySequence_List(it);
+    Py_DECREF(it);
+    return list;
+}
+
+static PyObject* sharded_get_items(shardedObj* self) {
+    /*
+    Invoked for d.get_items(). Returns a list of all the (key, value) items.
+    */
+
+    PyObject* it = _sharded_new_iter(self, true, true);
+    if (!it)
+        return NULL;
+    PyObject* list = PySequence_List(it);
+    Py_DECREF(it);
+    return list;
+}
+
+static PyObject* sharded_clear(shardedObj* self, PyObject* const* args, Py_ssize_t nargs) {
+    /*
+    Invoked for d.clear(keys=None). Deletes the keys of the given list (skipping the absent ones), or all the items if
+    no list is given, in which case every shard is replaced by a new empty hashtable.
+    */
+
+    PyObject* list = NULL;
+    kbox_t k;
+
+    if (_fastcall_args("clear", args, nargs, NULL, NULL, 0, 1, &list) == -1)
+        return NULL;
+
+    if (list) {
+        if (!PyList_CheckExact(list)) {
+            PyErr_SetString(PyExc_TypeError, "The first optional argument must be a list");
+            return NULL;
+        }
+
+        for (Py_ssize_t j=0; j<PyList_GET_SIZE(list); ++j) {
+            if (_parse_key(PyList_GET_ITEM(list, j), &k) == -1)
+                return NULL;
+            i_t s = mdict_shard_of(self->st, k);
+            _lock_shard(self, s);
+            mdict_del_map(self->st->shards[s], k, NULL);
+            PyThread_release_lock(self->locks[s]);
+        }
+        return Py_BuildValue("");
+    }
+
+    for (i_t s=0; s<self->st->num_shards; ++s) {
+        h_t* fresh = mdict_create(NULL);
+        if (!fresh)
+            return PyErr_NoMemory();
+
+        _lock_shard(self, s);
+        h_t* old = self->st->shards[s];
+        self->st->shards[s] = fresh;
+        PyThread_release_lock(self->locks[s]);
+        mdict_delete_ht(old);
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* sharded_update(shardedObj* self, PyObject* other);
+
+static PyObject* sharded_copy(shardedObj* self) {
+    /*
+    Invoked for d.copy(). Returns a new sharded microdictionary with the same number of shards and all the items.
+    */
+
+    PyObject* new_obj = PyObject_CallFunction((PyObject*) Py_TYPE(self), "i", (int) self->st->num_shards);
+    if (!new_obj)
+        return NULL;
+
+    PyObject* ret_val = sharded_update((shardedObj*) new_obj, (PyObject*) self);
+    if (!ret_val) {
+        Py_DECREF(new_obj);
+        return NULL;
+    }
+
+    Py_DECREF(ret_val);
+    return new_obj;
+}
+
+static PyObject* num_shards(shardedObj* self) {
+    /*
+    Returns the number of shards.
+    */
+
+    return PyLong_FromLong(self->st->num_shards);
+}
+
+
+static PyObject* sharded_size_of(shardedObj* self) {
+    /*
+    Invoked by sys.getsizeof. Returns the size of the shardedObj plus the shard table, the locks and every shard.
+    */
+
+    size_t size = Py_TYPE(self)->tp_basicsize + sizeof(sh_t) + self->st->num_shards * (sizeof(h_t*) + sizeof(PyThread_type_lock));
+    for (i_t s=0; s<self->st->num_shards; ++s)
+        size += mdict_sizeof(self->st->shards[s]);
+    return PyLong_FromSize_t(size);
+}
+
+
+static PyMethodDef MDICT_SYM(sharded_methods)[] = {
+    {"pop", sharded_del, METH_O, "deletes a key-value pair and pops its value"},
+    {"get", (PyCFunction) sharded_get_default, METH_FASTCALL, "Returns the value of a key, or default (None if not given) if the key is absent"},
+    {"clear", (PyCFunction) sharded_clear, METH_FASTCALL, "Deletes the keys of the given list, or all the items"},
+    {"update", (PyCFunction) sharded_update, METH_O, "Inserts all the items of a Python dictionary, a microdict or a sharded microdict of the same type"},
+    {"keys", (PyCFunction) sharded_iter, METH_NOARGS, "Returns an iterator over a snapshot of the keys"},
+    {"values", (PyCFunction) sharded_value_iterator, METH_NOARGS, "Returns an iterator over a snapshot of the values"},
+    {"items", (PyCFunction) sharded_item_iterator, METH_NOARGS, "Returns an iterator over a snapshot of the items"},
+    {"get_keys", (PyCFunction) sharded_get_keys, METH_NOARGS, "returns a list of all keys"},
+    {"get_values", (PyCFunction) sharded_get_values, METH_NOARGS, "returns a list of all values"},
+    {"get_items", (PyCFunction) sharded_get_items, METH_NOARGS, "returns a list of all key-value pairs"},
+    {"copy", (PyCFunction) sharded_copy, METH_NOARGS, "Returns a deep copy of the sharded microdict"},
+    {"set_many", sharded_set_many, METH_VARARGS, "Inserts all keys[i] -> values[i] pairs from two integer buffers, releasing the GIL"},
+    {"get_many", sharded_get_many, METH_VARARGS, "Looks up all keys of an integer buffer into an output buffer, releasing the GIL"},
+    {"to_Pydict", sharded_to_Pydict, METH_NOARGS, "returns a python dictionary created from the microdict"},
+    {"num_shards", num_shards, METH_NOARGS, "Returns the number of shards"},
+    {"__sizeof__", sharded_size_of, METH_NOARGS, "Returns the size of the microdict in bytes, shards included"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PySequenceMethods MDICT_SYM(sharded_sequence) = {
+    (lenfunc) sharded_len,              /* sq_length */
+    0,                                  /* sq_concat */
+    0,                                  /* sq_repeat */
+    0,                                  /* sq_item */
+    0,                                  /* sq_slice */
+    0,                                  /* sq_ass_item */
+    0,                                  /* sq_ass_slice */
+    (objobjproc) sharded_contains,      /* sq_contains */
+};
+
+static PyMappingMethods MDICT_SYM(sharded_mapping) = {
+    0, /*mp_length*/
+    (binaryfunc)sharded_get, /*mp_subscript*/
+    (objobjargproc)sharded_set, /*mp_ass_subscript*/
+};
+
+static PyTypeObject MDICT_SYM(shardedType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " sharded",
+    .tp_doc = KEY_NAME "->" VAL_NAME " sharded microdictionary",
+    .tp_basicsize = sizeof(shardedObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) sharded_init,
+    .tp_dealloc = (destructor) sharded_dealloc,
+    .tp_methods = MDICT_SYM(sharded_methods),
+    .tp_as_sequence = &MDICT_SYM(sharded_sequence),
+    .tp_as_mapping = &MDICT_SYM(sharded_mapping),
+    .tp_iter = (getiterfunc) sharded_iter,
+};
+
+
+static PyObject* sharded_update(shardedObj* self, PyObject* other) {
+    /*
+    Invoked for d.update(other), where other is a Python dictionary, a microdictionary or a sharded microdictionary of
+    the same type. The items of other are first copied into arrays, which are then inserted shard by shard with the GIL
+    released, as by set_many.
+    */
+
+    kbox_t* keys = NULL;
+    vbox_t* vals = NULL;
+    int64_t n = 0, num_found;
+    int ret_val;
+
+    if (PyDict_Check(other)) {
+        PyObject *key_obj, *val_obj;
+        Py_ssize_t pos = 0;
+        keys = (kbox_t*) MDICT_MALLOC(MAX(PyDict_Size(other), 1) * sizeof(kbox_t));
+        vals = (vbox_t*) MDICT_MALLOC(MAX(PyDict_Size(other), 1) * sizeof(vbox_t));
+        if (!keys || !vals) {
+            MDICT_FREE(keys);
+            MDICT_FREE(vals);
+            return PyErr_NoMemory();
+        }
+
+        while (PyDict_Next(other, &pos, &key_obj, &val_obj)) {
+            if (_parse_key(key_obj, &keys[n]) == -1 || _parse_val(val_obj, &vals[n]) == -1) {
+                MDICT_FREE(keys);
+                MDICT_FREE(vals);
+                return NULL;
+            }
+            n += 1;
+        }
+    } else if (PyObject_IsInstance(other, (PyObject *) &MDICT_SYM(shardedType)) == 1) {
+        n = _sharded_snapshot((shardedObj*) other, &keys, &vals);
+        if (n < 0)
+            return PyErr_NoMemory();
+    } else if (PyObject_IsInstance(other, (PyObject *) &MDICT_SYM(dictType)) == 1) {
+        dictObj* d = (dictObj*) other;
+        _expire(d);
+        h_t* h = d->ht;
+        keys = (kbox_t*) MDICT_MALLOC(MAX(h->size, 1) * sizeof(kbox_t));
+        vals = (vbox_t*) MDICT_MALLOC(MAX(h->size, 1) * sizeof(vbox_t));
+        if (!keys || !vals) {
+            MDICT_FREE(keys);
+            MDICT_FREE(vals);
+            return PyErr_NoMemory();
+        }
+        n = mdict_export_words(h, 0, _flags_size(h->num_buckets), keys, vals, h->size);
+    } else {
+        PyErr_SetString(PyExc_TypeError, "Argument needs to be either a (" KEY_DESC " key, " VAL_DESC " value) Int microdictionary, sharded or not, or (" KEY_DESC " key, " VAL_DESC " value) Int Python dictionary");
+        return NULL;
+    }
+
+    i_t first_shard = self->next_shard++;
+    Py_BEGIN_ALLOW_THREADS
+    ret_val = _sharded_bulk(self, keys, vals, n, true, 0, first_shard, &num_found);
+    Py_END_ALLOW_THREADS
+
+    MDICT_FREE(keys);
+    MDICT_FREE(vals);
+
+    if (ret_val < 0) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert all the items");
+        return NULL;
+    }
+
+    return Py_BuildValue("");
+}
+
+
+#if dtype_key == 1 && dtype_val == 1
+
+/*
+    Lock-free microdictionary (see int32_int32_lockfree.h) created by mdict.create_lockfree(capacity). From python it
+    behaves like a small insert-only mapping; its main purpose is to hand the underlying lf_t table to native threads
+    through the capsule returned by its capsule() method.
+*/
+
+typedef struct {
+    PyObject_HEAD
+    lf_t* t;
+} lockfreeObj;
+
+
+static void lockfree_dealloc(lockfreeObj* self) {
+    /*
+    The destructor
+    */
+
+    mdict_lf_delete(self->t);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static int lockfree_init(lockfreeObj* self, PyObject *args) {
+    /*
+    Constructor. Takes the number of keys the table must hold without resizing.
+    */
+
+    long long capacity;
+
+    if (!PyArg_ParseTuple(args, "L", &capacity))
+        return -1;
+
+    if (capacity < 1) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be positive");
+        return -1;
+    }
+
+    if (self->t) {
+        PyErr_SetString(PyExc_TypeError, "The lock-free microdictionary is already initialized");
+        return -1;
+    }
+
+    self->t = mdict_lf_create(capacity);
+    if (!self->t) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the hashtable");
+        return -1;
+    }
+
+    return 0;
+}
+
+static int _lockfree_check(int ret_val) {
+    /*
+    Converts the error codes of mdict_lf_set and mdict_lf_add into python exceptions.
+    */
+
+    if (ret_val == -1) {
+        PyErr_SetString(PyExc_MemoryError, "The lock-free microdictionary is full : call reserve() with a larger capacity");
+        return -1;
+    }
+    if (ret_val == -2) {
+        PyErr_SetString(PyExc_KeyError, "-2147483648 is reserved as the empty key of the lock-free microdictionary");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject* lockfree_get(lockfreeObj* self, PyObject* key) {
+    /*
+    Invoked for d[k]. Returns None if k is not present.
+    */
+
+    kbox_t k; vbox_t v;
+
+    if (_parse_key(key, &k) == -1)
+        return NULL;
+
+    if (mdict_lf_get(self->t, k, &v))
+        return PyLong_FromLong((long) v);
+    return Py_BuildValue("");
+}
+
+static int lockfree_set(lockfreeObj* self, PyObject* key, PyObject* val) {
+    /*
+    Invoked for d[k] = v. Items can not be deleted.
+    */
+
+    kbox_t k; vbox_t v;
+
+    if (val == NULL) {
+        PyErr_SetString(PyExc_TypeError, "Items can not be deleted from a lock-free microdictionary");
+        return -1;
+    }
+
+    if (_parse_key(key, &k) == -1 || _parse_val(val, &v) == -1)
+        return -1;
+
+    return _lockfree_check(mdict_lf_set(self->t, k, v));
+}
+
+static int lockfree_contains(lockfreeObj* self, PyObject* key) {
+    /*
+    Invoked for 'k in d'.
+    */
+
+    kbox_t k; vbox_t v;
+
+    if (_parse_key(key, &k) == -1)
+        return -1;
+
+    return mdict_lf_get(self->t, k, &v);
+}
+
+static Py_ssize_t lockfree_len(lockfreeObj* self) {
+    return (Py_ssize_t) mdict_lf_size(self->t);
+}
+
+static PyObject* lockfree_add(lockfreeObj* self, PyObject* const* args, Py_ssize_t nargs) {
+    /*
+    Invoked for d.add(k, delta). Atomically adds delta to the value of k (inserting k with value delta if absent)
+    and returns the new value.
+    */
+
+    kbox_t k; vbox_t delta, new_val;
+    PyObject* params[2];
+
+    if (_fastcall_args("add", args, nargs, NULL, NULL, 2, 2, params) == -1 || _parse_key(params[0], &k) == -1 || _parse_val(params[1], &delta) == -1)
+        return NULL;
+
+    if (_lockfree_check(mdict_lf_add(self->t, k, delta, &new_val)) < 0)
+        return NULL;
+
+    return PyLong_FromLong((long) new_val);
+}
+
+static PyObject* lockfree_reserve(lockfreeObj* self, PyObject* arg) {
+    /*
+    Invoked for d.reserve(capacity). Blocking resize : no native thread may use the table during the call.
+    */
+
+    long long capacity = PyLong_AsLongLong(arg);
+
+    if (capacity == -1 && PyErr_Occurred())
+        return NULL;
+
+    if (mdict_lf_resize(self->t, capacity) < 0) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to resize the hashtable");
+        return NULL;
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* lockfree_capacity(lockfreeObj* self) {
+    /*
+    Returns the number of keys the table can hold before inserts start failing.
+    */
+
+    return PyLong_FromLongLong(self->t->max_size);
+}
+
+static PyObject* lockfree_capsule(lockfreeObj* self) {
+    /*
+    Returns a PyCapsule named "microdict.lockfree_i32_i32" holding the lf_t pointer, to be used by native code with
+    the functions of int32_int32_lockfree.h. The capsule does not own the table : keep the dictionary alive while
+    native threads use it.
+    */
+
+    return PyCapsule_New((void*) self->t, "microdict.lockfree_i32_i32", NULL);
+}
+
+
+static PyObject* lockfree_size_of(lockfreeObj* self) {
+    /*
+    Invoked by sys.getsizeof. Returns the size of the lockfreeObj plus the lf_t and its slots.
+    */
+
+    return PyLong_FromSize_t(Py_TYPE(self)->tp_basicsize + sizeof(lf_t) + self->t->num_buckets * sizeof(uint64_t));
+}
+
+
+static PyMethodDef lockfree_methods_i32_i32[] = {
+    {"add", (PyCFunction) lockfree_add, METH_FASTCALL, "Atomically adds delta to the value of a key and returns the new value"},
+    {"reserve", lockfree_reserve, METH_O, "Resizes the table to hold at least capacity keys (blocking)"},
+    {"capacity", lockfree_capacity, METH_NOARGS, "Returns the number of keys the table can hold"},
+    {"capsule", lockfree_capsule, METH_NOARGS, "Returns a PyCapsule holding the native lf_t table"},
+    {"__sizeof__", lockfree_size_of, METH_NOARGS, "Returns the size of the table in bytes, slots included"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PySequenceMethods lockfree_sequence_i32_i32 = {
+    (lenfunc) lockfree_len,             /* sq_length */
+    0,                                  /* sq_concat */
+    0,                                  /* sq_repeat */
+    0,                                  /* sq_item */
+    0,                                  /* sq_slice */
+    0,                                  /* sq_ass_item */
+    0,                                  /* sq_ass_slice */
+    (objobjproc) lockfree_contains,     /* sq_contains */
+};
+
+static PyMappingMethods lockfree_mapping_i32_i32 = {
+    0, /*mp_length*/
+    (binaryfunc)lockfree_get, /*mp_subscript*/
+    (objobjargproc)lockfree_set, /*mp_ass_subscript*/
+};
+
+static PyTypeObject lockfreeType_i32_i32 = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "i32->i32 lockfree",
+    .tp_doc = "int32->int32 lock-free microdictionary",
+    .tp_basicsize = sizeof(lockfreeObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = PyType_GenericNew,
+    .tp_init = (initproc) lockfree_init,
+    .tp_dealloc = (destructor) lockfree_dealloc,
+    .tp_methods = lockfree_methods_i32_i32,
+    .tp_as_sequence = &lockfree_sequence_i32_i32,
+    .tp_as_mapping = &lockfree_mapping_i32_i32,
+};
+#endif
+
+
+/*
+    C API exported through the _C_API capsule, see microdict_api.h. The functions do the work of d[k], d[k] = v, d.pop(k),
+    d.get_many and iteration on native keys and values, and expect the GIL to be held.
+*/
+
+static PyObject* api_create(void) {
+    return PyObject_CallObject((PyObject *) &MDICT_SYM(dictType), NULL);
+}
+
+static int api_get(PyObject* d, kbox_t key, vbox_t* val) {
+    h_t* h = ((dictObj*) d)->ht;
+    i_t idx;
+
+    vbox_t v = mdict_get_map(h, key, &idx);
+    if (idx == h->num_buckets)
+        return 0;
+    *val = v;
+    return 1;
+}
+
+static int api_set(PyObject* d, kbox_t key, vbox_t val) {
+    dictObj* self = (dictObj*) d;
+
+    if (_check_mutable(self) == -1)
+        return -1;
+    return _set_item(self, key, val);
+}
+
+static int api_del(PyObject* d, kbox_t key, vbox_t* val) {
+    dictObj* self = (dictObj*) d;
+    vbox_t v;
+
+    if (_check_mutable(self) == -1)
+        return -1;
+
+    if (self->temp_isvalid && key == self->temp_key)
+        self->temp_isvalid = false;
+
+    if (mdict_del_map(self->ht, key, &v) == -2)
+        return 0;
+    if (val)
+        *val = v;
+    return 1;
+}
+
+static Py_ssize_t api_get_many(PyObject* d, const kbox_t* keys, vbox_t* vals, Py_ssize_t n, vbox_t default_val) {
+    h_t* h = ((dictObj*) d)->ht;
+    Py_ssize_t num_found = 0;
+
+    for (Py_ssize_t j = 0; j < n; ++j) {
+        i_t idx;
+        vals[j] = mdict_get_map(h, keys[j], &idx);
+        if (idx != h->num_buckets)
+            num_found += 1;
+        else
+            vals[j] = default_val;
+    }
+    return num_found;
+}
+
+static int api_next(PyObject* d, Py_ssize_t* pos, kbox_t* key, vbox_t* val) {
+    dictObj* self = (dictObj*) d;
+
+    if (*pos == 0)
+        _expire(self);
+
+    h_t* h = self->ht;
+    i_t i = _flags_next_occupied(h->flags, (i_t) *pos, h->num_buckets);
+    if (i >= h->num_buckets)
+        return 0;
+
+    *key = h->keys[i];
+    *val = h->vals[i];
+    *pos = i + 1;
+    return 1;
+}
+
+static Py_ssize_t api_size(PyObject* d) {
+    return ((dictObj*) d)->ht->size;
+}
+
+static MDICT_SYM(MicrodictAPI) MDICT_SYM(api) = {MICRODICT_API_VERSION, &MDICT_SYM(dictType), api_create, api_get, api_set, api_del, api_get_many, api_next, api_size};
+
+
+static PyMethodDef MDICT_SYM(module_methods)[] = {
+    {"attach", attach, METH_VARARGS, "Attaches a microdict published into a shared memory segment"},
+    {"unlink", unlink_segment, METH_VARARGS, "Removes a shared memory segment published by share"},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef MDICT_SYM(moduleDef) =
+{
+    PyModuleDef_HEAD_INIT,
+    MDICT_NAME " microdictionary", /* name of module */
+    NULL, // Documentation of the module
+    -1,   /* size of per-interpreter state of the module, or -1 if the module keeps state in global variables. */
+    MDICT_SYM(module_methods), /* module level functions */
+};
+
+PyMODINIT_FUNC MDICT_SYM(PyInit)(void)
+{
+    PyObject *obj;
+
+    if (PyType_Ready(&MDICT_SYM(dictType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(keyIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(valueIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(itemIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(shardedType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(shardedIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(chunkIterType)) < 0)
+        return NULL;
+
+#if dtype_key == 1 && dtype_val == 1
+    if (PyType_Ready(&lockfreeType_i32_i32) < 0)
+        return NULL;
+#endif
+
+    obj = PyModule_Create(&MDICT_SYM(moduleDef));
+    if (obj == NULL)
+        return NULL;
+
+    Py_INCREF(&MDICT_SYM(dictType));
+    if (PyModule_AddObject(obj, "create", (PyObject *) &MDICT_SYM(dictType)) < 0) {
+        Py_DECREF(&MDICT_SYM(dictType));
+        Py_DECREF(obj);
+        return NULL;
+    }
+
+    Py_INCREF(&MDICT_SYM(shardedType));
+    if (PyModule_AddObject(obj, "create_sharded", (PyObject *) &MDICT_SYM(shardedType)) < 0) {
+        Py_DECREF(&MDICT_SYM(shardedType));
+        Py_DECREF(obj);
+        return NULL;
+    }
+
+#if dtype_key == 1 && dtype_val == 1
+    Py_INCREF(&lockfreeType_i32_i32);
+    if (PyModule_AddObject(obj, "create_lockfree", (PyObject *) &lockfreeType_i32_i32) < 0) {
+        Py_DECREF(&lockfreeType_i32_i32);
+        Py_DECREF(obj);
+        return NULL;
+    }
+
+#endif
+    PyObject* capsule = PyCapsule_New((void*) &MDICT_SYM(api), "_mdict_c." MDICT_NAME "._C_API", NULL);
+    if (PyModule_AddObject(obj, "_C_API", capsule) < 0) {
+        Py_XDECREF(capsule);
+        Py_DECREF(obj);
+        return NULL;
+    }
+
+    return obj;
+}
\ No newline at end of file
@@ -1,16 +1,16 @@
-from _mdict_c import i32_i32, i32_i64, i64_i32, i64_i64, str_str
+import importlib
 
 str_len_MAX = 65355
-DICT_TYPES = {('i32', 'i32'):i32_i32, ('i64', 'i64'):i64_i64, ('i32', 'i64'):i32_i64, ('i64', 'i32'):i64_i32, ('str', 'str'):str_str}
+INT_TYPES = ('i16', 'u16', 'i32', 'u32', 'i64', 'u64')
+TYPE_PAIRS = [(k, v) for k in INT_TYPES for v in INT_TYPES] + [('str', 'str'), ('str', 'i64'), ('i64', 'str')] # See setup.py
+DICT_TYPES = {(k, v):importlib.import_module('_mdict_c.%s_%s' % (k, v)) for k, v in TYPE_PAIRS}
 
 
-def create(dtype, key_len=None, val_len=None):
+def _parse_dtype(dtype):
 	"""
-	Input : Example input dtype=i32:i32 will create an i32_i32 instance.  
+	Returns the (key_type, value_type) tuple for a dtype string such as "i32:i32".
 	"""
 
-	k_ty, v_type = None, None
-
 	try:
 		splitted_words = dtype.split(':')
 	except AttributeError as e:
@@ -24,20 +24,112 @@ def create(dtype, key_len=None, val_len=None):
 		if (k_type, v_type) not in DICT_TYPES:
 			raise ValueError("Make sure dtype string contains valid key and value types")
 
-	if (k_type, v_type) != ('str', 'str'):
-		myDict = DICT_TYPES[(k_type, v_type)].create()
+	return k_type, v_type
+
+
+def create(dtype, key_len=None, val_len=None, shards=None, concurrent_reads=False, key_range=None, ordered=False, max_items=None, policy=None, max_bytes=None):
+	"""
+	Input : Example input dtype=i32:i32 will create an i32_i32 instance. The key and value types are i16, u16, i32, u32, i64
+	and u64 (signed and unsigned integers of 16, 32 and 64 bits) in any combination, plus str:str, str:i64 and i64:str. A
+	str key type needs key_len and a str value type val_len, the maximum length in bytes of the UTF-8 encoded strings.
+	If shards is given (integer types only), a sharded microdict made of that many independently locked hashtables is
+	created instead. Its set_many and get_many bulk methods release the GIL.
+	If concurrent_reads is True (integer types only), the microdict is protected by a sequence lock (see mdict_seqlock.h) :
+	its get_many method then runs without the GIL, in parallel with one thread modifying the microdict.
+	If key_range is a tuple (key_min, key_max) (integer types only), the keys are expected to mostly fall in [key_min, key_max) :
+	items are then stored in an array indexed by key - key_min (see mdict_direct.h), and lookups need no hashing or probing.
+	The microdict switches to hashing the first time a key outside of that range is inserted.
+	If ordered is True, the microdict remembers the insertion order of its keys, like a Python dictionary (see mdict_ordered.h) :
+	iteration, the get_* methods and the array exports follow that order.
+	If max_items is given, the microdict is a bounded cache holding at most max_items items (see mdict_evict.h) : inserting a new
+	key into a full microdict first evicts the least recently used item (policy="lru") or an item picked by the CLOCK
+	algorithm (policy="clock"). Looking a key up counts as a use.
+	If max_bytes is given, the arrays of the microdict never take more than max_bytes bytes (see mdict_budget.h). An insert that
+	would grow them past the budget raises MemoryError (policy="fail", the default) or first removes a random item (policy="random")
+	or, for integer values, the item with the lowest value (policy="lowest"). With policy="lru" or "clock", the microdict is the
+	bounded cache described above, with the largest capacity that fits max_bytes.
+	"""
+
+	k_type, v_type = _parse_dtype(dtype)
+	has_str = 'str' in (k_type, v_type)
+
+	if key_range is not None and has_str:
+		raise ValueError("key_range is only supported by the integer dictionary types")
+
+	if shards is not None:
+		if key_range is not None or ordered or max_items is not None or max_bytes is not None:
+			raise ValueError("key_range, ordered, max_items and max_bytes can not be combined with shards")
+		if has_str:
+			raise ValueError("shards is only supported by the integer dictionary types")
+		if type(shards) != int:
+			raise TypeError("shards must be int")
+		return DICT_TYPES[(k_type, v_type)].create_sharded(shards)
+
+	if concurrent_reads and has_str:
+		raise ValueError("concurrent_reads is only supported by the integer dictionary types")
+
+	if max_items is None:
+		max_items = 0
+	elif type(max_items) != int:
+		raise TypeError("max_items must be int")
+	elif max_items <= 0:
+		raise ValueError("max_items must be positive")
+
+	if max_bytes is None:
+		max_bytes = 0
+	elif type(max_bytes) != int:
+		raise TypeError("max_bytes must be int")
+	elif max_bytes <= 0:
+		raise ValueError("max_bytes must be positive")
+
+	if not has_str:
+		myDict = DICT_TYPES[(k_type, v_type)].create(concurrent_reads=bool(concurrent_reads), key_range=key_range, ordered=bool(ordered), max_items=max_items, policy=policy, max_bytes=max_bytes)
 		return myDict
 	else:
-		if not(type(key_len) == int and type(val_len) == int):
-			raise TypeError("Both key_len and val_len must be int")
+		str_lens = []
+		for str_type, name, length in ((k_type, 'key_len', key_len), (v_type, 'val_len', val_len)):
+			if str_type != 'str':
+				continue
+			if type(length) != int:
+				raise TypeError(name + " must be int")
+			if not 0<length<=str_len_MAX:
+				raise ValueError(name + " must be in between 0 and 65355")
+			str_lens.append(length)
 
-		if not (0<key_len<=str_len_MAX and 0<val_len<=str_len_MAX):
-			raise ValueError("Both key_len and val_len must be in between 0 and 65355")
-
-		myDict = DICT_TYPES[(k_type, v_type)].create(key_len, val_len)
+		myDict = DICT_TYPES[(k_type, v_type)].create(*str_lens, ordered=bool(ordered), max_items=max_items, policy=policy, max_bytes=max_bytes)
 		return myDict		
 
 
+def create_lockfree(capacity):
+	"""
+	Creates an i32:i32 lock-free microdict able to hold capacity keys (see int32_int32_lockfree.h). Its capsule() method
+	hands the table to native threads, which can then insert and update concurrently without any lock.
+	"""
+
+	if type(capacity) != int:
+		raise TypeError("capacity must be int")
+
+	return DICT_TYPES[('i32', 'i32')].create_lockfree(capacity)
+
+
+def attach(dtype, name):
+	"""
+	Input : dtype as for create and the name of a shared memory segment published with d.share(name) from a microdict of that type.
+	Returns a frozen microdict that reads the items straight from the shared memory segment (POSIX systems only).
+	"""
+
+	k_type, v_type = _parse_dtype(dtype)
+	return DICT_TYPES[(k_type, v_type)].attach(name)
+
+
+def unlink(name):
+	"""
+	Removes the shared memory segment called name. Microdicts already attached to it keep working.
+	"""
+
+	DICT_TYPES[('i64', 'i64')].unlink(name)
+
+
 def listDictionaryTypes():
 	for key in DICT_TYPES:
 		print("Key Type:", key[0], ". Value Type:", key[1])
\ No newline at end of file
@@ -0,0 +1,100 @@
+
+#ifndef MDICT_ATOMIC_H
+#define MDICT_ATOMIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+	Minimal portable atomics used by the concurrent hashtable modes. GCC and Clang use the __atomic
+	builtins, MSVC the Interlocked intrinsics (aligned 64 bit loads and stores are atomic on x64).
+*/
+
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+
+static __inline int32_t mdict_atomic_load_i32(volatile int32_t *p) {
+	int32_t v = *p;
+	_ReadWriteBarrier();
+	return v;
+}
+
+static __inline void mdict_atomic_store_i32(volatile int32_t *p, int32_t v) {
+	_ReadWriteBarrier();
+	*p = v;
+}
+
+static __inline uint64_t mdict_atomic_load_u64(volatile uint64_t *p) {
+	uint64_t v = *p;
+	_ReadWriteBarrier();
+	return v;
+}
+
+static __inline void mdict_atomic_store_u64(volatile uint64_t *p, uint64_t v) {
+	_ReadWriteBarrier();
+	*p = v;
+}
+
+static __inline bool mdict_atomic_cas_u64(volatile uint64_t *p, uint64_t *expected, uint64_t desired) {
+	uint64_t prev = (uint64_t) _InterlockedCompareExchange64((volatile __int64*) p, (__int64) desired, (__int64) *expected);
+	if (prev == *expected)
+		return true;
+	*expected = prev;
+	return false;
+}
+
+static __inline int64_t mdict_atomic_add_i64(volatile int64_t *p, int64_t delta) {
+	return _InterlockedExchangeAdd64((volatile __int64*) p, delta) + delta;
+}
+
+static __inline void mdict_atomic_fence(void) {
+	MemoryBarrier();
+}
+
+static __inline void mdict_cpu_relax(void) {
+	YieldProcessor(); // Spin wait hint
+}
+
+#else
+
+static inline int32_t mdict_atomic_load_i32(volatile int32_t *p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void mdict_atomic_store_i32(volatile int32_t *p, int32_t v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint64_t mdict_atomic_load_u64(volatile uint64_t *p) {
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void mdict_atomic_store_u64(volatile uint64_t *p, uint64_t v) {
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline bool mdict_atomic_cas_u64(volatile uint64_t *p, uint64_t *expected, uint64_t desired) {
+	return __atomic_compare_exchange_n(p, expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+static inline int64_t mdict_atomic_add_i64(volatile int64_t *p, int64_t delta) {
+	return __atomic_add_fetch(p, delta, __ATOMIC_ACQ_REL);
+}
+
+static inline void mdict_atomic_fence(void) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void mdict_cpu_relax(void) {
+	// Spin wait hint : lets the sibling hyperthread run and avoids a memory order violation on leaving the loop.
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+#endif
+
+#endif
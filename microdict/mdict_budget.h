@@ -0,0 +1,160 @@
+
+/*
+	Memory budget.
+
+	mdict_budget_enable caps the bytes taken by the arrays of a table at max_bytes. Before allocating the
+	next tier, mdict_resize compares the size of the arrays it would allocate with the budget and returns
+	-5 instead of growing past it. mdict_set then either fails (BUDGET_FAIL) or makes room for the new key
+	by removing one item, picked at random (BUDGET_RANDOM) or with the lowest value (BUDGET_LOWEST, integer
+	values only, costs a scan of the table). Updating a key that is already present always succeeds.
+
+	The LRU and CLOCK policies of mdict_evict.h are budgeted by the bindings instead : the table is sized
+	up front with the largest capacity whose arrays fit the budget (mdict_budget_max_items).
+*/
+
+#define BUDGET_NONE 0
+#define BUDGET_FAIL 1
+#define BUDGET_RANDOM 2
+#define BUDGET_LOWEST 3
+
+
+size_t mdict_table_bytes(h_t *h, i_t num_buckets) {
+	/*
+	Bytes taken by the arrays of the hashed layout of h with num_buckets buckets, including the expiry and eviction
+	arrays h has.
+	*/
+
+	size_t n = (size_t) num_buckets, words = (size_t) _flags_size(num_buckets);
+	size_t bytes = n * h->k_t_size + 2 * words * sizeof(i_t); // keys, flags and psl
+
+	if (h->is_map)
+		bytes += n * h->v_t_size;
+	if (_ext(h, expiry))
+		bytes += n * sizeof(uint64_t);
+	if (_ext(h, policy) == EVICT_LRU)
+		bytes += 2 * n * sizeof(i_t);
+	else if (_ext(h, policy) == EVICT_CLOCK)
+		bytes += words * sizeof(i_t);
+
+	return bytes;
+}
+
+
+int mdict_budget_policy(const char *name) {
+	/*
+	Returns the budget policy called name ("fail", "random" or "lowest"), or -1 if there is no such policy.
+	*/
+
+	if (strcmp(name, "fail") == 0)
+		return BUDGET_FAIL;
+	if (strcmp(name, "random") == 0)
+		return BUDGET_RANDOM;
+	if (strcmp(name, "lowest") == 0 && dtype_val != 5)
+		return BUDGET_LOWEST;
+	return -1;
+}
+
+
+int mdict_budget_enable(h_t *h, size_t max_bytes, int budget_policy) {
+	/*
+	Returns -1 if an allocation fails and -2 if the arrays h already has take more than max_bytes. In particular, the
+	block of the small layout is allocated with the table, so max_bytes must at least cover it (see mdict_small_bytes).
+	*/
+
+	if (max_bytes < (h->is_small ? mdict_small_bytes(h) : mdict_table_bytes(h, h->num_buckets)))
+		return -2;
+
+	h_ext_t *x = mdict_ext(h);
+	if (!x)
+		return -1;
+	x->max_bytes = max_bytes;
+	x->budget_policy = budget_policy;
+	x->rng = (uint64_t) h->seed * 0x9E3779B97F4A7C15ull + 1;
+	return 0;
+}
+
+
+i_t mdict_budget_max_items(h_t *h, size_t max_bytes, int evict_policy) {
+	/*
+	Returns the largest max_items that mdict_evict_enable(h, max_items, evict_policy) can give h within max_bytes, or
+	0 if not even 32 buckets fit.
+	*/
+
+	h_t t = *h;
+	h_ext_t x;
+	if (h->ext)
+		x = *h->ext;
+	else
+		memset(&x, 0, sizeof(x));
+	x.policy = evict_policy;
+	t.ext = &x;
+
+	if (mdict_table_bytes(&t, 32) > max_bytes)
+		return 0;
+
+	i_t num_buckets = 32;
+	while (num_buckets < (1 << 30) && mdict_table_bytes(&t, num_buckets << 1) <= max_bytes)
+		num_buckets <<= 1;
+
+	return (i_t)(num_buckets * PEAK_LOAD) - 1;
+}
+
+
+inline bool _budget_allows(h_t *h, i_t new_num_buckets) {
+	return !_ext(h, max_bytes) || mdict_table_bytes(h, new_num_buckets) <= h->ext->max_bytes;
+}
+
+
+i_t _budget_victim(h_t *h) {
+	/*
+	Returns the bucket of the item that BUDGET_RANDOM or BUDGET_LOWEST removes from the non empty table h.
+	*/
+
+	i_t victim;
+	h_ext_t *x = h->ext;
+
+#if dtype_val != 5
+	if (x->budget_policy == BUDGET_LOWEST) {
+		victim = _flags_next_occupied(h->flags, 0, h->num_buckets);
+		for (i_t i = victim; i < h->num_buckets; i = _flags_next_occupied(h->flags, i + 1, h->num_buckets)) {
+			if (h->vals[i] < h->vals[victim])
+				victim = i;
+		}
+		return victim;
+	}
+#endif
+
+	// xorshift64 : the first item at or after a random bucket.
+	x->rng ^= x->rng << 13;
+	x->rng ^= x->rng >> 7;
+	x->rng ^= x->rng << 17;
+	victim = _flags_next_occupied(h->flags, (i_t) (x->rng % (uint64_t) h->num_buckets), h->num_buckets);
+	if (victim == h->num_buckets)
+		victim = _flags_next_occupied(h->flags, 0, h->num_buckets);
+	return victim;
+}
+
+
+int mdict_budget_make_room(h_t *h, kbox_t key_box) {
+	/*
+	Called by mdict_set when growing h would exceed its budget. Returns 0 if key_box can then be set without growing
+	the table and -1 otherwise.
+	*/
+
+	i_t idx;
+	mdict_get_map(h, key_box, &idx);
+	if (idx != h->num_buckets)
+		return 0; // An update needs no room.
+
+	if (h->ext->budget_policy == BUDGET_FAIL || h->size == 0)
+		return -1;
+
+	idx = _budget_victim(h);
+	_flags_setTrue_isempty(h->flags, idx);
+	h->has_holes = true;
+	--h->size;
+	++h->version;
+	if (h->ext->policy)
+		_evict_remove(h, idx);
+	return 0;
+}
@@ -0,0 +1,172 @@
+
+/*
+	Direct address layout for integer keys known to fall in a narrow range.
+
+	mdict_direct_enable turns an empty table into an array indexed by key - key_base : the item with
+	key k lives in bucket k - key_base, its presence being recorded in the flags bitmap. A lookup is a
+	subtraction, a bounds check and a flag test, with no hashing or probing, and there is no load factor
+	slack or psl array. The keys array is still filled in so that the iteration and export code works
+	unchanged on direct tables.
+
+	The first insert of a key outside [key_base, key_base + num_buckets) moves the items into an ordinary
+	hashed table (mdict_direct_fallback), which then carries on as if it had been hashed all along.
+	Deleting items never shrinks a direct table.
+*/
+
+#define DIRECT_MAX_BUCKETS (1 << 26) // 512MB per array of 8 byte keys or values
+
+#if dtype_key == 5
+    #define _direct_offset(h, key_box) ((uint64_t) h->num_buckets) // String keys are never direct addressed
+#else
+    #define _direct_offset(h, key_box) ((uint64_t) ((int64_t) key_box - h->ext->key_base))
+#endif
+
+
+int mdict_direct_enable(h_t *h, int64_t key_min, int64_t key_max) {
+	/*
+	Switches the empty table h to the direct layout for keys in [key_min, key_max). Returns -1 if the range is
+	empty or wider than DIRECT_MAX_BUCKETS, or if an allocation fails. h is left unchanged in that case.
+	*/
+
+	if (h->size != 0 || key_max <= key_min || (uint64_t) key_max - (uint64_t) key_min > DIRECT_MAX_BUCKETS)
+		return -1;
+	if (!mdict_ext(h))
+		return -1;
+
+	i_t n = (i_t) (key_max - key_min);
+	k_t *keys = (k_t*) MDICT_MALLOC((size_t) n * h->k_t_size);
+	v_t *vals = h->is_map ? (v_t*) MDICT_MALLOC((size_t) n * h->v_t_size) : NULL;
+	i_t *flags = (i_t*) MDICT_MALLOC(_flags_size(n) * sizeof(i_t));
+
+	if (!keys || (h->is_map && !vals) || !flags) {
+		MDICT_FREE((void *)keys);
+		MDICT_FREE((void *)vals);
+		MDICT_FREE(flags);
+		return -1;
+	}
+
+	memset(flags, 0xff, _flags_size(n) * sizeof(i_t));
+
+	MDICT_FREE((void *)h->keys); // Also the block of the small arrays, if h is small.
+	if (!h->is_small) {
+		MDICT_FREE((void *)h->vals);
+		MDICT_FREE(h->flags);
+		MDICT_FREE(h->psl);
+	}
+
+	h->keys = keys;
+	h->vals = vals;
+	h->flags = flags;
+	h->psl = NULL;
+	h->num_buckets = n;
+	h->upper_bound = n + 1; // The size can not reach it, so mdict_set never asks for a resize.
+	h->ext->key_base = key_min;
+	h->is_small = false;
+	h->is_direct = true;
+	return 0;
+}
+
+
+int mdict_direct_fallback(h_t *h) {
+	/*
+	Moves the items of the direct table h into newly allocated hashed arrays with room for at least one more item.
+	Returns -1 if an allocation fails, in which case the table is left unchanged.
+	*/
+
+	i_t new_num_buckets = 32;
+	while ((i_t)(new_num_buckets * PEAK_LOAD) <= h->size)
+		new_num_buckets <<= 1;
+
+	h_t n = *h;
+	n.ext = NULL; // n is a plain hashed table.
+	n.is_direct = false;
+	n.size = 0;
+	n.num_buckets = new_num_buckets;
+	n.upper_bound = (i_t)(new_num_buckets * PEAK_LOAD);
+	n.keys = (k_t*) MDICT_MALLOC((size_t) new_num_buckets * h->k_t_size);
+	n.vals = h->is_map ? (v_t*) MDICT_MALLOC((size_t) new_num_buckets * h->v_t_size) : NULL;
+	n.flags = (i_t*) MDICT_MALLOC(_flags_size(new_num_buckets) * sizeof(i_t));
+	n.psl = (i_t*) MDICT_CALLOC(_flags_size(new_num_buckets), sizeof(i_t));
+
+	if (!n.keys || (h->is_map && !n.vals) || !n.flags || !n.psl) {
+		MDICT_FREE((void *)n.keys);
+		MDICT_FREE((void *)n.vals);
+		MDICT_FREE(n.flags);
+		MDICT_FREE(n.psl);
+		return -1;
+	}
+
+	memset(n.flags, 0xff, _flags_size(new_num_buckets) * sizeof(i_t));
+
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		vbox_t val = {0};
+		if (h->is_map)
+			val = _get_val(h, GET_PTR(j, h->v_step_increment));
+		mdict_set(&n, _get_key(h, GET_PTR(j, h->k_step_increment)), val);
+	}
+
+	MDICT_FREE((void *)h->keys);
+	MDICT_FREE((void *)h->vals);
+	MDICT_FREE(h->flags);
+
+	h->keys = n.keys;
+	h->vals = n.vals;
+	h->flags = n.flags;
+	h->psl = n.psl;
+	h->num_buckets = n.num_buckets;
+	h->upper_bound = n.upper_bound;
+	h->is_direct = false;
+	return 0;
+}
+
+
+void mdict_direct_clear(h_t *h) {
+	/*
+	Removes every item while staying in the direct layout.
+	*/
+
+	memset(h->flags, 0xff, _flags_size(h->num_buckets) * sizeof(i_t));
+	h->size = 0;
+	h->version += 1;
+}
+
+
+inline vbox_t mdict_direct_get_map(h_t *h, kbox_t key_box, i_t *ret_idx) {
+	vbox_t val = {0};
+	uint64_t idx = _direct_offset(h, key_box);
+
+	if (idx >= (uint64_t) h->num_buckets || _flags_isempty(h->flags, (i_t) idx)) {
+		*ret_idx = h->num_buckets;
+		return val;
+	}
+
+	*ret_idx = (i_t) idx;
+	return _get_val(h, GET_PTR((i_t) idx, h->v_step_increment));
+}
+
+
+inline int mdict_direct_set(h_t *h, kbox_t key_box, vbox_t val_box) {
+	/*
+	mdict_set for direct tables. Returns -4 if key_box is out of range, without modifying h.
+	*/
+
+	uint64_t off = _direct_offset(h, key_box);
+	if (off >= (uint64_t) h->num_buckets)
+		return -4;
+
+	i_t idx = (i_t) off;
+	int ret_val = 0;
+	if (_flags_isempty(h->flags, idx)) {
+		_set_key(h, idx, key_box);
+		_flags_setFalse_isempty(h->flags, idx);
+		++h->size;
+		++h->version;
+		ret_val = 1;
+	}
+
+	if (h->is_map) {
+		_set_val(h, idx, val_box);
+	}
+
+	return ret_val;
+}
@@ -0,0 +1,186 @@
+
+/*
+	Bounded capacity (cache) mode.
+
+	mdict_evict_enable gives an empty table a max_items capacity and an eviction policy. The table is sized
+	up front so that max_items items fit without a resize, and it never shrinks : since inserts and deletes
+	never move the other items, a bucket index identifies an item for as long as it is present, and the
+	policy bookkeeping is kept in arrays indexed by bucket.
+
+	EVICT_LRU keeps the items in a doubly linked list of bucket indices, most recently used first (lru_links
+	holds the previous and next bucket of bucket i at 2i and 2i + 1). A successful lookup or an update moves
+	the item to the front and the item at the back is evicted.
+
+	EVICT_CLOCK keeps one reference bit per bucket, set by a successful lookup or an update. The clock hand
+	sweeps the buckets, clearing the reference bits it passes, and evicts the first item whose bit is clear.
+
+	Inserting a new key into a full table evicts one item first, so both policies cost O(1) (amortized for
+	EVICT_CLOCK) per operation.
+*/
+
+#define EVICT_NONE 0
+#define EVICT_LRU 1
+#define EVICT_CLOCK 2
+
+#define _lru_prev(x, i) x->lru_links[2 * (i)]
+#define _lru_next(x, i) x->lru_links[2 * (i) + 1]
+
+
+int mdict_evict_enable(h_t *h, i_t max_items, int policy) {
+	/*
+	Returns -1 if h is not empty, max_items is not positive or an allocation fails.
+	*/
+
+	if (h->size != 0 || max_items <= 0 || (policy != EVICT_LRU && policy != EVICT_CLOCK))
+		return -1;
+
+	if (h->is_small && mdict_small_upgrade(h) < 0)
+		return -1;
+
+	while (h->upper_bound <= max_items) {
+		if (mdict_resize(h, true) < 0)
+			return -1;
+	}
+
+	h_ext_t *x = mdict_ext(h);
+	if (!x)
+		return -1;
+
+	if (policy == EVICT_LRU) {
+		x->lru_links = (i_t*) MDICT_MALLOC(2 * (size_t) h->num_buckets * sizeof(i_t));
+		if (!x->lru_links)
+			return -1;
+		x->lru_head = x->lru_tail = -1;
+	} else {
+		x->ref_bits = (i_t*) MDICT_CALLOC(_flags_size(h->num_buckets), sizeof(i_t));
+		if (!x->ref_bits)
+			return -1;
+		x->clock_hand = 0;
+	}
+
+	x->max_items = max_items;
+	x->policy = policy;
+	return 0;
+}
+
+
+inline void _lru_unlink(h_ext_t *x, i_t i) {
+	i_t prev = _lru_prev(x, i), next = _lru_next(x, i);
+
+	if (prev >= 0)
+		_lru_next(x, prev) = next;
+	else
+		x->lru_head = next;
+
+	if (next >= 0)
+		_lru_prev(x, next) = prev;
+	else
+		x->lru_tail = prev;
+}
+
+
+inline void _lru_push_front(h_ext_t *x, i_t i) {
+	_lru_prev(x, i) = -1;
+	_lru_next(x, i) = x->lru_head;
+	if (x->lru_head >= 0)
+		_lru_prev(x, x->lru_head) = i;
+	else
+		x->lru_tail = i;
+	x->lru_head = i;
+}
+
+
+inline void _evict_touch(h_t *h, i_t i) {
+	/*
+	Records a use of the item in bucket i.
+	*/
+
+	h_ext_t *x = h->ext;
+	if (x->policy == EVICT_LRU) {
+		if (x->lru_head != i) {
+			_lru_unlink(x, i);
+			_lru_push_front(x, i);
+		}
+	} else {
+		_flags_setTrue_isempty(x->ref_bits, i); // Sets the reference bit.
+	}
+}
+
+
+inline void _evict_insert(h_t *h, i_t i) {
+	if (h->ext->policy == EVICT_LRU)
+		_lru_push_front(h->ext, i);
+	else
+		_flags_setTrue_isempty(h->ext->ref_bits, i);
+}
+
+
+inline void _evict_remove(h_t *h, i_t i) {
+	if (h->ext->policy == EVICT_LRU)
+		_lru_unlink(h->ext, i);
+	else
+		_flags_setFalse_isempty(h->ext->ref_bits, i);
+}
+
+
+void mdict_evict_one(h_t *h) {
+	/*
+	Removes the item chosen by the policy from the non empty table h.
+	*/
+
+	i_t victim;
+	h_ext_t *x = h->ext;
+
+	if (x->policy == EVICT_LRU) {
+		victim = x->lru_tail;
+	} else {
+		i_t mask = h->num_buckets - 1;
+		while (1) {
+			i_t i = x->clock_hand;
+			x->clock_hand = (i + 1) & mask;
+			if (_flags_isempty(h->flags, i))
+				continue;
+			if (_flags_isempty(x->ref_bits, i)) { // Referenced since the last sweep : second chance.
+				_flags_setFalse_isempty(x->ref_bits, i);
+				continue;
+			}
+			victim = i;
+			break;
+		}
+	}
+
+	_evict_remove(h, victim);
+	_flags_setTrue_isempty(h->flags, victim);
+	h->has_holes = true;
+	--h->size;
+	++h->version;
+}
+
+
+void mdict_evict_clear(h_t *h) {
+	/*
+	Removes every item while keeping the capacity and the policy.
+	*/
+
+	memset(h->flags, 0xff, _flags_size(h->num_buckets) * sizeof(i_t));
+	memset(h->psl, 0, _flags_size(h->num_buckets) * sizeof(i_t));
+	if (h->ext->policy == EVICT_LRU)
+		h->ext->lru_head = h->ext->lru_tail = -1;
+	else
+		memset(h->ext->ref_bits, 0, _flags_size(h->num_buckets) * sizeof(i_t));
+	h->size = 0;
+	h->version += 1;
+}
+
+
+int mdict_evict_policy(const char *name) {
+	/*
+	Returns the policy called name ("lru" or "clock"), or -1 if there is no such policy.
+	*/
+
+	if (strcmp(name, "lru") == 0)
+		return EVICT_LRU;
+	if (strcmp(name, "clock") == 0)
+		return EVICT_CLOCK;
+	return -1;
+}
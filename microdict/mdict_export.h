@@ -0,0 +1,68 @@
+
+/*
+	Dense export of the items.
+
+	Copies the keys and/or values of the occupied buckets into contiguous arrays, in bucket order. The work is
+	split in ranges of flags words : mdict_count_words gives the number of items of a range (a popcount per word),
+	so that the output offset of every range is known up front and several threads can each export one range.
+*/
+
+
+i_t mdict_count_words(h_t *h, i_t w_start, i_t w_end) {
+	/*
+	Returns the number of occupied buckets within the flags words [w_start, w_end).
+	*/
+
+	i_t n = 0;
+	for (i_t w = w_start; w < w_end; ++w)
+		n += _popcount32(~(uint32_t) h->flags[w]);
+	return n;
+}
+
+
+i_t mdict_export_words(h_t *h, i_t w_start, i_t w_end, kbox_t *keys_out, vbox_t *vals_out, i_t max_items) {
+	/*
+	Writes the keys (if keys_out is not NULL) and the values (if vals_out is not NULL) of the occupied buckets within
+	the flags words [w_start, w_end) into keys_out[0..] and vals_out[0..], stopping after max_items items.
+	Returns the number of items written.
+	*/
+
+	i_t n = 0;
+
+	for (i_t w = w_start; w < w_end && n < max_items; ++w) {
+		uint32_t word = ~(uint32_t) h->flags[w];
+		while (word && n < max_items) {
+			i_t i = (w << 5) + _ctz32(word);
+			word &= word - 1;
+			if (keys_out)
+				keys_out[n] = _get_key(h, GET_PTR(i, h->k_step_increment));
+			if (vals_out)
+				vals_out[n] = _get_val(h, GET_PTR(i, h->v_step_increment));
+			n += 1;
+		}
+	}
+
+	return n;
+}
+
+
+i_t mdict_export_from(h_t *h, i_t *idx, kbox_t *keys_out, vbox_t *vals_out, i_t max_items) {
+	/*
+	Resumable export used by chunked iteration : writes at most max_items items found at or after bucket *idx, then
+	advances *idx past the last bucket written. Returns the number of items written.
+	*/
+
+	i_t n = 0, i = *idx;
+
+	while (n < max_items && (i = _flags_next_occupied(h->flags, i, h->num_buckets)) < h->num_buckets) {
+		if (keys_out)
+			keys_out[n] = _get_key(h, GET_PTR(i, h->k_step_increment));
+		if (vals_out)
+			vals_out[n] = _get_val(h, GET_PTR(i, h->v_step_increment));
+		n += 1;
+		i += 1;
+	}
+
+	*idx = i;
+	return n;
+}
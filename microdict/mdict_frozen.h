@@ -0,0 +1,132 @@
+
+/*
+	Frozen (read-only) hashtable layout.
+
+	A frozen table stores its items densely in the keys and vals arrays, grouped by hash slot:
+	the items whose hash falls into slot s live in [offsets[s], offsets[s+1]). A lookup is a single
+	offsets load followed by a short contiguous scan, and the insertion slack and the psl array of
+	the open addressing layout are dropped. The flags bitmap is kept (with every item marked as
+	occupied) so that the iteration and export code works unchanged on frozen tables.
+
+	A frozen table is never modified, so mdict_frozen_get_map can be called concurrently from any
+	number of threads without holding the GIL.
+*/
+
+#define FROZEN_SLOT_LOAD 4 // Average number of items sharing a slot. Offsets cost 4/FROZEN_SLOT_LOAD bytes per item.
+#define FROZEN_MIX 0x9E3779B97F4A7C15ULL // Fibonacci hashing constant, as in mdict_sharded.h.
+
+
+inline i_t _frozen_slot(h_t *h, kbox_t key_box) {
+	/*
+	The slot of key_box is given by the high bits of its hash multiplied by FROZEN_MIX, so that keys which only differ
+	in their high bits (e.g. multiples of a power of two, under the identity hash of the integer types) still spread
+	over all the slots. slot_bits is at most 29, and the shift by 32 first keeps it defined for a single slot.
+	*/
+
+	uint64_t x = (uint64_t) _hash_func(h, key_box) * FROZEN_MIX;
+	return (i_t) ((x >> 32) >> (32 - h->ext->slot_bits));
+}
+
+
+h_t *mdict_freeze(h_t *h) {
+	/*
+	Returns a newly allocated frozen copy of h, or NULL if the allocation fails. h is left untouched. The copy is in
+	hash slot order, so h should not be an ordered table (see mdict_ordered.h).
+	*/
+
+	i_t n = h->size, k_step_inc = h->k_step_increment, v_step_inc = h->v_step_increment;
+	i_t cap = MAX(n, 1);
+	i_t num_slots = 1, slot_bits = 0;
+
+	while (num_slots * FROZEN_SLOT_LOAD < n) {
+		num_slots <<= 1;
+		slot_bits += 1;
+	}
+
+	h_t* f = (h_t*)MDICT_CALLOC(1, sizeof(h_t));
+	if (!f)
+		return NULL;
+	if (!mdict_ext(f)) {
+		MDICT_FREE(f);
+		return NULL;
+	}
+
+	f->k_t_size = h->k_t_size;
+	f->v_t_size = h->v_t_size;
+	f->key_str_len = h->key_str_len;
+	f->val_str_len = h->val_str_len;
+	f->k_step_increment = k_step_inc;
+	f->v_step_increment = v_step_inc;
+	f->seed = h->seed;
+	f->is_map = h->is_map;
+
+	f->keys = (k_t*) MDICT_MALLOC(cap * h->k_t_size);
+	f->vals = (v_t*) MDICT_MALLOC(cap * h->v_t_size);
+	f->flags = (i_t*) MDICT_MALLOC(_flags_size(cap) * sizeof(i_t));
+	f->ext->slot_bits = slot_bits;
+	i_t* offsets = f->ext->offsets = (i_t*) MDICT_CALLOC(num_slots + 1, sizeof(i_t));
+	i_t* cursor = (i_t*) MDICT_MALLOC(num_slots * sizeof(i_t));
+
+	if (!f->keys || !f->vals || !f->flags || !offsets || !cursor) {
+		MDICT_FREE(cursor);
+		mdict_delete_ht(f);
+		return NULL;
+	}
+
+	memset(f->flags, 0xff, _flags_size(cap) * sizeof(i_t));
+	for (i_t i = 0; i < n; ++i)
+		_flags_setFalse_isempty(f->flags, i);
+
+	// Counting pass : offsets[s+1] holds the number of items hashing into slot s.
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		kbox_t key = _get_key(h, GET_PTR(j, k_step_inc));
+		offsets[_frozen_slot(f, key) + 1] += 1;
+	}
+
+	for (i_t s = 0; s < num_slots; ++s) {
+		offsets[s+1] += offsets[s];
+		cursor[s] = offsets[s];
+	}
+
+	// Scatter pass
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		kbox_t key = _get_key(h, GET_PTR(j, k_step_inc));
+		i_t pos = cursor[_frozen_slot(f, key)]++;
+		_set_key(f, GET_PTR(pos, k_step_inc), key);
+		if (h->is_map) {
+			_set_val(f, GET_PTR(pos, v_step_inc), _get_val(h, GET_PTR(j, v_step_inc)));
+		}
+	}
+
+	MDICT_FREE(cursor);
+
+	f->size = n;
+	f->num_buckets = n;
+	f->upper_bound = n;
+	f->ext->num_slots = num_slots;
+	f->is_frozen = true;
+	return f;
+}
+
+
+inline vbox_t mdict_frozen_get_map(h_t *h, kbox_t key_box, i_t *ret_idx)
+{
+	/*
+	Lookup for frozen tables. Same contract as mdict_get_map : *ret_idx is set to h->num_buckets if the key is absent.
+	*/
+
+	i_t *offsets = h->ext->offsets;
+	i_t slot = _frozen_slot(h, key_box);
+	i_t end = offsets[slot+1];
+	vbox_t val = {0};
+
+	for (i_t idx = offsets[slot]; idx < end; ++idx) {
+		if (_key_equal(h, GET_PTR(idx, h->k_step_increment), key_box)) {
+			*ret_idx = idx;
+			return _get_val(h, GET_PTR(idx, h->v_step_increment));
+		}
+	}
+
+	*ret_idx = h->num_buckets;
+	return val;
+}
@@ -6,6 +6,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <math.h>
+#include "mdict_atomic.h"
 
 /* 
 	Microdictionary hashtable implementation.
@@ -14,11 +15,53 @@
 
 void rehash_int(h_t* h, i_t* new_flags, i_t* new_psl, i_t new_num_buckets);
 void rehash_str(h_t* h, i_t* new_flags, i_t* new_psl, i_t new_num_buckets);
+h_ext_t *mdict_ext(h_t *h);
 int mdict_resize(h_t *h, bool to_expand);
+int _resize(h_t *h, bool to_expand);
+vbox_t mdict_get_map(h_t *h, kbox_t key_box, i_t *ret_idx);
+int mdict_set(h_t *h, kbox_t key_box, vbox_t val_box);
+int mdict_del_map(h_t *h, kbox_t key_box, vbox_t* val_box);
+h_t *mdict_freeze(h_t *h);
+vbox_t mdict_frozen_get_map(h_t *h, kbox_t key_box, i_t *ret_idx);
+i_t _frozen_slot(h_t *h, kbox_t key_box);
+void mdict_shm_detach(h_t *h);
+int mdict_seqlock_grow(h_t *h);
+void mdict_seqlock_free_retired(h_t *h);
+void _seq_write_begin(h_t *h);
+void _seq_write_end(h_t *h);
+h_t *mdict_small_create(h_t *h);
+int mdict_small_upgrade(h_t *h);
+vbox_t mdict_small_get_map(h_t *h, kbox_t key_box, i_t *ret_idx);
+int mdict_small_set(h_t *h, kbox_t key_box, vbox_t val_box);
+int mdict_direct_fallback(h_t *h);
+vbox_t mdict_direct_get_map(h_t *h, kbox_t key_box, i_t *ret_idx);
+int mdict_direct_set(h_t *h, kbox_t key_box, vbox_t val_box);
+int mdict_ordered_rebuild(h_t *h);
+vbox_t mdict_ordered_get_map(h_t *h, kbox_t key_box, i_t *ret_idx);
+int mdict_ordered_set(h_t *h, kbox_t key_box, vbox_t val_box);
+void mdict_evict_one(h_t *h);
+void _evict_touch(h_t *h, i_t i);
+void _evict_insert(h_t *h, i_t i);
+void _evict_remove(h_t *h, i_t i);
+int mdict_ttl_resize(h_t *h, bool to_expand);
+bool _is_expired(h_t *h, i_t idx);
+void _expire_step(h_t *h);
+void _expire_bucket(h_t *h, i_t idx);
+i_t mdict_expire(h_t *h);
+size_t mdict_table_bytes(h_t *h, i_t num_buckets);
+bool _budget_allows(h_t *h, i_t new_num_buckets);
+int mdict_budget_make_room(h_t *h, kbox_t key_box);
+uint64_t mdict_now_ns(void);
+
+#ifdef MDICT_STATS
+	#define _stats_add(h, field, n) ((h)->field += (n))
+#else
+	#define _stats_add(h, field, n)
+#endif
 
 
 h_t *mdict_create(ht_param* param) {
-	h_t* h = (h_t*)calloc(1, sizeof(h_t));
+	h_t* h = (h_t*)MDICT_CALLOC(1, sizeof(h_t));
 	h->is_map = true;							
 
 	if (param){
@@ -50,25 +93,61 @@ h_t *mdict_create(ht_param* param) {
 		h->v_step_increment = 1;
 	}
 
-	mdict_resize(h, true);
-	return h;		
+	return mdict_small_create(h);
 }																	
 
 
+h_ext_t *mdict_ext(h_t *h) {
+	/*
+	Returns the extension of h, allocating it zeroed on first use. Returns NULL if the allocation fails.
+	*/
+
+	if (!h->ext)
+		h->ext = (h_ext_t*) MDICT_CALLOC(1, sizeof(h_ext_t));
+	return h->ext;
+}
+
+
 void mdict_delete_ht(h_t *h)						
 {																	
 	if (h) {					
-		free((void *)h->keys); 
-		free(h->flags);					
-		free((void *)h->vals);
-		free(h->psl);										
-		free(h);													
+		if (_ext(h, shm_base)) {
+			mdict_shm_detach(h); // The arrays live inside the shared memory mapping
+		} else {
+			MDICT_FREE((void *)h->keys); // Also the block of the small arrays, if h is small.
+			if (!h->is_small) {
+				MDICT_FREE(h->flags);					
+				MDICT_FREE((void *)h->vals);
+				MDICT_FREE(h->psl);										
+			}
+			if (h->ext) {
+				MDICT_FREE(h->ext->offsets);
+				MDICT_FREE(h->ext->index);
+				MDICT_FREE(h->ext->lru_links);
+				MDICT_FREE(h->ext->ref_bits);
+				MDICT_FREE(h->ext->expiry);
+			}
+		}
+		if (h->ext) {
+			mdict_seqlock_free_retired(h);
+			MDICT_FREE(h->ext);
+		}
+		MDICT_FREE(h);													
 	}																
 }
 
 
 inline vbox_t mdict_get_map(h_t *h, kbox_t key_box, i_t *ret_idx) 	
 {																	
+	if (h->is_frozen)
+		return mdict_frozen_get_map(h, key_box, ret_idx);
+	if (h->is_small)
+		return mdict_small_get_map(h, key_box, ret_idx);
+	if (h->is_direct)
+		return mdict_direct_get_map(h, key_box, ret_idx);
+	if (h->is_ordered)
+		return mdict_ordered_get_map(h, key_box, ret_idx);
+
 	i_t idx, ptr, last, mask, step = 0, k_step_inc = h->k_step_increment, v_step_inc = h->v_step_increment; 
 	mask = h->num_buckets - 1;
 	idx = _hash_func(h, key_box) & mask; 
@@ -81,13 +160,26 @@ inline vbox_t mdict_get_map(h_t *h, kbox_t key_box, i_t *ret_idx)
 		idx = (idx + (++step)) & mask;
 		ptr = GET_PTR(idx, k_step_inc);
 		if (step > psl_val) {
+			_stats_add(h, num_lookups, 1);
+			_stats_add(h, lookup_probes, step);
 			*ret_idx = h->num_buckets;
 			return val;
 		}						
 	}
 
+	_stats_add(h, num_lookups, 1);
+	_stats_add(h, lookup_probes, step);
 	*ret_idx = idx;
+	if (_ext(h, expiry) && _is_expired(h, idx)) {
+		if (!h->ext->expire_holds)
+			_expire_bucket(h, idx);
+		*ret_idx = h->num_buckets;
+		return val;
+	}
+
 	val = _get_val(h, GET_PTR(idx, v_step_inc));
+	if (_ext(h, policy))
+		_evict_touch(h, idx);
 
 	return val;
 }															
@@ -96,6 +188,36 @@ inline vbox_t mdict_get_map(h_t *h, kbox_t key_box, i_t *ret_idx)
 
 int mdict_resize(h_t *h, bool to_expand) 
 {
+	/*
+	Grows (or shrinks) h to the next tier of its layout. Returns 0 on success, -1 if an allocation fails and -5 if
+	growing would exceed the memory budget of h. Successful resizes are counted for mdict_stats.h.
+	*/
+
+	uint64_t start = mdict_now_ns();
+	int ret_val = _resize(h, to_expand);
+	if (ret_val == 0) {
+		++h->num_resizes;
+		h->rehash_ns += mdict_now_ns() - start;
+	}
+	return ret_val;
+}
+
+
+int _resize(h_t *h, bool to_expand) 
+{
+	if (h->is_seqlocked)
+		return to_expand ? mdict_seqlock_grow(h) : 0;
+	if (to_expand && !_budget_allows(h, h->is_small ? 32 : h->num_buckets << 1))
+		return -5;
+	if (h->is_small)
+		return to_expand ? mdict_small_upgrade(h) : 0;
+	if (h->is_direct)
+		return to_expand ? mdict_direct_fallback(h) : 0;
+	if (h->is_ordered)
+		return mdict_ordered_rebuild(h);
+	if (_ext(h, expiry))
+		return mdict_ttl_resize(h, to_expand);
+
 	i_t *new_flags, *new_psl;										
 	i_t j = 1;				
 	
@@ -108,11 +230,14 @@ int mdict_resize(h_t *h, bool to_expand)
 	if (new_num_buckets < 32) 
 		new_num_buckets = 32;			
 
-	new_flags = (i_t*) malloc(_flags_size(new_num_buckets) * sizeof(i_t));	
-	new_psl = (i_t*) malloc(_flags_size(new_num_buckets) * sizeof(i_t));	
+	new_flags = (i_t*) MDICT_MALLOC(_flags_size(new_num_buckets) * sizeof(i_t));	
+	new_psl = (i_t*) MDICT_MALLOC(_flags_size(new_num_buckets) * sizeof(i_t));	
 
-	if (!new_flags || !new_psl) 
+	if (!new_flags || !new_psl) {
+		MDICT_FREE(new_flags);
+		MDICT_FREE(new_psl);
 		return -1;	
+	}
 
 	memset(new_flags, 0xff, _flags_size(new_num_buckets) * sizeof(i_t)); 
 	memset(new_psl, 0, _flags_size(new_num_buckets) * sizeof(i_t)); 
@@ -121,16 +246,18 @@ int mdict_resize(h_t *h, bool to_expand)
 	i_t v_t_size = h->v_t_size;
 
 	if (h->num_buckets < new_num_buckets) {		
-		k_t *new_keys = (k_t*)realloc((void *)h->keys, new_num_buckets * k_t_size); 
+		k_t *new_keys = (k_t*)MDICT_REALLOC((void *)h->keys, new_num_buckets * k_t_size); 
 		if (!new_keys) { 
-			free(new_flags); 
+			MDICT_FREE(new_flags); 
+			MDICT_FREE(new_psl); 
 			return -1; 
 		}		
 		h->keys = new_keys;									
 		if (h->is_map) {									
-			v_t *new_vals = (v_t*)realloc((void *)h->vals, new_num_buckets * v_t_size); 
+			v_t *new_vals = (v_t*)MDICT_REALLOC((void *)h->vals, new_num_buckets * v_t_size); 
 			if (!new_vals) { 
-				free(new_flags); 
+				MDICT_FREE(new_flags); 
+				MDICT_FREE(new_psl); 
 				return -1; 
 			}	
 			h->vals = new_vals;								
@@ -140,17 +267,23 @@ int mdict_resize(h_t *h, bool to_expand)
 	_rehash_func(h, new_flags, new_psl, new_num_buckets);
 
 	if (h->num_buckets > new_num_buckets) {
-		h->keys = (k_t*)realloc((void *)h->keys, new_num_buckets * k_t_size); 
+		// Shrinking realloc can only fail by keeping the larger block, which is still valid.
+		k_t *new_keys = (k_t*)MDICT_REALLOC((void *)h->keys, new_num_buckets * k_t_size); 
+		if (new_keys)
+			h->keys = new_keys;
 
 		if (h->is_map) { 
-			h->vals = (v_t*)realloc((void *)h->vals, new_num_buckets * v_t_size); 
+			v_t *new_vals = (v_t*)MDICT_REALLOC((void *)h->vals, new_num_buckets * v_t_size); 
+			if (new_vals)
+				h->vals = new_vals;
 		}
 	}
 
-	free(h->flags); 		
-	free(h->psl);		
+	MDICT_FREE(h->flags); 		
+	MDICT_FREE(h->psl);		
 	h->flags = new_flags;			
 	h->psl = new_psl;							
+	h->has_holes = false; // new_flags only ever had buckets filled.
 	h->num_buckets = new_num_buckets;								
 	h->upper_bound = (i_t)(h->num_buckets * PEAK_LOAD); 
 															
@@ -215,8 +348,55 @@ inline int mdict_set(h_t *h, kbox_t key_box, vbox_t val_box)
 {																	
 	i_t x;														
 
+	if (h->is_frozen)
+		return -3;
+
+	if (h->is_small) {
+		i_t idx = h->num_buckets;
+		if (h->size == h->upper_bound)
+			mdict_small_get_map(h, key_box, &idx);
+		if (h->size < h->upper_bound || idx != h->num_buckets)
+			return mdict_small_set(h, key_box, val_box);
+	}
+
+	if (h->is_ordered)
+		return mdict_ordered_set(h, key_box, val_box);
+
+	if (h->is_direct) {
+		int ret_val = mdict_direct_set(h, key_box, val_box);
+		if (ret_val != -4)
+			return ret_val;
+		if (mdict_direct_fallback(h) < 0) // key_box is out of range, so the table carries on hashed.
+			return -1;
+	}
+
+	h_ext_t *ext = h->ext;
+
+	if (ext && ext->expiry && !ext->expire_holds)
+		_expire_step(h);
+
+	if (ext && ext->policy && h->size >= ext->max_items) {
+		i_t idx;
+		mdict_get_map(h, key_box, &idx);
+		if (idx == h->num_buckets && ext->expiry)
+			mdict_expire(h); // Expired items make room before live ones are evicted.
+		if (idx == h->num_buckets && h->size >= ext->max_items)
+			mdict_evict_one(h); // Makes room for key_box.
+	}
+
+	_seq_write_begin(h);
+
 	if (h->size >= h->upper_bound) {
-		if (mdict_resize(h, true) < 0) {   
+		int ret_val = mdict_resize(h, true);
+		if (ret_val == -5) {
+			ret_val = mdict_budget_make_room(h, key_box); // Growing would exceed the memory budget.
+			if (ret_val == 0 && h->is_small) {
+				_seq_write_end(h);
+				return mdict_small_set(h, key_box, val_box);
+			}
+		}
+		if (ret_val < 0) {   
+			_seq_write_end(h);
 			return -1;
 		}											
 	}
@@ -227,21 +407,42 @@ inline int mdict_set(h_t *h, kbox_t key_box, vbox_t val_box)
 	last = idx;
 	i_t psl_val = _get_psl(h->psl, last);
 	
-	i_t ptr = GET_PTR(idx, k_step_inc); 
-
-	if (_flags_isempty(h->flags, idx)) 
-		x = ptr; 
-	else {														
-		while (!(_flags_isempty(h->flags, idx) || _key_equal(h, ptr, key_box))) { 
-			idx = (idx + (++step)) & mask; 
-			ptr = GET_PTR(idx, k_step_inc);
-
-			if (idx == last) { 
-				return -2;
-			}					
-		}														
-		x = ptr;														
+	i_t free_idx = -1, free_step = 0, search_len = h->has_holes ? psl_val : 0;
+
+	/*
+	Deletions leave empty buckets in the middle of probe sequences, so the key may still be present past the first
+	empty bucket : the search goes on until psl_val steps and the key is only inserted, in the first empty bucket
+	met, once it is known to be absent. Without deletions since the last resize the first empty bucket ends the
+	search, psl_val being the longest probe of a whole group of 32 buckets.
+	*/
+	while (1) { 
+		bool is_empty = _flags_isempty(h->flags, idx);
+		if (!is_empty && _key_equal(h, GET_PTR(idx, k_step_inc), key_box)) {
+			if (!(ext && ext->expiry && _is_expired(h, idx)))
+				break;
+			_expire_bucket(h, idx); // key_box has expired, so it is inserted anew.
+			is_empty = true;
+		}
+
+		if (is_empty && free_idx < 0) {
+			free_idx = idx;
+			free_step = step;
+		}
+		if (free_idx >= 0 && step >= search_len) {
+			idx = free_idx;
+			step = free_step;
+			break;
+		}
+
+		idx = (idx + (++step)) & mask; 
+		if (step >= h->num_buckets) { 
+			_seq_write_end(h);
+			return -2;
+		}					
 	}															
+	x = GET_PTR(idx, k_step_inc);
+	_stats_add(h, num_inserts, 1);
+	_stats_add(h, insert_probes, step);
 
 	int ret_val;
 
@@ -249,17 +450,26 @@ inline int mdict_set(h_t *h, kbox_t key_box, vbox_t val_box)
 		_set_key(h, x, key_box);										
 		_flags_setFalse_isempty(h->flags, idx);							
 		++h->size; 
+		++h->version;
 		ret_val = 1;
-	} else 
+		if (ext && ext->policy)
+			_evict_insert(h, idx);
+	} else {
 		ret_val = 0;  
+		if (ext && ext->policy)
+			_evict_touch(h, idx);
+	}
 
 	if (h->is_map) {
 		_set_val(h, GET_PTR(idx, v_step_inc), val_box);		
 	}
+	if (ext && ext->expiry)
+		ext->expiry[idx] = 0;
 
 	if (step > psl_val)
 		_set_psl(h->psl, last, step);
 
+	_seq_write_end(h);
 	return ret_val;														
 }					
 
@@ -268,25 +478,46 @@ inline int mdict_set(h_t *h, kbox_t key_box, vbox_t val_box)
 inline int mdict_del_map(h_t *h, kbox_t key_box, vbox_t* val_box) {
 	i_t idx;
 
+	if (h->is_frozen)
+		return -3;
+
 	if (val_box == NULL)
 		mdict_get_map(h, key_box, &idx);
 	else
 		*val_box = mdict_get_map(h, key_box, &idx);
 
 	if (idx != h->num_buckets) {
+		_seq_write_begin(h);
 		_flags_setTrue_isempty(h->flags, idx);							
+		h->has_holes = true;
 		--h->size;
+		++h->version;
+		if (_ext(h, policy))
+			_evict_remove(h, idx);
+		_seq_write_end(h);
 	} else {
 		return -2;
 	}
 
-	if (h->size <= (h->num_buckets >> 2) && h->num_buckets > 32) {
+	if (h->size <= (h->num_buckets >> 2) && h->num_buckets > 32 && !h->is_seqlocked && !_ext(h, policy)) {
 		if (mdict_resize(h, false) < 0) {  
 			return -1;
 		}														
 	}
 
 	return 0;
-} 
+}
 
 
+#include "mdict_small.h"
+#include "mdict_direct.h"
+#include "mdict_ordered.h"
+#include "mdict_evict.h"
+#include "mdict_ttl.h"
+#include "mdict_budget.h"
+#include "mdict_stats.h"
+#include "mdict_frozen.h"
+#include "mdict_shm.h"
+#include "mdict_sharded.h"
+#include "mdict_seqlock.h"
+#include "mdict_export.h"
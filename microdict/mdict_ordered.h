@@ -0,0 +1,212 @@
+
+/*
+	Insertion ordered layout, after CPython's compact dict.
+
+	The keys and vals arrays hold the entries densely, in insertion order : a new item is always appended
+	at num_entries. The flags bitmap keeps its meaning over the entries, a deleted entry simply being
+	flagged as empty, so that the iteration and export code works unchanged and walks the items in
+	insertion order with no empty buckets to skip besides the deleted ones.
+
+	The items are found through a separate open addressing index of index_size slots (a power of two) that
+	store entry + 1, 0 meaning an empty slot. The slots are 8, 16 or 32 bits wide depending on the number of
+	entries. An index slot pointing to a deleted entry acts as a tombstone : lookups probe past it and
+	inserts reuse it. Once the entries array is full, mdict_ordered_rebuild compacts the live entries into
+	arrays sized for twice as many items and rebuilds the index.
+
+	num_buckets is the capacity of the entries array, so that a miss is still reported with *ret_idx = num_buckets.
+*/
+
+
+static int _index_width(i_t capacity) {
+	if (capacity < UINT8_MAX)
+		return 1;
+	if (capacity < UINT16_MAX)
+		return 2;
+	return 4;
+}
+
+
+static inline i_t _index_get(h_ext_t *x, i_t slot) {
+	if (x->index_width == 1)
+		return ((uint8_t *) x->index)[slot];
+	if (x->index_width == 2)
+		return ((uint16_t *) x->index)[slot];
+	return ((uint32_t *) x->index)[slot];
+}
+
+
+static inline void _index_set(h_ext_t *x, i_t slot, i_t entry_plus_one) {
+	if (x->index_width == 1)
+		((uint8_t *) x->index)[slot] = (uint8_t) entry_plus_one;
+	else if (x->index_width == 2)
+		((uint16_t *) x->index)[slot] = (uint16_t) entry_plus_one;
+	else
+		((uint32_t *) x->index)[slot] = (uint32_t) entry_plus_one;
+}
+
+
+int mdict_ordered_rebuild(h_t *h) {
+	/*
+	Moves the live entries of h, in order, into new arrays able to hold twice as many items and rebuilds the index.
+	Returns -1 if an allocation fails, in which case the table is left unchanged.
+	*/
+
+	i_t new_index_size = 32;
+	while ((i_t)(new_index_size * PEAK_LOAD) <= 2 * h->size)
+		new_index_size <<= 1;
+
+	i_t capacity = (i_t)(new_index_size * PEAK_LOAD);
+	h_t n = *h;
+	h_ext_t x = *h->ext;
+	n.num_buckets = capacity;
+	n.upper_bound = capacity;
+	x.index_size = new_index_size;
+	x.index_width = _index_width(capacity);
+	n.keys = (k_t*) MDICT_MALLOC(capacity * h->k_t_size);
+	n.vals = h->is_map ? (v_t*) MDICT_MALLOC(capacity * h->v_t_size) : NULL;
+	n.flags = (i_t*) MDICT_MALLOC(_flags_size(capacity) * sizeof(i_t));
+	x.index = MDICT_CALLOC(new_index_size, x.index_width);
+
+	if (!n.keys || (h->is_map && !n.vals) || !n.flags || !x.index) {
+		MDICT_FREE((void *)n.keys);
+		MDICT_FREE((void *)n.vals);
+		MDICT_FREE(n.flags);
+		MDICT_FREE(x.index);
+		return -1;
+	}
+
+	memset(n.flags, 0xff, _flags_size(capacity) * sizeof(i_t));
+
+	i_t e = 0, mask = new_index_size - 1;
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		memcpy((char *) n.keys + (size_t) e * h->k_t_size, (char *) h->keys + (size_t) j * h->k_t_size, h->k_t_size);
+		if (h->is_map)
+			memcpy((char *) n.vals + (size_t) e * h->v_t_size, (char *) h->vals + (size_t) j * h->v_t_size, h->v_t_size);
+		_flags_setFalse_isempty(n.flags, e);
+
+		i_t slot = _hash_func(h, _get_key(h, GET_PTR(j, h->k_step_increment))) & mask, step = 0;
+		while (_index_get(&x, slot))
+			slot = (slot + (++step)) & mask;
+		_index_set(&x, slot, ++e);
+	}
+
+	MDICT_FREE((void *)h->keys);
+	MDICT_FREE((void *)h->vals);
+	MDICT_FREE(h->flags);
+	MDICT_FREE(h->ext->index);
+
+	h->keys = n.keys;
+	h->vals = n.vals;
+	h->flags = n.flags;
+	h->ext->index = x.index;
+	h->ext->index_size = x.index_size;
+	h->ext->index_width = x.index_width;
+	h->ext->num_entries = e;
+	h->num_buckets = n.num_buckets;
+	h->upper_bound = n.upper_bound;
+	return 0;
+}
+
+
+int mdict_ordered_enable(h_t *h) {
+	/*
+	Switches the empty table h to the insertion ordered layout. Returns -1 if h is not empty or an allocation fails.
+	*/
+
+	if (h->size != 0 || !mdict_ext(h))
+		return -1;
+
+	h_t old = *h;
+	h->keys = NULL;
+	h->vals = NULL;
+	h->flags = NULL;
+	h->num_buckets = 0;
+	if (mdict_ordered_rebuild(h) < 0) {
+		*h = old;
+		return -1;
+	}
+
+	MDICT_FREE((void *)old.keys); // Also the block of the small arrays, if h was small.
+	if (!old.is_small) {
+		MDICT_FREE((void *)old.vals);
+		MDICT_FREE(old.flags);
+		MDICT_FREE(old.psl);
+	}
+
+	h->psl = NULL;
+	h->is_small = false;
+	h->is_ordered = true;
+	return 0;
+}
+
+
+void mdict_ordered_clear(h_t *h) {
+	/*
+	Removes every item while staying in the insertion ordered layout.
+	*/
+
+	memset(h->flags, 0xff, _flags_size(h->num_buckets) * sizeof(i_t));
+	memset(h->ext->index, 0, (size_t) h->ext->index_size * h->ext->index_width);
+	h->size = 0;
+	h->ext->num_entries = 0;
+	h->version += 1;
+}
+
+
+inline vbox_t mdict_ordered_get_map(h_t *h, kbox_t key_box, i_t *ret_idx) {
+	h_ext_t *x = h->ext;
+	i_t mask = x->index_size - 1, step = 0, k_step_inc = h->k_step_increment;
+	i_t slot = _hash_func(h, key_box) & mask;
+	vbox_t val;
+
+	while (1) {
+		i_t e = _index_get(x, slot);
+		if (!e) {
+			*ret_idx = h->num_buckets;
+			return val;
+		}
+		--e;
+		if (!_flags_isempty(h->flags, e) && _key_equal(h, GET_PTR(e, k_step_inc), key_box)) {
+			*ret_idx = e;
+			return _get_val(h, GET_PTR(e, h->v_step_increment));
+		}
+		slot = (slot + (++step)) & mask;
+	}
+}
+
+
+inline int mdict_ordered_set(h_t *h, kbox_t key_box, vbox_t val_box) {
+	i_t e, mask, slot, step = 0, free_slot = -1;
+	int ret_val = 0;
+
+	mdict_ordered_get_map(h, key_box, &e);
+	if (e == h->num_buckets) {
+		h_ext_t *x = h->ext;
+		if (x->num_entries == h->num_buckets && mdict_resize(h, true) < 0) // Rebuilds the arrays, see _resize.
+			return -1;
+
+		// Looks for the first empty slot or tombstone on the probe sequence of key_box.
+		mask = x->index_size - 1;
+		slot = _hash_func(h, key_box) & mask;
+		while (free_slot < 0) {
+			i_t s = _index_get(x, slot);
+			if (!s || _flags_isempty(h->flags, s - 1))
+				free_slot = slot;
+			slot = (slot + (++step)) & mask;
+		}
+
+		e = x->num_entries++;
+		_set_key(h, GET_PTR(e, h->k_step_increment), key_box);
+		_flags_setFalse_isempty(h->flags, e);
+		_index_set(x, free_slot, e + 1);
+		++h->size;
+		++h->version;
+		ret_val = 1;
+	}
+
+	if (h->is_map) {
+		_set_val(h, GET_PTR(e, h->v_step_increment), val_box);
+	}
+
+	return ret_val;
+}
@@ -0,0 +1,169 @@
+
+/*
+	Single writer / multiple readers (seqlock) mode.
+
+	Once mdict_seqlock_enable has been called, every modification made by mdict_set, mdict_del_map and
+	mdict_resize is bracketed by two increments of the seq counter of h->ext : the counter is odd while the table is being
+	changed. mdict_seqlock_get_map never blocks the writer. It reads the counter, performs an ordinary
+	lookup and retries if the counter was odd or has moved in the meantime, so a reader only ever returns
+	values that were present between two modifications.
+
+	A reader may look at the table while it is being resized, so in this mode the arrays are never
+	reallocated in place or freed early : mdict_resize builds new (larger) arrays and retires the old ones,
+	which are released together with the table. The table never shrinks. Since the arrays only grow and
+	num_buckets is published after them, a reader that loads num_buckets first can never index past the
+	end of the arrays it reads, whatever the interleaving. The retired arrays add up to less than the
+	current ones.
+
+	There must be at most one writer at any time. Readers only need h to stay alive.
+*/
+
+
+int mdict_seqlock_enable(h_t *h) {
+	/*
+	Returns -1 if h is in the small or direct layout and moving it to ordinary arrays fails. Readers rely on the
+	arrays only ever growing, which neither of these layouts allows.
+	*/
+
+	if (h->is_small && mdict_small_upgrade(h) < 0)
+		return -1;
+	if (h->is_direct && mdict_direct_fallback(h) < 0)
+		return -1;
+	if (!mdict_ext(h))
+		return -1;
+	h->is_seqlocked = true;
+	return 0;
+}
+
+
+inline void _seq_write_begin(h_t *h) {
+	if (h->is_seqlocked) {
+		mdict_atomic_store_u64(&h->ext->seq, h->ext->seq + 1);
+		mdict_atomic_fence();
+	}
+}
+
+
+inline void _seq_write_end(h_t *h) {
+	if (h->is_seqlocked)
+		mdict_atomic_store_u64(&h->ext->seq, h->ext->seq + 1);
+}
+
+
+void mdict_seqlock_free_retired(h_t *h) {
+	h_ext_t *x = h->ext;
+	for (i_t i = 0; i < x->num_retired; ++i)
+		MDICT_FREE(x->retired[i]);
+	MDICT_FREE(x->retired);
+	x->retired = NULL;
+	x->num_retired = 0;
+}
+
+
+int mdict_seqlock_grow(h_t *h) {
+	/*
+	mdict_resize for seqlocked tables : rehashes the items into newly allocated arrays twice as large and retires
+	the old ones. Returns -1 if an allocation fails, in which case the table is left unchanged.
+	*/
+
+	i_t new_num_buckets = MAX(h->num_buckets << 1, 32);
+
+	h_ext_t *x = h->ext;
+	h_t n = *h;
+	n.ext = NULL; // n is a plain hashed table.
+	n.is_seqlocked = false;
+	n.size = 0;
+	n.num_buckets = new_num_buckets;
+	n.upper_bound = (i_t)(new_num_buckets * PEAK_LOAD);
+	n.keys = (k_t*) MDICT_MALLOC(new_num_buckets * h->k_t_size);
+	n.vals = h->is_map ? (v_t*) MDICT_MALLOC(new_num_buckets * h->v_t_size) : NULL;
+	n.flags = (i_t*) MDICT_MALLOC(_flags_size(new_num_buckets) * sizeof(i_t));
+	n.psl = (i_t*) MDICT_CALLOC(_flags_size(new_num_buckets), sizeof(i_t));
+
+	// Reserve the retired slots up front so that publishing the new arrays can not fail halfway.
+	void** retired = (void**) MDICT_REALLOC(x->retired, (x->num_retired + 4) * sizeof(void*));
+	if (retired)
+		x->retired = retired;
+
+	if (!n.keys || (h->is_map && !n.vals) || !n.flags || !n.psl || !retired) {
+		MDICT_FREE((void *)n.keys);
+		MDICT_FREE((void *)n.vals);
+		MDICT_FREE(n.flags);
+		MDICT_FREE(n.psl);
+		return -1;
+	}
+
+	memset(n.flags, 0xff, _flags_size(new_num_buckets) * sizeof(i_t));
+
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		vbox_t val = {0}; // Not read by mdict_set if h is a set.
+		if (h->is_map)
+			val = _get_val(h, GET_PTR(j, h->v_step_increment));
+		mdict_set(&n, _get_key(h, GET_PTR(j, h->k_step_increment)), val);
+	}
+
+	if (h->keys) {
+		x->retired[x->num_retired++] = (void *)h->keys;
+		x->retired[x->num_retired++] = (void *)h->vals;
+		x->retired[x->num_retired++] = h->flags;
+		x->retired[x->num_retired++] = h->psl;
+	}
+
+	h->keys = n.keys;
+	h->vals = n.vals;
+	h->flags = n.flags;
+	h->psl = n.psl;
+	h->upper_bound = n.upper_bound;
+	mdict_atomic_store_i32(&h->num_buckets, new_num_buckets); // Published last, see above.
+	return 0;
+}
+
+
+void mdict_seqlock_clear(h_t *h) {
+	/*
+	Removes every item while keeping the arrays, so that concurrent readers keep reading valid memory.
+	*/
+
+	_seq_write_begin(h);
+	memset(h->flags, 0xff, _flags_size(h->num_buckets) * sizeof(i_t));
+	memset(h->psl, 0, _flags_size(h->num_buckets) * sizeof(i_t));
+	h->size = 0;
+	h->version += 1;
+	_seq_write_end(h);
+}
+
+
+static inline bool mdict_seqlock_get_map(h_t *h, kbox_t key_box, vbox_t *val_box) {
+	/*
+	Lookup that may run concurrently with the writer. Returns true and sets *val_box if key_box is present.
+	*/
+
+	while (1) {
+		uint64_t seq = mdict_atomic_load_u64(&h->ext->seq);
+		if (seq & 1) {
+			mdict_cpu_relax(); // A modification is in progress.
+			continue;
+		}
+
+		i_t idx, num_buckets = mdict_atomic_load_i32(&h->num_buckets);
+		/*
+		Only the fields the hashed lookup reads are taken from h, the array pointers after num_buckets (see above). The
+		layout flags and ext are left zeroed : a seqlocked table is always hashed, and readers must not touch the
+		eviction bookkeeping.
+		*/
+		h_t view = {
+			.num_buckets = num_buckets, .keys = h->keys, .vals = h->vals, .flags = h->flags, .psl = h->psl,
+			.seed = h->seed, .k_step_increment = h->k_step_increment, .v_step_increment = h->v_step_increment, .is_map = h->is_map
+		};
+		vbox_t val = mdict_get_map(&view, key_box, &idx);
+
+		mdict_atomic_fence();
+		if (mdict_atomic_load_u64(&h->ext->seq) == seq) {
+			if (idx == num_buckets)
+				return false;
+			*val_box = val;
+			return true;
+		}
+		mdict_cpu_relax();
+	}
+}
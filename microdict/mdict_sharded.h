@@ -0,0 +1,111 @@
+
+/*
+	Sharded hashtables.
+
+	A sharded table holds num_shards independent hashtables. A key always lives in the shard selected by
+	the high bits of its (mixed) hash, while the low bits keep selecting the bucket inside that shard.
+	The shards share no state, so a binding can protect each one with its own lock and let several
+	threads insert and look up in parallel. Locking is left to the caller.
+*/
+
+#define SHARDS_MAX 1024
+#define SHARD_MIX 0x9E3779B97F4A7C15ULL // Fibonacci hashing constant, spreads identity int hashes over the high bits.
+
+typedef struct
+{
+	i_t num_shards, shard_bits;
+	h_t **shards;
+} sh_t;
+
+
+void mdict_sharded_delete(sh_t *s) {
+	if (s) {
+		for (i_t i = 0; i < s->num_shards; ++i)
+			mdict_delete_ht(s->shards[i]);
+		MDICT_FREE(s->shards);
+		MDICT_FREE(s);
+	}
+}
+
+
+sh_t *mdict_sharded_create(ht_param *param, i_t num_shards) {
+	/*
+	Creates a sharded table. num_shards is rounded up to a power of 2 and clamped to [1, SHARDS_MAX].
+	Returns NULL if the allocation fails.
+	*/
+
+	sh_t* s = (sh_t*) MDICT_CALLOC(1, sizeof(sh_t));
+	if (!s)
+		return NULL;
+
+	s->num_shards = 1;
+	while (s->num_shards < num_shards && s->num_shards < SHARDS_MAX) {
+		s->num_shards <<= 1;
+		s->shard_bits += 1;
+	}
+
+	s->shards = (h_t**) MDICT_CALLOC(s->num_shards, sizeof(h_t*));
+	if (!s->shards) {
+		MDICT_FREE(s);
+		return NULL;
+	}
+
+	for (i_t i = 0; i < s->num_shards; ++i) {
+		s->shards[i] = mdict_create(param);
+		if (!s->shards[i]) {
+			mdict_sharded_delete(s);
+			return NULL;
+		}
+	}
+
+	return s;
+}
+
+
+i_t mdict_shard_of(sh_t *s, kbox_t key_box) {
+	if (s->shard_bits == 0)
+		return 0;
+
+	uint64_t x = (uint64_t) _hash_func(s->shards[0], key_box) * SHARD_MIX;
+	return (i_t) (x >> (64 - s->shard_bits));
+}
+
+
+i_t mdict_sharded_size(sh_t *s) {
+	i_t size = 0;
+	for (i_t i = 0; i < s->num_shards; ++i)
+		size += s->shards[i]->size;
+	return size;
+}
+
+
+int mdict_sharded_partition(sh_t *s, kbox_t *keys, int64_t n, int64_t *order, int64_t *shard_start) {
+	/*
+	Groups the positions 0..n-1 of keys by shard (counting sort), so that a bulk operation can lock each shard
+	once. On return, order[shard_start[i] .. shard_start[i+1]) holds the positions of the keys of shard i.
+	shard_start must have room for num_shards + 1 entries. Returns -1 if the scratch allocation fails.
+	*/
+
+	i_t* shard_ids = (i_t*) MDICT_MALLOC(MAX(n, 1) * sizeof(i_t));
+	if (!shard_ids)
+		return -1;
+
+	memset(shard_start, 0, (s->num_shards + 1) * sizeof(int64_t));
+	for (int64_t j = 0; j < n; ++j) {
+		shard_ids[j] = mdict_shard_of(s, keys[j]);
+		shard_start[shard_ids[j] + 1] += 1;
+	}
+
+	for (i_t i = 0; i < s->num_shards; ++i)
+		shard_start[i+1] += shard_start[i];
+
+	for (int64_t j = 0; j < n; ++j)
+		order[shard_start[shard_ids[j]]++] = j;
+
+	for (i_t i = s->num_shards; i > 0; --i)
+		shard_start[i] = shard_start[i-1];
+	shard_start[0] = 0;
+
+	MDICT_FREE(shard_ids);
+	return 0;
+}
@@ -0,0 +1,293 @@
+
+/*
+	Shared memory hashtables.
+
+	A frozen table (see mdict_frozen.h) can be published into a named POSIX shared memory segment
+	and attached read-only from any number of processes. The attached table points straight into the
+	mapping, so its pages are shared between all processes instead of being copied on write.
+
+	Segment layout : an mdict_shm_header followed by the keys, vals, flags and offsets arrays, each
+	starting on a SHM_ALIGN boundary. The header magic is written last, so a segment that is still being
+	filled in is never accepted by mdict_shm_attach.
+
+	Publishing a new version under an existing name unlinks the old segment first : processes that
+	already attached it keep reading the old version until they detach, while later attaches get the
+	new one.
+*/
+
+#define SHM_MAGIC 0x3230544349444d4dULL // "MDICT02", whose slots are mixed by _frozen_slot
+#define SHM_ALIGN 64
+
+#define SHM_ALIGN_UP(x) (((x) + SHM_ALIGN - 1) & ~((uint64_t) SHM_ALIGN - 1))
+
+typedef struct
+{
+	volatile uint64_t magic;
+	int32_t key_type, val_type; // dtype_key and dtype_val of the publishing table
+	i_t size, num_slots, k_t_size, v_t_size, key_str_len, val_str_len, k_step_increment, v_step_increment, seed;
+	uint64_t keys_offset, vals_offset, flags_offset, offsets_offset, total_size;
+} mdict_shm_header;
+
+
+#if defined(_WIN32)
+
+#include <errno.h>
+
+int mdict_shm_publish(h_t *h, const char *name) {
+	errno = ENOSYS;
+	return -1;
+}
+
+h_t *mdict_shm_attach(const char *name) {
+	errno = ENOSYS;
+	return NULL;
+}
+
+void mdict_shm_detach(h_t *h) {
+}
+
+int mdict_shm_unlink(const char *name) {
+	errno = ENOSYS;
+	return -1;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+void _shm_layout(h_t *h, mdict_shm_header *hdr) {
+	i_t cap = MAX(h->size, 1);
+
+	hdr->keys_offset = SHM_ALIGN_UP(sizeof(mdict_shm_header));
+	hdr->vals_offset = SHM_ALIGN_UP(hdr->keys_offset + (uint64_t) cap * h->k_t_size);
+	hdr->flags_offset = SHM_ALIGN_UP(hdr->vals_offset + (uint64_t) cap * h->v_t_size);
+	hdr->offsets_offset = SHM_ALIGN_UP(hdr->flags_offset + (uint64_t) _flags_size(cap) * sizeof(i_t));
+	hdr->total_size = hdr->offsets_offset + (uint64_t) (h->ext->num_slots + 1) * sizeof(i_t);
+}
+
+
+int mdict_shm_publish(h_t *h, const char *name) {
+	/*
+	Writes the frozen table h into the shared memory segment called name, replacing any previous segment of
+	that name. Returns 0 on success and -1 with errno set otherwise.
+	*/
+
+	if (!h->is_frozen) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	mdict_shm_header hdr;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.key_type = dtype_key;
+	hdr.val_type = dtype_val;
+	hdr.size = h->size;
+	hdr.num_slots = h->ext->num_slots;
+	hdr.k_t_size = h->k_t_size;
+	hdr.v_t_size = h->v_t_size;
+	hdr.key_str_len = h->key_str_len;
+	hdr.val_str_len = h->val_str_len;
+	hdr.k_step_increment = h->k_step_increment;
+	hdr.v_step_increment = h->v_step_increment;
+	hdr.seed = h->seed;
+	_shm_layout(h, &hdr);
+
+	shm_unlink(name);
+	int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0)
+		return -1;
+
+	if (ftruncate(fd, (off_t) hdr.total_size) < 0) {
+		int err = errno;
+		close(fd);
+		shm_unlink(name);
+		errno = err;
+		return -1;
+	}
+
+	char* base = (char*) mmap(NULL, hdr.total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED) {
+		int err = errno;
+		shm_unlink(name);
+		errno = err;
+		return -1;
+	}
+
+	i_t cap = MAX(h->size, 1);
+	memcpy(base, &hdr, sizeof(hdr));
+	memcpy(base + hdr.keys_offset, h->keys, (size_t) cap * h->k_t_size);
+	memcpy(base + hdr.vals_offset, h->vals, (size_t) cap * h->v_t_size);
+	memcpy(base + hdr.flags_offset, h->flags, (size_t) _flags_size(cap) * sizeof(i_t));
+	memcpy(base + hdr.offsets_offset, h->ext->offsets, (size_t) (hdr.num_slots + 1) * sizeof(i_t));
+
+	__sync_synchronize();
+	((mdict_shm_header*) base)->magic = SHM_MAGIC;
+
+	munmap(base, hdr.total_size);
+	return 0;
+}
+
+
+bool _shm_array_fits(mdict_shm_header *hdr, uint64_t offset, uint64_t len) {
+	return offset >= sizeof(mdict_shm_header) && offset % SHM_ALIGN == 0 && offset <= hdr->total_size && len <= hdr->total_size - offset;
+}
+
+
+bool _shm_header_valid(mdict_shm_header *hdr) {
+	/*
+	Checks the header of a segment of this table type against the mapped hdr->total_size bytes : the sizes must be
+	those mdict_shm_publish writes and every array must lie within the segment, so that a corrupted segment is refused
+	instead of being read out of bounds. The slot offsets must rise from 0 to size, and the strings of a string side
+	must fit their blocks, which takes one pass over the offsets and one over the strings.
+	*/
+
+	if (hdr->size < 0 || hdr->num_slots < 1 || (hdr->num_slots & (hdr->num_slots - 1)) ||
+		hdr->k_step_increment < 1 || hdr->k_t_size != (int64_t) hdr->k_step_increment * (int64_t) sizeof(k_t) ||
+		hdr->v_step_increment < 1 || hdr->v_t_size != (int64_t) hdr->v_step_increment * (int64_t) sizeof(v_t))
+		return false;
+#if dtype_key == 5
+	if (hdr->key_str_len != hdr->k_t_size - str_len_SIZE)
+#else
+	if (hdr->key_str_len != 0)
+#endif
+		return false;
+#if dtype_val == 5
+	if (hdr->val_str_len != hdr->v_t_size - str_len_SIZE)
+#else
+	if (hdr->val_str_len != 0)
+#endif
+		return false;
+
+	uint64_t cap = MAX(hdr->size, 1);
+	if (!_shm_array_fits(hdr, hdr->keys_offset, cap * hdr->k_t_size) ||
+		!_shm_array_fits(hdr, hdr->vals_offset, cap * hdr->v_t_size) ||
+		!_shm_array_fits(hdr, hdr->flags_offset, (uint64_t) _flags_size(cap) * sizeof(i_t)) ||
+		!_shm_array_fits(hdr, hdr->offsets_offset, (uint64_t) (hdr->num_slots + 1) * sizeof(i_t)))
+		return false;
+
+	i_t* offsets = (i_t*) ((char*) hdr + hdr->offsets_offset);
+	if (offsets[0] != 0 || offsets[hdr->num_slots] != hdr->size)
+		return false;
+	for (i_t s = 0; s < hdr->num_slots; ++s) {
+		if (offsets[s] > offsets[s + 1]) // Rising from 0 to size, every offset lies within the keys and values.
+			return false;
+	}
+
+#if dtype_key == 5
+	char* keys = (char*) hdr + hdr->keys_offset;
+	for (i_t i = 0; i < hdr->size; ++i) {
+		if (_get_str_len(keys + (size_t) i * hdr->k_t_size) > hdr->key_str_len)
+			return false;
+	}
+#endif
+#if dtype_val == 5
+	char* vals = (char*) hdr + hdr->vals_offset;
+	for (i_t i = 0; i < hdr->size; ++i) {
+		if (_get_str_len(vals + (size_t) i * hdr->v_t_size) > hdr->val_str_len)
+			return false;
+	}
+#endif
+	return true;
+}
+
+
+h_t *mdict_shm_attach(const char *name) {
+	/*
+	Maps the segment called name read-only and returns a frozen table backed by it. Returns NULL with errno set
+	on failure : EINVAL if the segment is not a (fully published) microdict segment or if its header is not
+	consistent with its size, and EPROTOTYPE if it holds a different key/value type.
+	*/
+
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return NULL;
+
+	struct stat st;
+	if (fstat(fd, &st) < 0) {
+		int err = errno;
+		close(fd);
+		errno = err;
+		return NULL;
+	}
+
+	if ((size_t) st.st_size < sizeof(mdict_shm_header)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	char* base = (char*) mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		return NULL;
+
+	mdict_shm_header* hdr = (mdict_shm_header*) base;
+	int err = 0;
+	if (hdr->magic != SHM_MAGIC || hdr->total_size != (uint64_t) st.st_size)
+		err = EINVAL;
+	else if (hdr->key_type != dtype_key || hdr->val_type != dtype_val)
+		err = EPROTOTYPE;
+	else if (!_shm_header_valid(hdr))
+		err = EINVAL;
+
+	h_t* h = NULL;
+	if (!err && !(h = (h_t*) MDICT_CALLOC(1, sizeof(h_t))))
+		err = ENOMEM;
+	if (!err && !mdict_ext(h)) {
+		MDICT_FREE(h);
+		err = ENOMEM;
+	}
+
+	if (err) {
+		munmap(base, st.st_size);
+		errno = err;
+		return NULL;
+	}
+
+	__sync_synchronize();
+	h->size = hdr->size;
+	h->num_buckets = hdr->size;
+	h->upper_bound = hdr->size;
+	h->ext->num_slots = hdr->num_slots;
+	while ((1 << h->ext->slot_bits) < hdr->num_slots)
+		h->ext->slot_bits += 1;
+	h->k_t_size = hdr->k_t_size;
+	h->v_t_size = hdr->v_t_size;
+	h->key_str_len = hdr->key_str_len;
+	h->val_str_len = hdr->val_str_len;
+	h->k_step_increment = hdr->k_step_increment;
+	h->v_step_increment = hdr->v_step_increment;
+	h->seed = hdr->seed;
+	h->keys = (k_t*) (base + hdr->keys_offset);
+	h->vals = (v_t*) (base + hdr->vals_offset);
+	h->flags = (i_t*) (base + hdr->flags_offset);
+	h->ext->offsets = (i_t*) (base + hdr->offsets_offset);
+	h->is_map = true;
+	h->is_frozen = true;
+	h->ext->shm_base = base;
+	h->ext->shm_size = st.st_size;
+	return h;
+}
+
+
+void mdict_shm_detach(h_t *h) {
+	/*
+	Unmaps the segment backing an attached table. The h_t itself is freed by mdict_delete_ht.
+	*/
+
+	munmap(h->ext->shm_base, h->ext->shm_size);
+	h->ext->shm_base = NULL;
+}
+
+
+int mdict_shm_unlink(const char *name) {
+	return shm_unlink(name);
+}
+
+#endif
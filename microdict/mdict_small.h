@@ -0,0 +1,163 @@
+
+/*
+	Small table layout.
+
+	A freshly created table starts small : up to SMALL_MAX items are kept in keys and vals arrays
+	that share a single block with the flags word, a lookup being a scan over all of them. There is
+	no psl array and the flags bitmap is a single word, kept with the usual meaning so that the
+	iteration and export code works unchanged on small tables. This brings an empty or tiny table
+	down to the h_t and one block of about a hundred bytes, instead of four arrays sized for 32
+	buckets. The block starts with the keys array, so h->keys is what gets freed.
+
+	The first insert that does not fit makes mdict_resize move the items into ordinary 32 bucket
+	arrays and free the block. The table never goes back to the small layout.
+*/
+
+#define SMALL_MAX 8
+
+
+static size_t _small_offset(i_t k_t_size, i_t v_t_size, int array) {
+	/*
+	Byte offset within the block of the keys (array 0), vals (1) and flags (2) arrays.
+	*/
+
+	size_t keys_bytes = SMALL_MAX * (size_t) k_t_size;
+	size_t vals_bytes = SMALL_MAX * (size_t) v_t_size;
+	if (array == 0)
+		return 0;
+	if (array == 1)
+		return keys_bytes;
+	return (keys_bytes + vals_bytes + 7) & ~(size_t) 7;
+}
+
+
+size_t mdict_small_bytes(h_t *h) {
+	return _small_offset(h->k_t_size, h->v_t_size, 2) + sizeof(i_t);
+}
+
+
+h_t *mdict_small_create(h_t *h) {
+	/*
+	Allocates the block of the small arrays for h (whose size fields have been set up) and switches it to the
+	small layout. Returns NULL and frees h if the allocation fails.
+	*/
+
+	char *base = (char *) MDICT_CALLOC(1, mdict_small_bytes(h));
+	if (!base) {
+		MDICT_FREE(h);
+		return NULL;
+	}
+
+	h->keys = (k_t*) (base + _small_offset(h->k_t_size, h->v_t_size, 0));
+	h->vals = (v_t*) (base + _small_offset(h->k_t_size, h->v_t_size, 1));
+	h->flags = (i_t*) (base + _small_offset(h->k_t_size, h->v_t_size, 2));
+	h->flags[0] = (i_t) 0xffffffff;
+	h->psl = NULL;
+	h->num_buckets = SMALL_MAX;
+	h->upper_bound = SMALL_MAX;
+	h->is_small = true;
+	return h;
+}
+
+
+int mdict_small_upgrade(h_t *h) {
+	/*
+	mdict_resize for small tables : moves the items into newly allocated 32 bucket arrays. Returns -1 if
+	an allocation fails, in which case the table is left unchanged.
+	*/
+
+	h_t n = *h;
+	n.ext = NULL; // n is a plain hashed table.
+	n.is_small = false;
+	n.size = 0;
+	n.num_buckets = 32;
+	n.upper_bound = (i_t)(32 * PEAK_LOAD);
+	n.keys = (k_t*) MDICT_MALLOC(32 * h->k_t_size);
+	n.vals = h->is_map ? (v_t*) MDICT_MALLOC(32 * h->v_t_size) : NULL;
+	n.flags = (i_t*) MDICT_MALLOC(_flags_size(32) * sizeof(i_t));
+	n.psl = (i_t*) MDICT_CALLOC(_flags_size(32), sizeof(i_t));
+
+	if (!n.keys || (h->is_map && !n.vals) || !n.flags || !n.psl) {
+		MDICT_FREE((void *)n.keys);
+		MDICT_FREE((void *)n.vals);
+		MDICT_FREE(n.flags);
+		MDICT_FREE(n.psl);
+		return -1;
+	}
+
+	memset(n.flags, 0xff, _flags_size(32) * sizeof(i_t));
+
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		vbox_t val = {0}; // Not read by mdict_set if h is a set.
+		if (h->is_map)
+			val = _get_val(h, GET_PTR(j, h->v_step_increment));
+		mdict_set(&n, _get_key(h, GET_PTR(j, h->k_step_increment)), val);
+	}
+
+	MDICT_FREE((void *)h->keys); // The block of the small arrays
+
+	h->keys = n.keys;
+	h->vals = n.vals;
+	h->flags = n.flags;
+	h->psl = n.psl;
+	h->num_buckets = n.num_buckets;
+	h->upper_bound = n.upper_bound;
+	h->is_small = false;
+	return 0;
+}
+
+
+inline vbox_t mdict_small_get_map(h_t *h, kbox_t key_box, i_t *ret_idx) {
+	uint32_t match = 0;
+	vbox_t val = {0}; // Returned on a miss.
+
+#if dtype_key == 5
+	i_t k_step_inc = h->k_step_increment;
+	for (i_t i = _flags_next_occupied(h->flags, 0, SMALL_MAX); i < SMALL_MAX; i = _flags_next_occupied(h->flags, i + 1, SMALL_MAX)) {
+		if (_key_equal(h, GET_PTR(i, k_step_inc), key_box)) {
+			match = 1u << i;
+			break;
+		}
+	}
+#else
+	// Branch free so that the compiler turns it into a handful of vector compares.
+	for (i_t i = 0; i < SMALL_MAX; ++i)
+		match |= (uint32_t) (h->keys[i] == key_box) << i;
+	match &= ~(uint32_t) h->flags[0];
+#endif
+
+	if (!match) {
+		*ret_idx = h->num_buckets;
+		return val;
+	}
+
+	i_t idx = _ctz32(match);
+	*ret_idx = idx;
+	return _get_val(h, GET_PTR(idx, h->v_step_increment));
+}
+
+
+inline int mdict_small_set(h_t *h, kbox_t key_box, vbox_t val_box) {
+	/*
+	mdict_set for small tables that have room left or already hold key_box.
+	*/
+
+	i_t idx;
+	mdict_small_get_map(h, key_box, &idx);
+
+	int ret_val = 0;
+	if (idx == h->num_buckets) {
+		idx = _ctz32((uint32_t) h->flags[0]);
+		_set_key(h, GET_PTR(idx, h->k_step_increment), key_box);
+		_flags_setFalse_isempty(h->flags, idx);
+		++h->size;
+		++h->version;
+		ret_val = 1;
+	}
+
+	if (h->is_map) {
+		_set_val(h, GET_PTR(idx, h->v_step_increment), val_box);
+	}
+
+	return ret_val;
+}
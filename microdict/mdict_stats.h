@@ -0,0 +1,124 @@
+
+/*
+	Table statistics.
+
+	The stats() method of the bindings reports the figures below. Everything is computed on demand from the h_t
+	except for num_resizes and rehash_ns, which mdict_resize keeps up to date at the cost of two clock reads per
+	resize. When compiled with MDICT_STATS defined, mdict_get_map and mdict_set also count their calls and probe
+	steps in the hashed layout, which costs a couple of increments per call and is therefore off by default.
+	mdict_sizeof, behind the __sizeof__ method of the bindings, adds the arrays up with the h_t itself.
+*/
+
+#define MDICT_NUM_ARRAYS 9
+
+const char *mdict_array_names[MDICT_NUM_ARRAYS] = {"keys", "vals", "flags", "psl", "offsets", "index", "lru_links", "ref_bits", "expiry"};
+
+
+const char *mdict_layout_name(h_t *h) {
+	if (h->is_frozen)
+		return "frozen";
+	if (h->is_small)
+		return "small";
+	if (h->is_direct)
+		return "direct";
+	if (h->is_ordered)
+		return "ordered";
+	return "hashed";
+}
+
+
+void mdict_array_bytes(h_t *h, size_t *bytes) {
+	/*
+	Sets bytes[i] to the size of the array called mdict_array_names[i], or to 0 if h does not have that array. The
+	arrays retired by the seqlock mode are not counted.
+	*/
+
+	size_t n = h->is_frozen ? MAX(h->num_buckets, 1) : h->num_buckets, words = (size_t) _flags_size(n);
+
+	bytes[0] = n * h->k_t_size;
+	bytes[1] = h->is_map ? n * h->v_t_size : 0;
+	bytes[2] = words * sizeof(i_t);
+	bytes[3] = h->psl ? words * sizeof(i_t) : 0;
+	bytes[4] = _ext(h, offsets) ? ((size_t) h->ext->num_slots + 1) * sizeof(i_t) : 0;
+	bytes[5] = _ext(h, index) ? (size_t) h->ext->index_size * h->ext->index_width : 0;
+	bytes[6] = _ext(h, lru_links) ? 2 * n * sizeof(i_t) : 0;
+	bytes[7] = _ext(h, ref_bits) ? words * sizeof(i_t) : 0;
+	bytes[8] = _ext(h, expiry) ? n * sizeof(uint64_t) : 0;
+}
+
+
+size_t mdict_sizeof(h_t *h) {
+	/*
+	Returns the number of bytes allocated for h : the h_t, its extension and every array. The arrays of a table
+	attached from shared memory are counted as the size of the mapping, and the arrays retired by the seqlock mode
+	(which add up to less than the current ones) are not counted.
+	*/
+
+	size_t bytes[MDICT_NUM_ARRAYS], total = sizeof(h_t) + (h->ext ? sizeof(h_ext_t) : 0);
+
+	if (_ext(h, shm_base))
+		return total + h->ext->shm_size;
+	if (h->is_small)
+		return total + mdict_small_bytes(h); // The arrays share one block.
+
+	mdict_array_bytes(h, bytes);
+	for (int a = 0; a < MDICT_NUM_ARRAYS; ++a)
+		total += bytes[a];
+	return total;
+}
+
+
+i_t mdict_probe_length(h_t *h, i_t idx) {
+	/*
+	Returns the number of probe steps that lead from the home bucket of the item in bucket idx to idx. Only valid for
+	the hashed layout.
+	*/
+
+	i_t mask = h->num_buckets - 1, step = 0;
+	i_t pos = _hash_func(h, _get_key(h, GET_PTR(idx, h->k_step_increment))) & mask;
+
+	while (pos != idx)
+		pos = (pos + (++step)) & mask;
+	return step;
+}
+
+
+int mdict_probe_histogram(h_t *h, i_t **hist, i_t *len) {
+	/*
+	Sets *hist to a newly allocated array of *len counts, where (*hist)[s] is the number of items found after s probe
+	steps, *len being the longest probe length plus one. Layouts that do not probe give *hist = NULL and *len = 0.
+	Returns -1 if the allocation fails.
+	*/
+
+	*hist = NULL;
+	*len = 0;
+	if (h->is_frozen || !h->psl || h->size == 0)
+		return 0;
+
+	i_t max_psl = 0;
+	for (i_t g = 0; g < _flags_size(h->num_buckets); ++g)
+		max_psl = MAX(max_psl, h->psl[g]);
+
+	*hist = (i_t*) MDICT_CALLOC((size_t) max_psl + 1, sizeof(i_t));
+	if (!*hist)
+		return -1;
+	*len = max_psl + 1;
+
+	for (i_t i = _flags_next_occupied(h->flags, 0, h->num_buckets); i < h->num_buckets; i = _flags_next_occupied(h->flags, i + 1, h->num_buckets)) {
+		i_t s = mdict_probe_length(h, i);
+		if (s >= *len) { // The psl values are upper bounds, which rehashing does not have to maintain exactly.
+			i_t *grown = (i_t*) MDICT_REALLOC(*hist, ((size_t) s + 1) * sizeof(i_t));
+			if (!grown) {
+				MDICT_FREE(*hist);
+				*hist = NULL;
+				*len = 0;
+				return -1;
+			}
+			memset(grown + *len, 0, ((size_t) s + 1 - *len) * sizeof(i_t));
+			*hist = grown;
+			*len = s + 1;
+		}
+		++(*hist)[s];
+	}
+	return 0;
+}
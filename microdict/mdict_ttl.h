@@ -0,0 +1,256 @@
+
+/*
+	Per item expiration (TTL) mode.
+
+	mdict_ttl_enable gives the table an expiry array beside vals : expiry[i] is the time (in nanoseconds of
+	mdict_now_ns) after which the item in bucket i is expired, 0 meaning that it never expires. mdict_set
+	resets the expiry of the bucket it writes to 0 and mdict_ttl_expire_at sets it afterwards.
+
+	Expired items are reclaimed lazily :
+	- mdict_get_map and mdict_set reclaim the expired item they find, so setting an expired key inserts it anew.
+	- mdict_set examines EXPIRE_STEP more buckets, round robin, and removes the expired items among them. A bounded
+	  table (see mdict_evict.h) sweeps the expired items before evicting a live one.
+	- mdict_resize drops the expired items while moving the others into the new arrays.
+	- mdict_expire sweeps the whole table, unless no item can have expired yet (see next_expiry).
+	Until then an expired item is still counted by h->size, which is why the bindings call mdict_expire before
+	reporting the size of the table.
+
+	Reclaiming an item changes h->version, which invalidates the iterators of the bindings. While h->ext->expire_holds
+	is nonzero (an export or an iteration is running), mdict_get_map and the steps of mdict_set leave the expired items
+	in place, and the bindings defer their calls to mdict_expire.
+
+	Only the hashed layout supports expiration : small tables are upgraded when it is enabled, while frozen,
+	ordered, direct and seqlocked tables are refused.
+*/
+
+#define EXPIRE_STEP 2
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+uint64_t mdict_now_ns(void) {
+	return (uint64_t) GetTickCount64() * 1000000;
+}
+
+#else
+
+uint64_t mdict_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+#endif
+
+
+int mdict_ttl_enable(h_t *h) {
+	/*
+	Returns 0 on success (or if expiration is already enabled), -1 if an allocation fails and -2 if the layout of
+	h does not support expiration.
+	*/
+
+	if (_ext(h, expiry))
+		return 0;
+	if (h->is_frozen || h->is_ordered || h->is_direct || h->is_seqlocked)
+		return -2;
+	if (_ext(h, max_bytes)) {
+		h_t t = *h;
+		h_ext_t x = *h->ext;
+		x.expiry = (uint64_t*) h; // Only tested for being non NULL.
+		t.ext = &x;
+		if (mdict_table_bytes(&t, h->is_small ? 32 : h->num_buckets) > x.max_bytes)
+			return -1; // The expiry array does not fit the memory budget.
+	}
+	if (h->is_small && mdict_small_upgrade(h) < 0)
+		return -1;
+
+	h_ext_t *x = mdict_ext(h);
+	if (!x)
+		return -1;
+	x->expiry = (uint64_t*) MDICT_CALLOC(h->num_buckets, sizeof(uint64_t));
+	if (!x->expiry)
+		return -1;
+	x->expire_hand = 0;
+	x->next_expiry = UINT64_MAX;
+	return 0;
+}
+
+
+inline bool _is_expired(h_t *h, i_t idx) {
+	uint64_t *expiry = h->ext->expiry;
+	return expiry[idx] && expiry[idx] <= mdict_now_ns();
+}
+
+
+inline void _expire_bucket(h_t *h, i_t idx) {
+	_flags_setTrue_isempty(h->flags, idx);
+	h->has_holes = true;
+	--h->size;
+	++h->version;
+	if (h->ext->policy)
+		_evict_remove(h, idx);
+}
+
+
+inline void _expire_step(h_t *h) {
+	/*
+	Reclaims the expired items among the next EXPIRE_STEP buckets.
+	*/
+
+	h_ext_t *x = h->ext;
+	i_t mask = h->num_buckets - 1;
+	for (int s = 0; s < EXPIRE_STEP; ++s) {
+		i_t i = x->expire_hand;
+		x->expire_hand = (i + 1) & mask;
+		if (!_flags_isempty(h->flags, i) && _is_expired(h, i))
+			_expire_bucket(h, i);
+	}
+}
+
+
+void mdict_ttl_expire_at(h_t *h, kbox_t key_box, uint64_t expires_at) {
+	/*
+	Makes the item key_box, which must be present, expire at expires_at (see mdict_now_ns). 0 means never.
+	*/
+
+	i_t idx;
+	mdict_get_map(h, key_box, &idx);
+	if (idx != h->num_buckets) {
+		h->ext->expiry[idx] = expires_at;
+		if (expires_at && expires_at < h->ext->next_expiry)
+			h->ext->next_expiry = expires_at;
+	}
+}
+
+
+i_t mdict_expire(h_t *h) {
+	/*
+	Removes every expired item and returns how many were removed. Does nothing unless expiration is enabled.
+	*/
+
+	h_ext_t *x = h->ext;
+	if (!x || !x->expiry)
+		return 0;
+
+	uint64_t now = mdict_now_ns();
+	if (now < x->next_expiry)
+		return 0;
+
+	i_t removed = 0;
+	x->next_expiry = UINT64_MAX;
+
+	for (i_t i = _flags_next_occupied(h->flags, 0, h->num_buckets); i < h->num_buckets; i = _flags_next_occupied(h->flags, i + 1, h->num_buckets)) {
+		if (!x->expiry[i])
+			continue;
+		if (x->expiry[i] <= now) {
+			_expire_bucket(h, i);
+			++removed;
+		} else if (x->expiry[i] < x->next_expiry) {
+			x->next_expiry = x->expiry[i];
+		}
+	}
+
+	while (h->size <= (h->num_buckets >> 2) && h->num_buckets > 32 && !x->policy) {
+		if (mdict_resize(h, false) < 0)
+			break;
+	}
+
+	return removed;
+}
+
+
+int mdict_ttl_resize(h_t *h, bool to_expand) {
+	/*
+	mdict_resize for tables with expiration : moves the items that have not expired, along with their expiry, into
+	newly allocated arrays. Returns -1 if an allocation fails, in which case the table is left unchanged.
+	*/
+
+	i_t new_num_buckets = to_expand ? h->num_buckets << 1 : h->num_buckets >> 1;
+	if (new_num_buckets < 32)
+		new_num_buckets = 32;
+
+	h_t n = *h;
+	n.num_buckets = new_num_buckets;
+	n.keys = (k_t*) MDICT_MALLOC(new_num_buckets * h->k_t_size);
+	n.vals = h->is_map ? (v_t*) MDICT_MALLOC(new_num_buckets * h->v_t_size) : NULL;
+	n.flags = (i_t*) MDICT_MALLOC(_flags_size(new_num_buckets) * sizeof(i_t));
+	n.psl = (i_t*) MDICT_CALLOC(_flags_size(new_num_buckets), sizeof(i_t));
+	uint64_t *expiry = h->ext->expiry, *new_expiry = (uint64_t*) MDICT_CALLOC(new_num_buckets, sizeof(uint64_t));
+
+	if (!n.keys || (h->is_map && !n.vals) || !n.flags || !n.psl || !new_expiry) {
+		MDICT_FREE((void *)n.keys);
+		MDICT_FREE((void *)n.vals);
+		MDICT_FREE(n.flags);
+		MDICT_FREE(n.psl);
+		MDICT_FREE(new_expiry);
+		return -1;
+	}
+
+	memset(n.flags, 0xff, _flags_size(new_num_buckets) * sizeof(i_t));
+
+	i_t mask = new_num_buckets - 1, size = 0;
+	uint64_t now = mdict_now_ns();
+
+	for (i_t j = _flags_next_occupied(h->flags, 0, h->num_buckets); j < h->num_buckets; j = _flags_next_occupied(h->flags, j + 1, h->num_buckets)) {
+		if (expiry[j] && expiry[j] <= now)
+			continue;
+
+		i_t i = _hash_func(h, _get_key(h, GET_PTR(j, h->k_step_increment))) & mask, last = i, step = 0;
+		while (!_flags_isempty(n.flags, i))
+			i = (i + (++step)) & mask;
+		_flags_setFalse_isempty(n.flags, i);
+		if (step > _get_psl(n.psl, last))
+			_set_psl(n.psl, last, step);
+
+		memcpy((char *) n.keys + (size_t) i * h->k_t_size, (char *) h->keys + (size_t) j * h->k_t_size, h->k_t_size);
+		if (h->is_map)
+			memcpy((char *) n.vals + (size_t) i * h->v_t_size, (char *) h->vals + (size_t) j * h->v_t_size, h->v_t_size);
+		new_expiry[i] = expiry[j];
+		++size;
+	}
+
+	MDICT_FREE((void *)h->keys);
+	MDICT_FREE((void *)h->vals);
+	MDICT_FREE(h->flags);
+	MDICT_FREE(h->psl);
+	MDICT_FREE(expiry);
+
+	if (size != h->size)
+		++h->version;
+
+	h->keys = n.keys;
+	h->vals = n.vals;
+	h->flags = n.flags;
+	h->psl = n.psl;
+	h->ext->expiry = new_expiry;
+	h->ext->expire_hand = 0;
+	h->has_holes = false;
+	h->size = size;
+	h->num_buckets = new_num_buckets;
+	h->upper_bound = (i_t)(new_num_buckets * PEAK_LOAD);
+	return 0;
+}
+
+
+int mdict_ttl_copy(h_t *dst, h_t *src) {
+	/*
+	Copies the expiry of the items of src onto the same keys of dst, which must hold them all. Returns -1 if
+	enabling expiration on dst fails.
+	*/
+
+	if (!_ext(src, expiry))
+		return 0;
+	if (mdict_ttl_enable(dst) < 0)
+		return -1;
+
+	for (i_t j = _flags_next_occupied(src->flags, 0, src->num_buckets); j < src->num_buckets; j = _flags_next_occupied(src->flags, j + 1, src->num_buckets)) {
+		i_t idx;
+		mdict_get_map(dst, _get_key(src, GET_PTR(j, src->k_step_increment)), &idx);
+		if (idx != dst->num_buckets)
+			dst->ext->expiry[idx] = src->ext->expiry[j];
+	}
+	dst->ext->next_expiry = MIN(dst->ext->next_expiry, src->ext->next_expiry);
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+#ifndef MICRODICT_API_H
+#define MICRODICT_API_H
+
+#include <Python.h>
+#include <stdint.h>
+
+/*
+	C API of the microdict types, for other C extensions (and Cython, see microdict_api.pxd). It reads and modifies
+	live microdict objects without going through the Python mapping protocol : keys and values are passed as native
+	integers or UTF-8 strings, never boxed into Python objects.
+
+	Every type module exports a table of function pointers in a PyCapsule called _C_API. Fetch it once, e.g. in the
+	init function of your module, with microdict_import_i64_i64() and friends, which return NULL with an exception set
+	if microdict is not installed or was built against a different version of this header :
+
+		static MicrodictAPI_i64_i64* mdict_api;
+		...
+		mdict_api = microdict_import_i64_i64();
+		if (!mdict_api)
+			return NULL;
+
+		if (PyObject_TypeCheck(obj, mdict_api->type)) {
+			int64_t val;
+			if (mdict_api->get(obj, 42, &val))
+				...
+		}
+
+	The include directory is given by microdict.get_include(). The functions must be called with the GIL held, on
+	objects whose type is (a subtype of) table->type, which the functions do not check. They behave like their Python
+	counterparts :
+
+	create()                              returns a new empty microdict, or NULL with an exception set.
+	get(d, key, &val)                     returns 1 and sets val if key is present, 0 otherwise.
+	set(d, key, val)                      d[key] = val. Returns 0, or -1 with an exception set (e.g. d is frozen).
+	del(d, key, &val)                     d.pop(key) : returns 1 and sets val (unless NULL) if key was present, 0 if
+	                                      absent, -1 with an exception set if d can not be modified.
+	get_many(d, keys, vals, n, default)   looks up keys[0..n), writing the values (or default) into vals. Returns the
+	                                      number of keys found.
+	next(d, &pos, &key, &val)             iterates like PyDict_Next : start with pos = 0 and call it until it returns
+	                                      0. d must not be modified in between.
+	size(d)                               len(d).
+
+	Every pair of integer types has its table. str:str has the one below, while the mixed str:i64 and i64:str types
+	do not export a C API.
+
+	For str:str, create takes the maximum key and value lengths, and keys and values are (pointer, length in bytes)
+	pairs. del does not return the value, and get_many sets the value pointers of the absent keys to NULL. The value
+	pointers returned by get, get_many and next point into the table and stay valid until it is next modified. Keys
+	and values longer than the maximum lengths of the microdict can not be present (get returns 0) and can not be set
+	(set raises a TypeError).
+*/
+
+// Bumped whenever the tables or their semantics change. 2 : the modules moved to the _mdict_c package, and set
+// range-checks the values (it used to truncate them).
+#define MICRODICT_API_VERSION 2
+
+
+#define MICRODICT_DECLARE_INT_API(NAME, K, V)                                                                \
+    typedef struct {                                                                                        \
+        int version;                                                                                        \
+        PyTypeObject* type;                                                                                 \
+        PyObject* (*create)(void);                                                                          \
+        int (*get)(PyObject* d, K key, V* val);                                                             \
+        int (*set)(PyObject* d, K key, V val);                                                              \
+        int (*del)(PyObject* d, K key, V* val);                                                             \
+        Py_ssize_t (*get_many)(PyObject* d, const K* keys, V* vals, Py_ssize_t n, V default_val);           \
+        int (*next)(PyObject* d, Py_ssize_t* pos, K* key, V* val);                                          \
+        Py_ssize_t (*size)(PyObject* d);                                                                    \
+    } MicrodictAPI_##NAME;                                                                                  \
+                                                                                                            \
+    static inline MicrodictAPI_##NAME* microdict_import_##NAME(void) {                                      \
+        return (MicrodictAPI_##NAME*) microdict_import_api("_mdict_c." #NAME);                              \
+    }
+
+
+static inline void* microdict_import_api(const char* module_name) {
+    /*
+    Imports module_name and returns the pointer held by its _C_API capsule, or NULL with an exception set.
+    */
+
+    char capsule_name[64];
+    PyObject* module = PyImport_ImportModule(module_name); // PyCapsule_Import does not import submodules by itself.
+    if (!module)
+        return NULL;
+    Py_DECREF(module);
+
+    snprintf(capsule_name, sizeof(capsule_name), "%s._C_API", module_name);
+    int* api = (int*) PyCapsule_Import(capsule_name, 0);
+    if (api && *api != MICRODICT_API_VERSION) {
+        PyErr_Format(PyExc_ImportError, "%s exports version %d of the microdict C API, version %d was expected", module_name, *api, MICRODICT_API_VERSION);
+        return NULL;
+    }
+    return api;
+}
+
+
+// One table per pair of integer types, e.g. MicrodictAPI_u32_i16 for u32 keys and i16 values.
+#define MICRODICT_DECLARE_INT_APIS(KEY, K)                                                                  \
+    MICRODICT_DECLARE_INT_API(KEY##_i16, K, int16_t)                                                        \
+    MICRODICT_DECLARE_INT_API(KEY##_u16, K, uint16_t)                                                       \
+    MICRODICT_DECLARE_INT_API(KEY##_i32, K, int32_t)                                                        \
+    MICRODICT_DECLARE_INT_API(KEY##_u32, K, uint32_t)                                                       \
+    MICRODICT_DECLARE_INT_API(KEY##_i64, K, int64_t)                                                        \
+    MICRODICT_DECLARE_INT_API(KEY##_u64, K, uint64_t)
+
+MICRODICT_DECLARE_INT_APIS(i16, int16_t)
+MICRODICT_DECLARE_INT_APIS(u16, uint16_t)
+MICRODICT_DECLARE_INT_APIS(i32, int32_t)
+MICRODICT_DECLARE_INT_APIS(u32, uint32_t)
+MICRODICT_DECLARE_INT_APIS(i64, int64_t)
+MICRODICT_DECLARE_INT_APIS(u64, uint64_t)
+
+
+typedef struct {
+    int version;
+    PyTypeObject* type;
+    PyObject* (*create)(Py_ssize_t key_len, Py_ssize_t val_len);
+    int (*get)(PyObject* d, const char* key, Py_ssize_t key_len, const char** val, Py_ssize_t* val_len);
+    int (*set)(PyObject* d, const char* key, Py_ssize_t key_len, const char* val, Py_ssize_t val_len);
+    int (*del)(PyObject* d, const char* key, Py_ssize_t key_len);
+    Py_ssize_t (*get_many)(PyObject* d, const char* const* keys, const Py_ssize_t* key_lens, const char** vals, Py_ssize_t* val_lens, Py_ssize_t n);
+    int (*next)(PyObject* d, Py_ssize_t* pos, const char** key, Py_ssize_t* key_len, const char** val, Py_ssize_t* val_len);
+    Py_ssize_t (*size)(PyObject* d);
+} MicrodictAPI_str_str;
+
+static inline MicrodictAPI_str_str* microdict_import_str_str(void) {
+    return (MicrodictAPI_str_str*) microdict_import_api("_mdict_c.str_str");
+}
+
+#endif
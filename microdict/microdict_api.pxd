@@ -0,0 +1,460 @@
+# Cython declarations of the microdict C API, see microdict_api.h. Put microdict.get_include() on the include path
+# and cimport it :
+#
+#     from microdict_api cimport MicrodictAPI_i64_i64, microdict_import_i64_i64
+#
+#     cdef MicrodictAPI_i64_i64* api = microdict_import_i64_i64()
+#     cdef int64_t val
+#     if api.get(d, 42, &val):
+#         ...
+
+from cpython.object cimport PyTypeObject
+from libc.stdint cimport int16_t, uint16_t, int32_t, uint32_t, int64_t, uint64_t
+
+cdef extern from "microdict_api.h":
+    int MICRODICT_API_VERSION
+
+    ctypedef struct MicrodictAPI_i16_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, int16_t* val)
+        int (*set)(object d, int16_t key, int16_t val) except -1
+        int (*delete "del")(object d, int16_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i16_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, uint16_t* val)
+        int (*set)(object d, int16_t key, uint16_t val) except -1
+        int (*delete "del")(object d, int16_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i16_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, int32_t* val)
+        int (*set)(object d, int16_t key, int32_t val) except -1
+        int (*delete "del")(object d, int16_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i16_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, uint32_t* val)
+        int (*set)(object d, int16_t key, uint32_t val) except -1
+        int (*delete "del")(object d, int16_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i16_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, int64_t* val)
+        int (*set)(object d, int16_t key, int64_t val) except -1
+        int (*delete "del")(object d, int16_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i16_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int16_t key, uint64_t* val)
+        int (*set)(object d, int16_t key, uint64_t val) except -1
+        int (*delete "del")(object d, int16_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int16_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int16_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, int16_t* val)
+        int (*set)(object d, uint16_t key, int16_t val) except -1
+        int (*delete "del")(object d, uint16_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, uint16_t* val)
+        int (*set)(object d, uint16_t key, uint16_t val) except -1
+        int (*delete "del")(object d, uint16_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, int32_t* val)
+        int (*set)(object d, uint16_t key, int32_t val) except -1
+        int (*delete "del")(object d, uint16_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, uint32_t* val)
+        int (*set)(object d, uint16_t key, uint32_t val) except -1
+        int (*delete "del")(object d, uint16_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, int64_t* val)
+        int (*set)(object d, uint16_t key, int64_t val) except -1
+        int (*delete "del")(object d, uint16_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u16_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint16_t key, uint64_t* val)
+        int (*set)(object d, uint16_t key, uint64_t val) except -1
+        int (*delete "del")(object d, uint16_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint16_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint16_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, int16_t* val)
+        int (*set)(object d, int32_t key, int16_t val) except -1
+        int (*delete "del")(object d, int32_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, uint16_t* val)
+        int (*set)(object d, int32_t key, uint16_t val) except -1
+        int (*delete "del")(object d, int32_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, int32_t* val)
+        int (*set)(object d, int32_t key, int32_t val) except -1
+        int (*delete "del")(object d, int32_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, uint32_t* val)
+        int (*set)(object d, int32_t key, uint32_t val) except -1
+        int (*delete "del")(object d, int32_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, int64_t* val)
+        int (*set)(object d, int32_t key, int64_t val) except -1
+        int (*delete "del")(object d, int32_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i32_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int32_t key, uint64_t* val)
+        int (*set)(object d, int32_t key, uint64_t val) except -1
+        int (*delete "del")(object d, int32_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int32_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int32_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, int16_t* val)
+        int (*set)(object d, uint32_t key, int16_t val) except -1
+        int (*delete "del")(object d, uint32_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, uint16_t* val)
+        int (*set)(object d, uint32_t key, uint16_t val) except -1
+        int (*delete "del")(object d, uint32_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, int32_t* val)
+        int (*set)(object d, uint32_t key, int32_t val) except -1
+        int (*delete "del")(object d, uint32_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, uint32_t* val)
+        int (*set)(object d, uint32_t key, uint32_t val) except -1
+        int (*delete "del")(object d, uint32_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, int64_t* val)
+        int (*set)(object d, uint32_t key, int64_t val) except -1
+        int (*delete "del")(object d, uint32_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u32_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint32_t key, uint64_t* val)
+        int (*set)(object d, uint32_t key, uint64_t val) except -1
+        int (*delete "del")(object d, uint32_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint32_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint32_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, int16_t* val)
+        int (*set)(object d, int64_t key, int16_t val) except -1
+        int (*delete "del")(object d, int64_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, uint16_t* val)
+        int (*set)(object d, int64_t key, uint16_t val) except -1
+        int (*delete "del")(object d, int64_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, int32_t* val)
+        int (*set)(object d, int64_t key, int32_t val) except -1
+        int (*delete "del")(object d, int64_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, uint32_t* val)
+        int (*set)(object d, int64_t key, uint32_t val) except -1
+        int (*delete "del")(object d, int64_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, int64_t* val)
+        int (*set)(object d, int64_t key, int64_t val) except -1
+        int (*delete "del")(object d, int64_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_i64_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, int64_t key, uint64_t* val)
+        int (*set)(object d, int64_t key, uint64_t val) except -1
+        int (*delete "del")(object d, int64_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const int64_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, int64_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_i16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, int16_t* val)
+        int (*set)(object d, uint64_t key, int16_t val) except -1
+        int (*delete "del")(object d, uint64_t key, int16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, int16_t* vals, Py_ssize_t n, int16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, int16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_u16:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, uint16_t* val)
+        int (*set)(object d, uint64_t key, uint16_t val) except -1
+        int (*delete "del")(object d, uint64_t key, uint16_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, uint16_t* vals, Py_ssize_t n, uint16_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, uint16_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_i32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, int32_t* val)
+        int (*set)(object d, uint64_t key, int32_t val) except -1
+        int (*delete "del")(object d, uint64_t key, int32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, int32_t* vals, Py_ssize_t n, int32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, int32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_u32:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, uint32_t* val)
+        int (*set)(object d, uint64_t key, uint32_t val) except -1
+        int (*delete "del")(object d, uint64_t key, uint32_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, uint32_t* vals, Py_ssize_t n, uint32_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, uint32_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_i64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, int64_t* val)
+        int (*set)(object d, uint64_t key, int64_t val) except -1
+        int (*delete "del")(object d, uint64_t key, int64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, int64_t* vals, Py_ssize_t n, int64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, int64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_u64_u64:
+        int version
+        PyTypeObject* type
+        object (*create)()
+        int (*get)(object d, uint64_t key, uint64_t* val)
+        int (*set)(object d, uint64_t key, uint64_t val) except -1
+        int (*delete "del")(object d, uint64_t key, uint64_t* val) except -1
+        Py_ssize_t (*get_many)(object d, const uint64_t* keys, uint64_t* vals, Py_ssize_t n, uint64_t default_val)
+        int (*next)(object d, Py_ssize_t* pos, uint64_t* key, uint64_t* val)
+        Py_ssize_t (*size)(object d)
+
+    ctypedef struct MicrodictAPI_str_str:
+        int version
+        PyTypeObject* type
+        object (*create)(Py_ssize_t key_len, Py_ssize_t val_len)
+        int (*get)(object d, const char* key, Py_ssize_t key_len, const char** val, Py_ssize_t* val_len)
+        int (*set)(object d, const char* key, Py_ssize_t key_len, const char* val, Py_ssize_t val_len) except -1
+        int (*delete "del")(object d, const char* key, Py_ssize_t key_len) except -1
+        Py_ssize_t (*get_many)(object d, const char* const* keys, const Py_ssize_t* key_lens, const char** vals, Py_ssize_t* val_lens, Py_ssize_t n)
+        int (*next)(object d, Py_ssize_t* pos, const char** key, Py_ssize_t* key_len, const char** val, Py_ssize_t* val_len)
+        Py_ssize_t (*size)(object d)
+
+    MicrodictAPI_i16_i16* microdict_import_i16_i16() except NULL
+    MicrodictAPI_i16_u16* microdict_import_i16_u16() except NULL
+    MicrodictAPI_i16_i32* microdict_import_i16_i32() except NULL
+    MicrodictAPI_i16_u32* microdict_import_i16_u32() except NULL
+    MicrodictAPI_i16_i64* microdict_import_i16_i64() except NULL
+    MicrodictAPI_i16_u64* microdict_import_i16_u64() except NULL
+    MicrodictAPI_u16_i16* microdict_import_u16_i16() except NULL
+    MicrodictAPI_u16_u16* microdict_import_u16_u16() except NULL
+    MicrodictAPI_u16_i32* microdict_import_u16_i32() except NULL
+    MicrodictAPI_u16_u32* microdict_import_u16_u32() except NULL
+    MicrodictAPI_u16_i64* microdict_import_u16_i64() except NULL
+    MicrodictAPI_u16_u64* microdict_import_u16_u64() except NULL
+    MicrodictAPI_i32_i16* microdict_import_i32_i16() except NULL
+    MicrodictAPI_i32_u16* microdict_import_i32_u16() except NULL
+    MicrodictAPI_i32_i32* microdict_import_i32_i32() except NULL
+    MicrodictAPI_i32_u32* microdict_import_i32_u32() except NULL
+    MicrodictAPI_i32_i64* microdict_import_i32_i64() except NULL
+    MicrodictAPI_i32_u64* microdict_import_i32_u64() except NULL
+    MicrodictAPI_u32_i16* microdict_import_u32_i16() except NULL
+    MicrodictAPI_u32_u16* microdict_import_u32_u16() except NULL
+    MicrodictAPI_u32_i32* microdict_import_u32_i32() except NULL
+    MicrodictAPI_u32_u32* microdict_import_u32_u32() except NULL
+    MicrodictAPI_u32_i64* microdict_import_u32_i64() except NULL
+    MicrodictAPI_u32_u64* microdict_import_u32_u64() except NULL
+    MicrodictAPI_i64_i16* microdict_import_i64_i16() except NULL
+    MicrodictAPI_i64_u16* microdict_import_i64_u16() except NULL
+    MicrodictAPI_i64_i32* microdict_import_i64_i32() except NULL
+    MicrodictAPI_i64_u32* microdict_import_i64_u32() except NULL
+    MicrodictAPI_i64_i64* microdict_import_i64_i64() except NULL
+    MicrodictAPI_i64_u64* microdict_import_i64_u64() except NULL
+    MicrodictAPI_u64_i16* microdict_import_u64_i16() except NULL
+    MicrodictAPI_u64_u16* microdict_import_u64_u16() except NULL
+    MicrodictAPI_u64_i32* microdict_import_u64_i32() except NULL
+    MicrodictAPI_u64_u32* microdict_import_u64_u32() except NULL
+    MicrodictAPI_u64_i64* microdict_import_u64_i64() except NULL
+    MicrodictAPI_u64_u64* microdict_import_u64_u64() except NULL
+    MicrodictAPI_str_str* microdict_import_str_str() except NULL
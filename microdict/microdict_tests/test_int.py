@@ -1,6 +1,16 @@
 import unittest
+import time
+import collections
 import random
+import os
+import struct
+import array
+import threading
+import sys
+import tracemalloc
+import ctypes
 from microdict import mdict
+from microdict.benchmarks import adversarial
 
 def gen_random_list_unique(size, num_range, seed=0):
 
@@ -21,6 +31,21 @@ def gen_random_list(size, num_range, seed=0):
 	return numbers
 
 
+def load_c_api(name, fields):
+	"""
+	Returns the function table exported by the _C_API capsule of the _mdict_c.name module (see microdict_api.h) as a
+	ctypes structure, fields describing the function pointers that follow its version and type.
+	"""
+
+	class API(ctypes.Structure):
+		_fields_ = [("version", ctypes.c_int), ("type", ctypes.c_void_p)] + fields
+
+	get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+	get_pointer.restype = ctypes.c_void_p
+	get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+	return API.from_address(get_pointer(mdict.DICT_TYPES[tuple(name.split('_'))]._C_API, ("_mdict_c.%s._C_API" % name).encode()))
+
+
 class Test_int_int(unittest.TestCase):
 	size = 10
 	dict_type = None
@@ -71,6 +96,99 @@ class Test_int_int(unittest.TestCase):
 			val_results.append(d1[k])
 		self.assertListEqual(sorted(vals), sorted(val_results))
 
+	def test_get(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(2 * self.size, self.key_range, seed=5151)
+		for i in range(self.size):
+			d1[keys[i]] = i
+
+		self.assertListEqual([d1.get(k) for k in keys[:self.size]], list(range(self.size)))
+		self.assertListEqual([d1.get(k, -1) for k in keys[:self.size]], list(range(self.size)))
+		self.assertListEqual([d1.get(k) for k in keys[self.size:]], [None] * self.size)
+		self.assertListEqual([d1.get(k, "missing") for k in keys[self.size:]], ["missing"] * self.size)
+
+		d1.set(key=keys[0], value=7)
+		d1.set(keys[1], value=8)
+		self.assertEqual((d1.get(keys[0]), d1.get(keys[1])), (7, 8))
+		self.assertEqual(d1.pop(keys[0]), 7)
+		self.assertIsNone(d1.get(keys[0]))
+
+	def test_set_after_delete(self):
+		# 0 and 32 start probing from the same bucket of a 32 bucket table : once 0 is deleted, setting 32 again
+		# must find it past the emptied bucket rather than insert it twice
+		d1 = self.create_dict()
+		for k in range(100, 110):
+			d1[k] = k
+		d1[0] = 1
+		d1[32] = 2
+		d1.pop(0)
+		d1[32] = 3
+		self.assertEqual(len(d1), 11)
+		self.assertEqual(d1.pop(32), 3)
+		self.assertNotIn(32, d1)
+
+		keys = gen_random_list_unique(self.size, self.key_range, seed=4747)
+		d2 = self.create_dict()
+		for i, k in enumerate(keys):
+			d2[k] = i
+		for k in keys[::3]:
+			d2.pop(k)
+		ref = {k:-1 for i, k in enumerate(keys) if i % 3}
+		for k in ref:
+			d2[k] = -1
+		self.assertEqual(len(d2), len(ref))
+		self.assertDictEqual(d2.to_Pydict(), ref)
+
+	def test_c_api(self):
+		K = ctypes.c_int32 if self.dict_type.startswith('i32') else ctypes.c_int64
+		V = ctypes.c_int32 if self.dict_type.endswith('i32') else ctypes.c_int64
+		F, obj = ctypes.PYFUNCTYPE, ctypes.py_object
+		api = load_c_api(self.dict_type.replace(':', '_'), [
+			("create", F(obj)),
+			("get", F(ctypes.c_int, obj, K, ctypes.POINTER(V))),
+			("set", F(ctypes.c_int, obj, K, V)),
+			("delete", F(ctypes.c_int, obj, K, ctypes.POINTER(V))),
+			("get_many", F(ctypes.c_ssize_t, obj, ctypes.POINTER(K), ctypes.POINTER(V), ctypes.c_ssize_t, V)),
+			("next", F(ctypes.c_int, obj, ctypes.POINTER(ctypes.c_ssize_t), ctypes.POINTER(K), ctypes.POINTER(V))),
+			("size", F(ctypes.c_ssize_t, obj)),
+		])
+		self.assertEqual(api.version, 2)
+
+		d1 = api.create()
+		self.assertIs(type(d1), type(self.create_dict()))
+		keys = gen_random_list_unique(2 * self.size, self.key_range, seed=9191)
+		vals = gen_random_list(self.size, self.val_range, seed=1919)
+		for k, v in zip(keys, vals):
+			api.set(d1, k, v)
+		self.assertEqual(api.size(d1), len(d1))
+		self.assertDictEqual(d1.to_Pydict(), dict(zip(keys, vals)))
+
+		val = V()
+		self.assertListEqual([val.value if api.get(d1, k, ctypes.byref(val)) else None for k in keys], vals + [None] * self.size)
+		d1[keys[0]] = 5
+		self.assertEqual((api.get(d1, keys[0], ctypes.byref(val)), val.value), (1, 5))
+
+		out = (V * len(keys))()
+		self.assertEqual(api.get_many(d1, (K * len(keys))(*keys), out, len(keys), 3), self.size)
+		self.assertListEqual(list(out), [5] + vals[1:] + [3] * self.size)
+
+		pos, key = ctypes.c_ssize_t(0), K()
+		items = []
+		while api.next(d1, ctypes.byref(pos), ctypes.byref(key), ctypes.byref(val)):
+			items.append((key.value, val.value))
+		self.assertListEqual(sorted(items), sorted(d1.items()))
+
+		self.assertEqual((api.delete(d1, keys[0], ctypes.byref(val)), val.value), (1, 5))
+		self.assertEqual(api.delete(d1, keys[0], None), 0)
+		self.assertEqual(api.delete(d1, keys[1], None), 1)
+		self.assertNotIn(keys[1], d1)
+		self.assertEqual(api.size(d1), self.size - 2)
+
+		d1.freeze()
+		self.assertRaises(TypeError, api.set, d1, keys[2], 1)
+		self.assertRaises(TypeError, api.delete, d1, keys[2], None)
+		self.assertEqual(api.get(d1, keys[2], ctypes.byref(val)), 1)
+
 	def test_iterators(self):
 		d1 = self.create_dict()
 		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
@@ -95,6 +213,411 @@ class Test_int_int(unittest.TestCase):
 		self.assertListEqual(sorted(vals), sorted(d1.get_values()))
 		self.assertListEqual(sorted(items, key=sorter), sorted(d1.get_items(), key=sorter))
 
+		# Tables with concurrent_reads never shrink, so popping most keys leaves mostly empty flags words.
+		d2 = mdict.create(self.dict_type, concurrent_reads=True)
+		d2.update(d1)
+		d2.clear(keys[1::50] + keys[2::50])
+		for i in range(self.size):
+			if i % 50 > 2:
+				d2.pop(keys[i])
+		kept = sorted(items[::50], key=sorter)
+		self.assertListEqual(sorted(d2.items(), key=sorter), kept)
+		self.assertListEqual(sorted(d2), [k for k, v in kept])
+		self.assertListEqual(sorted(d2.values()), sorted(v for k, v in kept))
+		self.assertDictEqual(d2.to_Pydict(), dict(kept))
+		d3 = self.create_dict()
+		d3.update(d2)
+		self.assertListEqual(sorted(d3.get_items(), key=sorter), kept)
+
+	def test_independent_iterators(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
+		vals = gen_random_list_unique(self.size, self.val_range, seed=43431313)
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		if self.size <= 100: # Nested loops over the same dictionary
+			self.assertEqual(sum(1 for k1 in d1 for k2 in d1), self.size ** 2)
+
+		it1, it2 = iter(d1.items()), iter(d1.items())
+		self.assertIsNot(it1, it2)
+		self.assertEqual(next(it1), next(it2))
+		self.assertListEqual(list(it1), list(it2))
+		self.assertListEqual(sorted(zip(d1, d1.values())), sorted(d1.get_items()))
+
+		it = iter(d1)
+		next(it)
+		d1[keys[0]] = vals[1] # Replacing a value is not a size change
+		next(it)
+		d1.pop(keys[0])
+		self.assertRaises(RuntimeError, next, it)
+		it = iter(d1.values())
+		d1[keys[0]] = vals[0]
+		self.assertRaises(RuntimeError, next, it)
+		it = iter(d1.items())
+		d1.clear()
+		self.assertRaises(RuntimeError, list, it)
+		self.assertListEqual(list(d1.items()), [])
+
+	def test_small_tables(self):
+		# Tables start in the small layout and move to the hashed one once they hold more than 8 items
+		self.create_dict()
+		keys = gen_random_list_unique(20, self.key_range, seed=2231)
+		vals = gen_random_list(20, self.val_range, seed=991)
+		for n in [0, 1, 7, 8, 9, 20]:
+			d1, ref = self.create_dict(), {}
+			for i in range(n):
+				d1[keys[i]] = vals[i]
+				ref[keys[i]] = vals[i]
+			d1[keys[0]] = vals[-1] # Updating a key of a full small table keeps it small
+			ref[keys[0]] = vals[-1]
+			for i in range(0, n, 3):
+				d1.pop(keys[i])
+				del ref[keys[i]]
+			for i in range(n, 20, 2):
+				d1[keys[i]] = vals[i]
+				ref[keys[i]] = vals[i]
+			self.assertEqual(len(d1), len(ref))
+			self.assertDictEqual(d1.to_Pydict(), ref)
+			self.assertListEqual([k in d1 for k in keys], [k in ref for k in keys])
+			self.assertListEqual(sorted(d1.keys_array().tolist()), sorted(ref))
+			d1.freeze()
+			self.assertDictEqual(d1.to_Pydict(), ref)
+
+	def test_direct(self):
+		self.create_dict()
+		d1 = mdict.create(self.dict_type, key_range=(-5, self.size))
+		vals = gen_random_list(self.size + 5, self.val_range, seed=8181)
+		ref = {}
+		for k in range(-5, self.size, 2):
+			d1[k] = vals[k + 5]
+			ref[k] = vals[k + 5]
+		for k in range(-5, self.size, 6):
+			d1.pop(k)
+			del ref[k]
+		self.assertEqual(len(d1), len(ref))
+		self.assertListEqual([k in d1 for k in range(-10, self.size + 5)], [k in ref for k in range(-10, self.size + 5)])
+		self.assertDictEqual(d1.to_Pydict(), ref)
+		self.assertListEqual(sorted(d1.keys_array().tolist()), sorted(ref))
+
+		# Keys outside of the range make the dictionary switch to hashing
+		d1[self.size] = 1
+		d1[-6] = 2
+		ref[self.size] = 1
+		ref[-6] = 2
+		self.assertDictEqual(d1.to_Pydict(), ref)
+		self.assertListEqual([d1[k] for k in ref], list(ref.values()))
+
+		d2 = mdict.create(self.dict_type, key_range=(0, 100))
+		d2[7] = 7
+		d2.clear()
+		self.assertEqual(len(d2), 0)
+		self.assertNotIn(7, d2)
+		d2[99] = 1
+		self.assertDictEqual(d2.to_Pydict(), {99:1})
+
+		self.assertRaises(ValueError, mdict.create, self.dict_type, key_range=(5, 5))
+		self.assertRaises(ValueError, mdict.create, self.dict_type, key_range=(0, 1 << 40))
+		self.assertRaises(ValueError, mdict.create, self.dict_type, key_range=(0, (1 << 26) + 1))
+
+		# The widest range
+		d3 = mdict.create(self.dict_type, key_range=(0, 1 << 26))
+		ref = {k:vals[i] for i, k in enumerate([0, 1, (1 << 25), (1 << 26) - 2, (1 << 26) - 1])}
+		for k, v in ref.items():
+			d3[k] = v
+		self.assertDictEqual(d3.to_Pydict(), ref)
+		self.assertListEqual([d3[k] for k in ref], list(ref.values()))
+		self.assertNotIn(1 << 26, d3)
+		self.assertRaises(TypeError, mdict.create, self.dict_type, key_range=[0, 10])
+		self.assertRaises(ValueError, mdict.create, self.dict_type, key_range=(0, 10), concurrent_reads=True)
+		self.assertRaises(ValueError, mdict.create, self.dict_type, key_range=(0, 10), shards=2)
+
+	def test_ordered(self):
+		self.create_dict()
+		d1 = mdict.create(self.dict_type, ordered=True)
+		keys = gen_random_list_unique(self.size, self.key_range, seed=5151)
+		vals = gen_random_list(self.size, self.val_range, seed=6161)
+		ref = {}
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+			ref[keys[i]] = vals[i]
+		if self.size > 32: # Rebuilds go through mdict_resize and are counted
+			self.assertGreater(d1.stats()["num_resizes"], 0)
+		for i in range(0, self.size, 3):
+			d1.pop(keys[i])
+			del ref[keys[i]]
+		for i in range(0, self.size, 6): # Inserted again at the end
+			d1[keys[i]] = vals[i]
+			ref[keys[i]] = vals[i]
+		for i in range(1, self.size, 5): # Updating a value keeps the position
+			d1[keys[i]] = vals[0]
+			ref[keys[i]] = vals[0]
+
+		self.assertEqual(len(d1), len(ref))
+		self.assertListEqual(list(d1), list(ref))
+		self.assertListEqual(list(d1.items()), list(ref.items()))
+		self.assertListEqual(d1.get_values(), list(ref.values()))
+		self.assertListEqual(list(d1.to_Pydict().items()), list(ref.items()))
+		self.assertListEqual(d1.keys_array().tolist(), list(ref))
+		self.assertListEqual([k for ks, vs in d1.iter_chunks(7) for k in ks.tolist()], list(ref))
+		self.assertListEqual(list(d1.copy().items()), list(ref.items()))
+		self.assertListEqual([k in d1 for k in keys], [k in ref for k in keys])
+
+		for k in list(ref)[:len(ref) - 3]: # Shrinks the table
+			d1.pop(k)
+			del ref[k]
+		self.assertListEqual(list(d1.items()), list(ref.items()))
+		self.assertRaises(ValueError, d1.freeze) # The frozen layout does not keep the order
+		self.assertFalse(d1.is_frozen())
+		self.assertListEqual(list(d1.items()), list(ref.items()))
+
+		d1.clear()
+		d1[2] = 1
+		d1[1] = 2
+		self.assertListEqual(list(d1), [2, 1])
+		self.assertRaises(ValueError, mdict.create, self.dict_type, ordered=True, key_range=(0, 10))
+		self.assertRaises(ValueError, mdict.create, self.dict_type, ordered=True, concurrent_reads=True)
+
+	def test_cache(self):
+		self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=7171)
+		cap = max(self.size // 10, 3)
+
+		d1 = mdict.create(self.dict_type, max_items=cap, policy="lru")
+		ref = collections.OrderedDict()
+		for i in range(self.size):
+			if i % 4 == 3 and keys[i // 2] in ref: # A lookup makes the key the most recently used one
+				self.assertIn(keys[i // 2], d1)
+				ref.move_to_end(keys[i // 2])
+			d1[keys[i]] = i
+			ref[keys[i]] = i
+			if len(ref) > cap:
+				ref.popitem(last=False)
+		self.assertEqual(len(d1), cap)
+		self.assertDictEqual(d1.to_Pydict(), dict(ref))
+		self.assertDictEqual(d1.copy().to_Pydict(), dict(ref))
+
+		d2 = mdict.create(self.dict_type, max_items=cap, policy="clock")
+		for i in range(self.size):
+			d2[keys[i]] = i
+			self.assertIn(keys[i], d2)
+			self.assertLessEqual(len(d2), cap)
+		self.assertEqual(len(d2), cap)
+		self.assertIn(keys[-1], d2)
+		self.assertTrue(all(d2[k] == keys.index(k) for k in list(d2)[:10]))
+
+		d1.pop(next(iter(d1)))
+		self.assertEqual(len(d1), cap - 1)
+		d1.clear()
+		for i in range(cap + 1):
+			d1[keys[i]] = i
+		self.assertEqual(len(d1), cap)
+		self.assertNotIn(keys[0], d1)
+
+		d3 = mdict.create(self.dict_type, max_items=2, policy="lru")
+		d3[1] = 1
+		d3[2] = 2
+		k = next(iter(d3)) # Caches the item of k, see key_iternext
+		self.assertEqual(d3[k], k) # Makes k the most recently used key
+		d3[3] = 3
+		self.assertIn(k, d3)
+		self.assertNotIn(3 - k, d3)
+
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_items=0)
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_items=10, policy="fifo")
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_items=10, ordered=True)
+
+	def test_ttl(self):
+		self.create_dict()
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=9191)
+		for i in range(self.size):
+			if i % 2:
+				d1.set(keys[i], i, ttl=0.05)
+			else:
+				d1.set(keys[i], i)
+		d1.set(keys[1], 1, ttl=1000)
+		d1.set(keys[3], 3) # Permanent again
+		self.assertIn(keys[1], d1)
+
+		time.sleep(0.1)
+		live = {keys[i]:i for i in range(self.size) if i % 2 == 0 or i in (1, 3)}
+		self.assertListEqual([k in d1 for k in keys], [k in live for k in keys])
+		self.assertRaises(KeyError, d1.pop, keys[-1] if (self.size - 1) % 2 else keys[-2])
+		self.assertDictEqual(d1.to_Pydict(), live)
+		self.assertEqual(len(d1), len(live))
+		self.assertEqual(d1.expire(), 0)
+
+		d1.set(keys[0], 0, ttl=0.01)
+		time.sleep(0.05)
+		self.assertEqual(d1.expire(), 1)
+		self.assertNotIn(keys[0], d1)
+		d1[keys[0]] = 5
+		self.assertEqual(d1[keys[0]], 5)
+
+		k = next(iter(d1)) # Caches the item of k, see key_iternext
+		d1.set(k, 7, ttl=0.01)
+		time.sleep(0.05)
+		self.assertIsNone(d1.get(k))
+		self.assertIsNone(d1[k])
+
+		n = len(d1) # k has been reclaimed by the lookups above
+		d1.set(k, 8, ttl=0.01)
+		time.sleep(0.05)
+		self.assertEqual(len(d1), n) # Expired items are not counted
+		d1[k] = 9
+		self.assertEqual(len(d1), n + 1)
+
+		# Lookups and len leave the items that expire during an iteration in place rather than invalidating it
+		d5 = self.create_dict()
+		for i in range(self.size):
+			d5.set(keys[i], i, ttl=0.01 if i % 2 else None)
+		it = iter(d5)
+		time.sleep(0.05)
+		n, last = 0, keys[(self.size - 2) | 1] # The last key set with a ttl, not reclaimed by iter(d5)
+		for k in it:
+			n += 1
+			len(d5)
+			self.assertIsNone(d5.get(last))
+			self.assertNotIn(last, d5)
+		self.assertGreaterEqual(n, (self.size + 1) // 2)
+		self.assertEqual(len(d5), (self.size + 1) // 2) # Reclaimed once the iteration is over
+
+		d4 = mdict.create(self.dict_type, max_items=2, policy="lru")
+		d4[1] = 1
+		d4.set(2, 2, ttl=0.01)
+		time.sleep(0.05)
+		d4[3] = 3 # Takes the place of the expired item rather than evicting 1
+		self.assertDictEqual(d4.to_Pydict(), {1:1, 3:3})
+
+		d2 = self.create_dict()
+		for i in range(self.size):
+			d2.set(keys[i], i, ttl=1000)
+		d3 = d2.copy()
+		self.assertDictEqual(d3.to_Pydict(), d2.to_Pydict())
+		for i in range(self.size):
+			d2.set(keys[i], i, ttl=0.001)
+		time.sleep(0.05)
+		for i in range(self.size): # Inserts and resizes reclaim some of the expired items
+			d2[keys[i] ^ 1] = i
+		d2.expire()
+		self.assertEqual(len(d2), len(set(k ^ 1 for k in keys)))
+		self.assertEqual(len(d3), self.size)
+
+		self.assertRaises(ValueError, d1.set, 1, 1, ttl=0)
+		self.assertRaises(ValueError, mdict.create(self.dict_type, ordered=True).set, 1, 1, ttl=1)
+
+	def test_budget(self):
+		self.create_dict()
+		keys = gen_random_list_unique(max(self.size, 1000), self.key_range, seed=5353)
+		budget = 4096
+
+		d1 = mdict.create(self.dict_type, max_bytes=budget)
+		inserted = {}
+		for i, k in enumerate(keys):
+			try:
+				d1[k] = i
+			except MemoryError:
+				break
+			inserted[k] = i
+		n = len(inserted)
+		self.assertLess(n, len(keys))
+		self.assertDictEqual(d1.to_Pydict(), inserted)
+		d1[keys[0]] = 5 # Updates do not grow the table
+		self.assertEqual(d1[keys[0]], 5)
+		self.assertRaises(MemoryError, d1.update, {keys[-1]: 1})
+		self.assertEqual(len(d1.copy()), n)
+		d1.clear()
+		self.assertRaises(MemoryError, d1.update, {k:1 for k in keys})
+		self.assertEqual(len(d1), n)
+
+		d2 = mdict.create(self.dict_type, max_bytes=budget, policy="random")
+		d3 = mdict.create(self.dict_type, max_bytes=budget, policy="lowest")
+		for i, k in enumerate(keys):
+			d2[k] = i
+			d3[k] = i
+			self.assertIn(k, d2)
+		self.assertEqual(len(d2), n)
+		self.assertTrue(all(d2[k] == keys.index(k) for k in d2))
+		self.assertDictEqual(d3.to_Pydict(), {k:i for i, k in enumerate(keys) if i >= len(keys) - n})
+
+		d4 = mdict.create(self.dict_type, max_bytes=budget, policy="lru")
+		for i, k in enumerate(keys):
+			d4[k] = i
+		self.assertTrue(0 < len(d4) < n)
+		self.assertIn(keys[-1], d4)
+
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_bytes=0)
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_bytes=budget, policy="fifo")
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_bytes=budget, ordered=True)
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_bytes=16, policy="clock")
+		small_bytes = mdict.create(self.dict_type).stats()["bytes"] # The block of the small layout.
+		self.assertRaises(ValueError, mdict.create, self.dict_type, max_bytes=small_bytes - 1)
+		d5 = mdict.create(self.dict_type, max_bytes=small_bytes)
+		for i in range(8):
+			d5[keys[i]] = i
+		self.assertRaises(MemoryError, d5.__setitem__, keys[8], 8)
+		self.assertEqual(len(d5), 8)
+
+	def test_stats(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=6161)
+		self.assertEqual(d1.stats()["layout"], "small")
+		for i in range(self.size):
+			d1[keys[i]] = i
+
+		st = d1.stats()
+		self.assertEqual(st["size"], self.size)
+		self.assertEqual(st["load_factor"], self.size / st["num_buckets"])
+		self.assertEqual(st["bytes"], sum(st["array_bytes"].values()))
+		self.assertEqual(st["array_bytes"]["keys"] % st["num_buckets"], 0)
+		if st["layout"] == "hashed":
+			self.assertEqual(sum(st["probe_lengths"]), self.size)
+			self.assertEqual(len(st["group_max_psl"]), st["num_buckets"] // 32)
+			self.assertGreaterEqual(max(st["group_max_psl"]), len(st["probe_lengths"]) - 1)
+			self.assertGreater(st["num_resizes"], 0)
+			self.assertGreaterEqual(st["rehash_seconds"], 0)
+
+		d1.freeze()
+		st = d1.stats()
+		self.assertEqual((st["layout"], st["size"], st["probe_lengths"]), ("frozen", self.size, []))
+		self.assertIn("offsets", st["array_bytes"])
+
+	def test_adversarial_keys(self):
+		size = min(self.size, 2000) # Some key sets take quadratic time.
+		for key_set in adversarial.INT_KEY_SETS:
+			r = adversarial.stress(self.dict_type, key_set, size) # Checks that every item reads back.
+			self.assertEqual((r["inserted"], r["truncated"]), (size, False))
+
+			d1 = self.create_dict()
+			keys = adversarial.int_keys(self.dict_type, key_set, size)
+			for i, k in enumerate(keys):
+				d1[k] = i
+			for k in keys[::2]:
+				d1.pop(k)
+			self.assertEqual(len(d1), size // 2)
+			for i in range(1, size, 2):
+				self.assertEqual(d1[keys[i]], i)
+			for k in keys[::2]:
+				self.assertNotIn(k, d1)
+
+	def test_sizeof(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=4242)
+		empty, small_bytes = sys.getsizeof(d1), d1.stats()["bytes"]
+		tracemalloc.start()
+		before = tracemalloc.get_traced_memory()[0]
+		for i in range(self.size):
+			d1[keys[i]] = i
+		traced = tracemalloc.get_traced_memory()[0] - before
+		tracemalloc.stop()
+
+		array_bytes = d1.stats()["bytes"]
+		self.assertEqual(sys.getsizeof(d1), empty - small_bytes + array_bytes) # The small arrays are freed on growing
+		self.assertGreaterEqual(traced, array_bytes)
+		d1.clear()
+		self.assertEqual(sys.getsizeof(d1), empty)
+
 	def test_updating_conversion(self):
 		d1 = self.create_dict()
 		partition_size = int(self.size/2)
@@ -159,6 +682,267 @@ class Test_int_int(unittest.TestCase):
 		self.assertEqual(list(d2.values()), [])
 		self.assertEqual(list(d2.items()), [])
 
+		# Setting a key that sits past a deleted bucket of its probe sequence updates it in place
+		for k in range(9):
+			d2[64 * k + 1] = 1
+		d2[0] = 1
+		d2[6400] = 2
+		d2.pop(0)
+		d2[6400] = 3
+		self.assertEqual(len(d2), 10)
+		self.assertEqual(list(d2).count(6400), 1)
+		self.assertEqual(d2[6400], 3)
+
+
+	def test_freeze(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
+		vals = gen_random_list_unique(self.size, self.val_range, seed=43431313)
+		items = list(zip(keys, vals))
+		sorter = lambda x:x[0]
+
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		self.assertFalse(d1.is_frozen())
+		d1.freeze()
+		self.assertTrue(d1.is_frozen())
+		self.assertEqual(len(d1), self.size)
+
+		self.assertListEqual([d1[k] for k in keys], vals)
+		self.assertListEqual([k in d1 for k in keys], [True]*self.size)
+		missing = set(gen_random_list_unique(self.size, self.key_range, seed=777)) - set(keys)
+		self.assertListEqual([k in d1 for k in missing], [False]*len(missing))
+
+		self.assertListEqual(sorted(d1.get_items(), key=sorter), sorted(items, key=sorter))
+		self.assertListEqual(sorted(d1.items(), key=sorter), sorted(items, key=sorter))
+		self.assertListEqual(sorted(d1), sorted(keys))
+
+		def set_val(d,k,v): d[k]=v
+		self.assertRaises(TypeError, set_val, d1, keys[0], vals[0])
+		self.assertRaises(TypeError, d1.pop, keys[0])
+		self.assertRaises(TypeError, d1.clear)
+		self.assertRaises(TypeError, d1.update, {keys[0]:vals[0]})
+
+		d2 = d1.copy()
+		self.assertFalse(d2.is_frozen())
+		d2[keys[0]] = vals[1]
+		self.assertEqual(d1[keys[0]], vals[0])
+
+		d3 = self.create_dict()
+		d3.freeze()
+		self.assertEqual(len(d3), 0)
+		self.assertFalse(keys[0] in d3)
+		self.assertEqual(list(d3), [])
+
+		d4 = self.create_dict() # Strided keys share their low bits, see _frozen_slot
+		strided = [i << 10 for i in range(self.size)]
+		for i, k in enumerate(strided):
+			d4[k] = vals[i]
+		d4.freeze()
+		self.assertListEqual([d4[k] for k in strided], vals)
+		self.assertNotIn(1 << 9, d4)
+
+	@unittest.skipIf(os.name == 'nt', "POSIX shared memory is not available on Windows")
+	def test_shared_memory(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
+		vals = gen_random_list_unique(self.size, self.val_range, seed=43431313)
+		items = list(zip(keys, vals))
+		sorter = lambda x:x[0]
+		name = "/microdict_test_%d" % os.getpid()
+
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		d1.share(name)
+		self.assertFalse(d1.is_frozen())
+		d2 = mdict.attach(self.dict_type, name)
+		self.assertTrue(d2.is_frozen())
+		self.assertEqual(len(d2), self.size)
+		self.assertListEqual([d2[k] for k in keys], vals)
+		self.assertListEqual(sorted(d2.items(), key=sorter), sorted(items, key=sorter))
+
+		d1.pop(keys[0])
+		d1.share(name)
+		d3 = mdict.attach(self.dict_type, name)
+		self.assertFalse(keys[0] in d3)
+		self.assertTrue(keys[0] in d2)
+		self.assertRaises(TypeError, mdict.attach, 'str:str', name)
+
+		path = "/dev/shm" + name
+		if os.path.exists(path): # Corrupted headers are refused (see mdict_shm_header for the offsets).
+			with open(path, "r+b") as f:
+				header = f.read(96)
+				num_slots, total_size, offsets_offset = struct.unpack_from("i", header, 20)[0], struct.unpack_from("Q", header, 88)[0], struct.unpack_from("Q", header, 80)[0]
+				patches = [(16, "i", 2**31 - 1), (20, "i", 3), (32, "i", 8), (64, "Q", total_size), (80, "Q", 2**63)]
+				if num_slots > 1:
+					patches.append((offsets_offset + 4, "i", 2**31 - 1)) # An interior slot offset past the keys
+				for offset, fmt, value in patches:
+					f.seek(offset)
+					original = f.read(struct.calcsize(fmt))
+					f.seek(offset)
+					f.write(struct.pack(fmt, value))
+					f.flush()
+					self.assertRaises(ValueError, mdict.attach, self.dict_type, name)
+					f.seek(offset)
+					f.write(original)
+					f.flush()
+			self.assertEqual(len(mdict.attach(self.dict_type, name)), self.size - 1)
+
+		mdict.unlink(name)
+		self.assertRaises(OSError, mdict.attach, self.dict_type, name)
+		self.assertEqual(d3.to_Pydict(), d1.to_Pydict())
+		del d2, d3
+
+	def test_sharded(self):
+		self.create_dict() # sets key_range and val_range
+		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
+		vals = gen_random_list_unique(self.size, self.val_range, seed=43431313)
+		k_code = 'i' if self.key_range[1] < 2**31 else 'q'
+		v_code = 'i' if self.val_range[1] < 2**31 else 'q'
+		d1 = mdict.create(self.dict_type, shards=6)
+		self.assertEqual(d1.num_shards(), 8)
+
+		num_threads = 4
+		chunk = (self.size + num_threads - 1) // num_threads
+		def insert(i):
+			d1.set_many(array.array(k_code, keys[i*chunk:(i+1)*chunk]), array.array(v_code, vals[i*chunk:(i+1)*chunk]))
+		threads = [threading.Thread(target=insert, args=(i,)) for i in range(num_threads)]
+		for t in threads: t.start()
+		for t in threads: t.join()
+
+		self.assertEqual(len(d1), self.size)
+		self.assertDictEqual(d1.to_Pydict(), dict(zip(keys, vals)))
+
+		out = array.array(v_code, [0]) * self.size
+		self.assertEqual(d1.get_many(array.array(k_code, keys), out), self.size)
+		self.assertListEqual(list(out), vals)
+		self.assertListEqual([d1[k] for k in keys[:10]], vals[:10])
+
+		d1.pop(keys[0])
+		del d1[keys[1]]
+		self.assertFalse(keys[0] in d1)
+		self.assertRaises(KeyError, d1.pop, keys[0])
+		d1[keys[0]] = vals[0]
+		out = array.array(v_code, [0, 0])
+		self.assertEqual(d1.get_many(array.array(k_code, keys[:2]), out, 7), 1)
+		self.assertListEqual(list(out), [vals[0], 7])
+
+		self.assertRaises(TypeError, d1.set_many, array.array('d', [1.0]), array.array(v_code, [1]))
+		self.assertRaises(ValueError, d1.set_many, array.array(k_code, [1, 2]), array.array(v_code, [1]))
+		self.assertRaises(BufferError, d1.get_many, array.array(k_code, [1]), bytes(8))
+
+		d1[keys[1]] = vals[1]
+		d1.pop(keys[0])
+		expected = dict(zip(keys[1:], vals[1:]))
+		self.assertEqual(d1.get(keys[0]), None)
+		self.assertEqual(d1.get(keys[0], 7), 7)
+		self.assertEqual(d1.get(keys[2], 7), vals[2])
+		self.assertCountEqual(list(d1), expected.keys())
+		self.assertCountEqual(d1.keys(), expected.keys())
+		self.assertCountEqual(d1.values(), expected.values())
+		self.assertCountEqual(d1.items(), expected.items())
+		self.assertCountEqual(d1.get_items(), expected.items())
+		self.assertListEqual(d1.get_keys(), [k for k, v in d1.items()])
+		self.assertListEqual(d1.get_values(), [v for k, v in d1.items()])
+
+		it = iter(d1)
+		d1[keys[0]] = vals[0] # Iterators walk a snapshot.
+		self.assertEqual(len(list(it)), self.size - 1)
+
+		d2 = d1.copy()
+		self.assertEqual(d2.num_shards(), 8)
+		d1.clear([keys[0], keys[0]])
+		self.assertDictEqual(d1.to_Pydict(), expected)
+		self.assertDictEqual(d2.to_Pydict(), dict(zip(keys, vals)))
+		d1.clear()
+		self.assertEqual(len(d1), 0)
+		self.assertListEqual(list(d1.items()), [])
+		self.assertEqual(len(d2), self.size)
+
+		d1.update({keys[0]: vals[0]})
+		d1.update(d2)
+		d3 = self.create_dict()
+		d3[keys[0]] = vals[1]
+		d1.update(d3)
+		self.assertEqual(d1[keys[0]], vals[1])
+		self.assertEqual(len(d1), self.size)
+		self.assertRaises(TypeError, d1.update, {"a": 1})
+		self.assertRaises(TypeError, d1.update, [1])
+		self.assertRaises(TypeError, d1.clear, (1,))
+
+	def test_arrays(self):
+		d1 = self.create_dict()
+		keys = gen_random_list_unique(self.size, self.key_range, seed=23319)
+		vals = gen_random_list_unique(self.size, self.val_range, seed=43431313)
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		self.assertListEqual(list(d1.keys_array()), d1.get_keys())
+		self.assertListEqual(list(d1.values_array(threads=4)), d1.get_values())
+		k_arr, v_arr = d1.items_arrays(threads=8)
+		self.assertListEqual(list(zip(k_arr, v_arr)), d1.get_items())
+		self.assertEqual(len(k_arr), self.size)
+		self.assertRaises(ValueError, d1.keys_array, threads=0)
+
+		d1.freeze()
+		self.assertListEqual(list(d1.keys_array(threads=3)), d1.get_keys())
+		self.assertEqual(len(self.create_dict().values_array()), 0)
+
+		chunks = list(d1.iter_chunks(7))
+		self.assertEqual(len(chunks), (self.size + 6) // 7)
+		self.assertTrue(all(len(k) == len(v) <= 7 for k, v in chunks))
+		self.assertListEqual([kv for k, v in chunks for kv in zip(k, v)], d1.get_items())
+		it1, it2 = d1.iter_chunks(self.size), d1.iter_chunks(1)
+		self.assertListEqual(list(next(it1)[0]), d1.get_keys())
+		self.assertRaises(StopIteration, next, it1)
+		self.assertEqual(list(next(it2)[1]), d1.get_values()[:1])
+		self.assertListEqual(list(self.create_dict().iter_chunks(3)), [])
+		self.assertRaises(ValueError, d1.iter_chunks, 0)
+
+	def test_concurrent_reads(self):
+		self.create_dict() # sets key_range and val_range
+		k_code = 'i' if self.key_range[1] < 2**31 else 'q'
+		v_code = 'i' if self.val_range[1] < 2**31 else 'q'
+		d1 = mdict.create(self.dict_type, concurrent_reads=True)
+		n = 20000
+		keys = array.array(k_code, range(n))
+		errors = []
+
+		def read():
+			out = array.array(v_code, [0]) * n
+			for _ in range(20):
+				d1.get_many(keys, out, -1)
+				if any(v != -1 and v != 3 * k for k, v in zip(keys, out)):
+					errors.append(list(out))
+					return
+
+		readers = [threading.Thread(target=read) for i in range(3)]
+		for t in readers: t.start()
+		for k in range(n): # Grows the table several times while the readers run.
+			d1[k] = 3 * k
+		for k in range(0, n, 2):
+			d1.pop(k)
+		for t in readers: t.join()
+
+		self.assertListEqual(errors, [])
+		out = array.array(v_code, [0]) * n
+		self.assertEqual(d1.get_many(keys, out), n // 2)
+		self.assertListEqual(list(out), [3 * k if k % 2 else 0 for k in range(n)])
+
+		d1.clear()
+		self.assertEqual(len(d1), 0)
+		self.assertEqual(d1.get_many(keys, out), 0)
+		d1[5] = 6
+		self.assertEqual(d1[5], 6)
+
+		d2 = self.create_dict()
+		d2[1] = 2
+		out = array.array(v_code, [0, 0])
+		self.assertEqual(d2.get_many(array.array(k_code, [1, 3]), out, 9), 1)
+		self.assertListEqual(list(out), [2, 9])
+		self.assertRaises(ValueError, mdict.create, "str:str", 2, 2, concurrent_reads=True)
 
 	def test_exceptions(self):
 		d1 = self.create_dict()
@@ -179,8 +963,20 @@ class Test_int_int(unittest.TestCase):
 		self.assertFalse(5 in d1)
 
 		self.assertRaises(TypeError, d1.pop, '1')
+		self.assertRaises(TypeError, d1.pop, 1 << 70)
+		self.assertRaises(TypeError, d1.pop)
 		self.assertRaises(KeyError, d1.pop, 5)
 		self.assertRaises(TypeError, d1.clear, {})
+		self.assertRaises(TypeError, d1.clear, [], [])
+		self.assertRaises(TypeError, d1.get)
+		self.assertRaises(TypeError, d1.get, 1, 2, 3)
+		self.assertRaises(TypeError, d1.get, '1')
+		self.assertRaises(TypeError, d1.copy, 1)
+		self.assertRaises(TypeError, d1.set, 1)
+		self.assertRaises(TypeError, d1.set, 1, 2, 3, 4)
+		self.assertRaises(TypeError, d1.set, 1, 2, key=1)
+		self.assertRaises(TypeError, d1.set, 1, 2, time=1)
+		self.assertRaises(TypeError, d1.set, value=2)
 
 		d2 = {'1':1, 2:2, 3:'3'}
 		d1.update(d2)
@@ -190,6 +986,124 @@ class Test_int_int(unittest.TestCase):
 
 
 
+class Test_lockfree_i32_i32(unittest.TestCase):
+	size = 10
+
+	def test_lockfree(self):
+		keys = gen_random_list_unique(self.size, [-2147483647, 2147483647], seed=23319)
+		vals = gen_random_list(self.size, [-2147483648, 2147483647], seed=43431313)
+		d1 = mdict.create_lockfree(self.size)
+		self.assertGreaterEqual(d1.capacity(), self.size)
+
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+		self.assertEqual(len(d1), self.size)
+		self.assertListEqual([d1[k] for k in keys], vals)
+		self.assertListEqual([k in d1 for k in keys], [True]*self.size)
+
+		d1.reserve(2 * self.size)
+		self.assertGreaterEqual(d1.capacity(), 2 * self.size)
+		self.assertListEqual([d1[k] for k in keys], vals)
+
+		def set_val(d,k,v): d[k]=v
+		self.assertRaises(KeyError, set_val, d1, -2147483648, 1)
+
+		d2 = mdict.create_lockfree(10)
+		for k in range(d2.capacity()):
+			d2[k] = k
+		self.assertRaises(MemoryError, set_val, d2, -1, 1)
+		d2[0] = 5
+		self.assertEqual(d2[0], 5)
+
+		def del_val(d,k): del d[k]
+		self.assertRaises(TypeError, del_val, d1, keys[0])
+
+		self.assertEqual(d2.add(0, 3), 8)
+		self.assertRaises(TypeError, d2.add, 0)
+		self.assertRaises(TypeError, d2.add, 0, 1 << 40)
+
+		# Out of range keys and values are rejected, not truncated
+		self.assertRaises(TypeError, set_val, d1, (1 << 32) + 5, 1)
+		self.assertRaises(TypeError, set_val, d1, 5, (1 << 32) + 9)
+		self.assertRaises(TypeError, set_val, d1, "5", 1)
+		self.assertRaises(TypeError, d1.__getitem__, (1 << 32) + 5)
+		self.assertRaises(TypeError, d1.__contains__, -(1 << 31) - 1)
+		self.assertEqual(len(d1), self.size)
+
+	def test_counters(self):
+		d1 = mdict.create_lockfree(64)
+		num_threads, rounds = 4, 2000
+		def count():
+			for i in range(rounds):
+				d1.add(i % 50, 1)
+		threads = [threading.Thread(target=count) for i in range(num_threads)]
+		for t in threads: t.start()
+		for t in threads: t.join()
+
+		self.assertEqual(len(d1), 50)
+		self.assertListEqual([d1[k] for k in range(50)], [num_threads * rounds // 50]*50)
+		self.assertEqual(d1.add(2147483, 5), 5)
+		self.assertEqual(d1.add(2147483, -7), -2)
+		self.assertTrue(type(d1.capsule()).__name__ == 'PyCapsule')
+
+
+class Test_type_matrix(unittest.TestCase):
+	ranges = {'i16': [-2**15, 2**15-1], 'u16': [0, 2**16-1], 'i32': [-2**31, 2**31-1], 'u32': [0, 2**32-1],
+			  'i64': [-2**63, 2**63-1], 'u64': [0, 2**64-1]}
+	formats = {'i16': 'h', 'u16': 'H', 'i32': 'i', 'u32': 'I', 'i64': 'q', 'u64': 'Q'}
+
+	def test_all_pairs(self):
+		for k_type in mdict.INT_TYPES:
+			for v_type in mdict.INT_TYPES:
+				d1 = mdict.create(k_type + ':' + v_type)
+				(k_min, k_max), (v_min, v_max) = self.ranges[k_type], self.ranges[v_type]
+				d1[k_min] = v_max
+				d1[k_max] = v_min
+				d1[1] = 1
+				self.assertDictEqual(d1.to_Pydict(), {k_min:v_max, k_max:v_min, 1:1})
+				self.assertEqual(d1.get(k_max, 7), v_min)
+
+				def set_val(d,k,v): d[k]=v
+				self.assertRaises(TypeError, set_val, d1, k_max + 1, 0)
+				self.assertRaises(TypeError, set_val, d1, k_min - 1, 0)
+				self.assertRaises(TypeError, set_val, d1, 0, v_max + 1)
+				self.assertRaises(TypeError, set_val, d1, 0, v_min - 1)
+				self.assertRaises(KeyError, d1.pop, 2)
+				self.assertEqual(d1.pop(1), 1)
+
+				keys, vals = d1.items_arrays()
+				for exported, fmt in ((keys, self.formats[k_type]), (vals, self.formats[v_type])):
+					view = memoryview(exported) # NumPy may spell the formats differently, e.g. "l" for "q"
+					self.assertEqual(view.itemsize, array.array(fmt).itemsize)
+					self.assertEqual(view.format.islower(), fmt.islower())
+				self.assertDictEqual(dict(zip(keys.tolist(), vals.tolist())), d1.to_Pydict())
+
+				out = array.array(self.formats[v_type], [0, 0, 0])
+				self.assertEqual(d1.get_many(array.array(self.formats[k_type], [k_min, 2, k_max]), out, 3), 2)
+				self.assertListEqual(out.tolist(), [v_max, 3, v_min])
+				if k_type[0] != v_type[0]:
+					self.assertRaises(TypeError, d1.get_many, array.array(self.formats[v_type], [0]), out)
+
+	def test_narrow_types(self):
+		d1, d2 = mdict.create('i16:u16'), mdict.create('i64:i64')
+		for k in range(1000):
+			d1[k] = k
+			d2[k] = k
+		self.assertLess(sys.getsizeof(d1), sys.getsizeof(d2))
+
+		F, obj = ctypes.PYFUNCTYPE, ctypes.py_object
+		api = load_c_api("u64_u16", [
+			("create", F(obj)),
+			("get", F(ctypes.c_int, obj, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint16))),
+			("set", F(ctypes.c_int, obj, ctypes.c_uint64, ctypes.c_uint16))])
+		d3 = api.create()
+		self.assertEqual(api.set(d3, 2**64-1, 65535), 0)
+		val = ctypes.c_uint16()
+		self.assertEqual(api.get(d3, 2**64-1, ctypes.byref(val)), 1)
+		self.assertEqual(val.value, 65535)
+		self.assertEqual(d3[2**64-1], 65535)
+
+
 def runTests_i32_i32():
 	runner = unittest.TextTestRunner(verbosity=2)
 
@@ -248,11 +1162,30 @@ def runTests_i64_i64():
 	runner.run(suite)
 
 
+def runTests_lockfree_i32_i32():
+	runner = unittest.TextTestRunner(verbosity=2)
+
+	Test_lockfree_i32_i32.size = 100000
+	print("Running lock-free i32_i32 tests with number of items set to", Test_lockfree_i32_i32.size)
+	suite = unittest.TestLoader().loadTestsFromTestCase(Test_lockfree_i32_i32)
+	runner.run(suite)
+
+
+def runTests_type_matrix():
+	runner = unittest.TextTestRunner(verbosity=2)
+
+	print("Running the tests of every pair of integer types")
+	suite = unittest.TestLoader().loadTestsFromTestCase(Test_type_matrix)
+	runner.run(suite)
+
+
 def run_all_int_tests():
 	runTests_i32_i32()
+	runTests_lockfree_i32_i32()
 	runTests_i32_i64()
 	runTests_i64_i32()
 	runTests_i64_i64()	
+	runTests_type_matrix()
 
 if __name__ == '__main__':
 	run_all_int_tests()
\ No newline at end of file
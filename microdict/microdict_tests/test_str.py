@@ -1,7 +1,14 @@
 import unittest
+import time
+import collections
 import random
+import os
+import struct
 from microdict import mdict
+from microdict.benchmarks import adversarial
 import string
+import ctypes
+from microdict.microdict_tests.test_int import load_c_api
 
 def randStr(chars = string.ascii_uppercase + string.digits, N=10):
 	str_len = random.randint(1, N-1)
@@ -68,6 +75,210 @@ class Test_str_str(unittest.TestCase):
 			val_results.append(d1[k])
 		self.assertListEqual(sorted(vals), sorted(val_results))
 
+	def test_get(self):
+		d1 = self.create_dict()
+		keys = gen_random_str_list(2 * self.size, self.key_len, self.UTF_size, seed=5151)
+		for i in range(self.size):
+			d1[keys[i]] = str(i)
+
+		self.assertListEqual([d1.get(k) for k in keys[:self.size]], [str(i) for i in range(self.size)])
+		self.assertListEqual([d1.get(k) for k in keys[self.size:]], [None] * self.size)
+		self.assertListEqual([d1.get(k, "") for k in keys[self.size:]], [""] * self.size)
+		self.assertEqual(d1.get("x" * (self.key_len * self.UTF_size + 1), 0), 0) # Too long to be present.
+
+		d1.set(key=keys[0], value="a")
+		self.assertEqual(d1.get(keys[0]), "a")
+		self.assertEqual(d1.pop(keys[0]), "a")
+		self.assertIsNone(d1.get(keys[0]))
+
+	def test_set_after_delete(self):
+		# Setting a key again after deleting another key of its probe sequence updates it rather than insert it twice
+		keys = list(dict.fromkeys(gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=4747)))
+		d1 = self.create_dict()
+		for k in keys:
+			d1[k] = k
+		for k in keys[::3]:
+			d1.pop(k)
+		ref = {k:"x" for i, k in enumerate(keys) if i % 3}
+		for k in ref:
+			d1[k] = "x"
+		self.assertEqual(len(d1), len(ref))
+		self.assertDictEqual(d1.to_Pydict(), ref)
+
+	def test_c_api(self):
+		F, obj, ssize = ctypes.PYFUNCTYPE, ctypes.py_object, ctypes.c_ssize_t
+		P = ctypes.POINTER
+		api = load_c_api("str_str", [
+			("create", F(obj, ssize, ssize)),
+			("get", F(ctypes.c_int, obj, ctypes.c_char_p, ssize, P(ctypes.c_void_p), P(ssize))),
+			("set", F(ctypes.c_int, obj, ctypes.c_char_p, ssize, ctypes.c_char_p, ssize)),
+			("delete", F(ctypes.c_int, obj, ctypes.c_char_p, ssize)),
+			("get_many", F(ssize, obj, P(ctypes.c_char_p), P(ssize), P(ctypes.c_void_p), P(ssize), ssize)),
+			("next", F(ctypes.c_int, obj, P(ssize), P(ctypes.c_void_p), P(ssize), P(ctypes.c_void_p), P(ssize))),
+			("size", F(ssize, obj)),
+		])
+		self.assertEqual(api.version, 2)
+
+		key_len, val_len = self.key_len * self.UTF_size, self.val_len * self.UTF_size
+		d1 = api.create(key_len, val_len)
+		self.assertEqual(len(d1), 0)
+		keys = [k.encode() for k in dict.fromkeys(gen_random_str_list(2 * self.size, self.key_len, self.UTF_size, seed=9191))]
+		vals = [v.encode() for v in gen_random_str_list(len(keys) // 2, self.val_len, self.UTF_size, seed=1919)]
+		for k, v in zip(keys, vals):
+			api.set(d1, k, len(k), v, len(v))
+		self.assertEqual(api.size(d1), len(d1))
+		self.assertDictEqual(d1.to_Pydict(), {k.decode(): v.decode() for k, v in zip(keys, vals)})
+		self.assertRaises(TypeError, api.set, d1, b"x" * (key_len + 1), key_len + 1, b"", 0)
+
+		ptr, length = ctypes.c_void_p(), ssize()
+		found = []
+		for k in keys:
+			found.append(ctypes.string_at(ptr, length.value) if api.get(d1, k, len(k), ctypes.byref(ptr), ctypes.byref(length)) else None)
+		self.assertListEqual(found, [vals[i] if i < len(vals) else None for i in range(len(keys))])
+
+		n = len(keys)
+		out, out_lens = (ctypes.c_void_p * n)(), (ssize * n)()
+		self.assertEqual(api.get_many(d1, (ctypes.c_char_p * n)(*keys), (ssize * n)(*map(len, keys)), out, out_lens, n), len(d1))
+		self.assertListEqual([ctypes.string_at(p, l) if p else None for p, l in zip(out, out_lens)], found)
+
+		pos, key_ptr, key_length = ssize(0), ctypes.c_void_p(), ssize()
+		items = []
+		while api.next(d1, ctypes.byref(pos), ctypes.byref(key_ptr), ctypes.byref(key_length), ctypes.byref(ptr), ctypes.byref(length)):
+			items.append((ctypes.string_at(key_ptr, key_length.value).decode(), ctypes.string_at(ptr, length.value).decode()))
+		self.assertListEqual(sorted(items), sorted(d1.items()))
+
+		self.assertEqual(api.delete(d1, keys[0], len(keys[0])), 1)
+		self.assertEqual(api.delete(d1, keys[0], len(keys[0])), 0)
+		self.assertNotIn(keys[0].decode(), d1)
+
+		d1.freeze()
+		self.assertRaises(TypeError, api.set, d1, keys[1], len(keys[1]), b"", 0)
+		self.assertRaises(TypeError, api.delete, d1, keys[1], len(keys[1]))
+
+	def test_small_tables(self):
+		# Tables start in the small layout and move to the hashed one once they hold more than 8 items
+		keys = list(set(gen_random_str_list(20, self.key_len, self.UTF_size, seed=2231)))
+		vals = gen_random_str_list(len(keys), self.val_len, self.UTF_size, seed=991)
+		d1, ref = self.create_dict(), {}
+		for i in range(len(keys)):
+			d1[keys[i]] = vals[i]
+			ref[keys[i]] = vals[i]
+			if i % 3 == 0:
+				d1.pop(keys[i // 2])
+				ref.pop(keys[i // 2])
+			self.assertDictEqual(d1.to_Pydict(), ref)
+
+	def test_ordered(self):
+		d1 = mdict.create("str:str", self.key_len * self.UTF_size, self.val_len * self.UTF_size, ordered=True)
+		keys = list(dict.fromkeys(gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=5151)))
+		vals = gen_random_str_list(len(keys), self.val_len, self.UTF_size, seed=6161)
+		ref = {}
+		for i in range(len(keys)):
+			d1[keys[i]] = vals[i]
+			ref[keys[i]] = vals[i]
+		for i in range(0, len(keys), 3):
+			d1.pop(keys[i])
+			del ref[keys[i]]
+		for i in range(0, len(keys), 6):
+			d1[keys[i]] = vals[i]
+			ref[keys[i]] = vals[i]
+
+		self.assertListEqual(list(d1.items()), list(ref.items()))
+		self.assertListEqual(list(d1.copy()), list(ref))
+		self.assertRaises(ValueError, d1.freeze)
+		d1.clear()
+		d1[keys[1]] = vals[1]
+		d1[keys[0]] = vals[0]
+		self.assertListEqual(list(d1), [keys[1], keys[0]])
+
+	def test_cache(self):
+		keys = list(dict.fromkeys(gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=7171)))
+		cap = max(len(keys) // 3, 2)
+		d1 = mdict.create("str:str", self.key_len * self.UTF_size, self.val_len * self.UTF_size, max_items=cap)
+		ref = collections.OrderedDict()
+		for i, k in enumerate(keys):
+			if i % 3 == 2 and keys[i - 2] in ref:
+				self.assertIn(keys[i - 2], d1)
+				ref.move_to_end(keys[i - 2])
+			d1[k] = k
+			ref[k] = k
+			if len(ref) > cap:
+				ref.popitem(last=False)
+		self.assertDictEqual(d1.to_Pydict(), dict(ref))
+
+	def test_ttl(self):
+		d1 = self.create_dict()
+		keys = list(dict.fromkeys(gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=9191)))
+		for i, k in enumerate(keys):
+			d1.set(k, k, ttl=0.05 if i % 2 else None)
+		time.sleep(0.1)
+		live = {k:k for i, k in enumerate(keys) if i % 2 == 0}
+		self.assertListEqual([k in d1 for k in keys], [k in live for k in keys])
+		self.assertDictEqual(d1.to_Pydict(), live)
+		self.assertEqual(d1.expire(), 0)
+
+		d1.set(keys[0], keys[0], ttl=0.01)
+		time.sleep(0.05)
+		self.assertEqual(len(d1), len(live) - 1)
+		d1[keys[0]] = keys[0]
+		self.assertEqual(len(d1), len(live))
+
+		# Lookups and len leave the items that expire during an iteration in place rather than invalidating it
+		d2 = self.create_dict()
+		for i, k in enumerate(keys):
+			d2.set(k, k, ttl=0.01 if i % 2 else None)
+		it = iter(d2.items())
+		time.sleep(0.05)
+		n, last = 0, keys[(len(keys) - 2) | 1] # The last key set with a ttl, not reclaimed by iter(d2.items())
+		for k, v in it:
+			n += 1
+			len(d2)
+			self.assertIsNone(d2.get(last))
+			self.assertNotIn(last, d2)
+		self.assertGreaterEqual(n, len(live))
+		self.assertEqual(len(d2), len(live))
+
+	def test_budget(self):
+		keys = list(dict.fromkeys(gen_random_str_list(max(self.size, 300), self.key_len, self.UTF_size, seed=5353)))
+		key_bytes, val_bytes = self.key_len * self.UTF_size, self.val_len * self.UTF_size
+		budget = 100 * (key_bytes + val_bytes + 4)
+
+		d1 = mdict.create("str:str", key_bytes, val_bytes, max_bytes=budget)
+		n = 0
+		for k in keys:
+			try:
+				d1[k] = k
+			except MemoryError:
+				break
+			n += 1
+		self.assertLess(n, len(keys))
+		self.assertDictEqual(d1.to_Pydict(), {k:k for k in keys[:n]})
+
+		d2 = mdict.create("str:str", key_bytes, val_bytes, max_bytes=budget, policy="random")
+		for k in keys:
+			d2[k] = k
+		self.assertEqual(len(d2), n)
+		self.assertIn(keys[-1], d2)
+		self.assertRaises(ValueError, mdict.create, "str:str", key_bytes, val_bytes, max_bytes=budget, policy="lowest")
+		self.assertRaises(ValueError, mdict.create, "str:str", key_bytes, val_bytes, max_bytes=10)
+
+	def test_stats(self):
+		d1 = self.create_dict()
+		keys = list(dict.fromkeys(gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=6161)))
+		for k in keys:
+			d1[k] = k
+		st = d1.stats()
+		self.assertEqual(st["size"], len(keys))
+		self.assertEqual(st["array_bytes"]["keys"], st["num_buckets"] * (self.key_len * self.UTF_size + 2))
+		self.assertEqual(sum(st["probe_lengths"]), len(keys) if st["layout"] == "hashed" else 0)
+
+	def test_adversarial_keys(self):
+		size = min(self.size, 2000)
+		for key_set in adversarial.STR_KEY_SETS:
+			r = adversarial.stress("str:str", key_set, size) # Checks that every item reads back.
+			self.assertEqual(r["inserted"], size)
+			self.assertLess(r["max_psl"], 200)
+
 	def test_iterators(self):
 		d1 = self.create_dict()
 		keys = gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=23319)
@@ -92,6 +303,15 @@ class Test_str_str(unittest.TestCase):
 		self.assertListEqual(sorted(vals), sorted(d1.get_values()))
 		self.assertListEqual(sorted(items, key=sorter), sorted(d1.get_items(), key=sorter))
 
+		it1, it2 = iter(d1.items()), iter(d1.items())
+		self.assertListEqual(list(it1), list(it2))
+		it = iter(d1)
+		d1.pop(next(it))
+		self.assertRaises(RuntimeError, next, it)
+		it = iter(d1.values())
+		d1.clear()
+		self.assertRaises(RuntimeError, next, it)
+
 	def test_updating_conversion(self):
 		partition_size = int(self.size/2)
 		d1 = self.create_dict()
@@ -139,6 +359,7 @@ class Test_str_str(unittest.TestCase):
 
 		d2 = d1.copy()
 		self.assertListEqual(sorted(d1.items(), key=sorter), sorted(d2.items(), key=sorter))
+		self.assertListEqual([d2.pop(k) for k in keys[:partition_size]], vals[:partition_size]) # Shrinks d2 on the way.
 
 		self.assertEqual(len(d1), partition_size)
 		d1.clear([keys[0],keys[1]])
@@ -157,6 +378,66 @@ class Test_str_str(unittest.TestCase):
 		self.assertEqual(list(d2.items()), [])
 
 
+	def test_freeze(self):
+		d1 = self.create_dict()
+		keys = gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=23319)
+		vals = gen_random_str_list(self.size, self.val_len, self.UTF_size, seed=43431313)
+		items = list(zip(keys, vals))
+		sorter = lambda x:x[0]
+
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		d1.freeze()
+		self.assertTrue(d1.is_frozen())
+		self.assertEqual(len(d1), self.size)
+		self.assertListEqual([d1[k] for k in keys], vals)
+		self.assertEqual('#' in d1, '#' in keys)
+		self.assertListEqual(sorted(d1.get_items(), key=sorter), sorted(items, key=sorter))
+		self.assertDictEqual(d1.to_Pydict(), dict(items))
+
+		def set_val(d,k,v): d[k]=v
+		self.assertRaises(TypeError, set_val, d1, keys[0], vals[0])
+		self.assertRaises(TypeError, d1.pop, keys[0])
+		self.assertRaises(TypeError, d1.clear)
+
+		d2 = d1.copy()
+		self.assertFalse(d2.is_frozen())
+		self.assertListEqual(sorted(d2.items(), key=sorter), sorted(items, key=sorter))
+
+	@unittest.skipIf(os.name == 'nt', "POSIX shared memory is not available on Windows")
+	def test_shared_memory(self):
+		d1 = self.create_dict()
+		keys = gen_random_str_list(self.size, self.key_len, self.UTF_size, seed=23319)
+		vals = gen_random_str_list(self.size, self.val_len, self.UTF_size, seed=43431313)
+		name = "/microdict_test_str_%d" % os.getpid()
+
+		for i in range(self.size):
+			d1[keys[i]] = vals[i]
+
+		d1.share(name)
+		d2 = mdict.attach("str:str", name)
+		path = "/dev/shm" + name
+		if os.path.exists(path): # A string longer than its block is refused (see mdict_shm_header for the offsets).
+			with open(path, "r+b") as f:
+				f.seek(56)
+				keys_offset = struct.unpack("Q", f.read(8))[0]
+				f.seek(keys_offset)
+				length = f.read(2)
+				f.seek(keys_offset)
+				f.write(struct.pack("H", 65535))
+				f.flush()
+				self.assertRaises(ValueError, mdict.attach, "str:str", name)
+				f.seek(keys_offset)
+				f.write(length)
+				f.flush()
+			self.assertEqual(len(mdict.attach("str:str", name)), len(d1))
+		mdict.unlink(name)
+		self.assertTrue(d2.is_frozen())
+		self.assertEqual(d2.item_len(), d1.item_len())
+		self.assertListEqual([d2[k] for k in keys], vals)
+		self.assertDictEqual(d2.to_Pydict(), d1.to_Pydict())
+
 	def test_exceptions(self):
 		d1 = self.create_dict()
 		keys = [1, 2, 3]
@@ -178,6 +459,9 @@ class Test_str_str(unittest.TestCase):
 		self.assertRaises(TypeError, d1.pop, 1)
 		self.assertRaises(KeyError, d1.pop, '5')
 		self.assertRaises(TypeError, d1.clear, {})
+		self.assertRaises(TypeError, d1.get, 1)
+		self.assertRaises(TypeError, d1.get)
+		self.assertRaises(TypeError, d1.set, '1', '1', ttl=1, key='1')
 
 		d2 = {'1':1, '2':'2', 3:'3'}
 		d1.update(d2)
@@ -186,6 +470,57 @@ class Test_str_str(unittest.TestCase):
 
 
 
+class Test_str_int(unittest.TestCase):
+	size = 10
+
+	def test_str_i64(self):
+		d1 = mdict.create("str:i64", key_len=8)
+		keys = gen_random_str_list(self.size, 8, 1, seed=777)
+		for i, k in enumerate(keys):
+			d1[k] = -i
+		self.assertDictEqual(d1.to_Pydict(), {k:-i for i, k in enumerate(keys)})
+		self.assertListEqual(sorted(d1.items()), sorted((k, -i) for i, k in enumerate(keys)))
+		self.assertEqual(d1.pop(keys[0]), 0)
+		self.assertEqual(d1.get(keys[0], 5), 5)
+		self.assertEqual(d1.get('x' * 9, 5), 5)
+
+		def set_val(d,k,v): d[k]=v
+		self.assertRaises(TypeError, set_val, d1, 'x' * 9, 1)
+		self.assertRaises(TypeError, set_val, d1, 'x', '1')
+		self.assertRaises(TypeError, set_val, d1, 'x', 2**63)
+		self.assertRaises(TypeError, mdict.create, "str:i64")
+		self.assertRaises(ValueError, mdict.create, "str:i64", key_len=8, shards=2)
+
+		d2 = d1.copy()
+		d2.freeze()
+		self.assertDictEqual(d2.to_Pydict(), d1.to_Pydict())
+		d3 = mdict.create("str:i64", key_len=8, max_bytes=4096, policy="lowest")
+		for i in range(200):
+			d3[str(i)] = i
+		self.assertNotIn('0', d3)
+		self.assertIn('199', d3)
+
+	def test_i64_str(self):
+		d1 = mdict.create("i64:str", val_len=8)
+		vals = gen_random_str_list(self.size, 8, 1, seed=999)
+		for i, v in enumerate(vals):
+			d1[-i] = v
+		self.assertDictEqual(d1.to_Pydict(), {-i:v for i, v in enumerate(vals)})
+		self.assertListEqual(sorted(d1), sorted(-i for i in range(self.size)))
+		self.assertEqual(d1.pop(0), vals[0])
+		self.assertRaises(KeyError, d1.pop, 0)
+
+		def set_val(d,k,v): d[k]=v
+		self.assertRaises(TypeError, set_val, d1, 1, 'x' * 9)
+		self.assertRaises(TypeError, set_val, d1, '1', 'x')
+		self.assertRaises(TypeError, mdict.create, "i64:str")
+		self.assertRaises(ValueError, mdict.create, "i64:str", val_len=8, max_bytes=4096, policy="lowest")
+
+		d2 = mdict.create("i64:str", val_len=8, ordered=True)
+		d2.update({3:'c', 1:'a', 2:'b'})
+		self.assertListEqual(d2.get_items(), [(3,'c'), (1,'a'), (2,'b')])
+
+
 def runTests_str_str():
 	runner = unittest.TextTestRunner(verbosity=2)
 
@@ -202,6 +537,11 @@ def runTests_str_str():
 	suite = unittest.TestLoader().loadTestsFromTestCase(Test_str_str)
 	runner.run(suite)
 
+	Test_str_int.size = 100000
+	print("Running str_i64 and i64_str tests with number of items set to", Test_str_int.size)
+	suite = unittest.TestLoader().loadTestsFromTestCase(Test_str_int)
+	runner.run(suite)
+
 
 if __name__ == '__main__':
 	runTests_str_str()
\ No newline at end of file
@@ -0,0 +1,1630 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "structmember.h"
+
+#define MDICT_MALLOC PyMem_RawMalloc // The hashtable arrays are then visible to tracemalloc.
+#define MDICT_CALLOC PyMem_RawCalloc
+#define MDICT_REALLOC PyMem_RawRealloc
+#define MDICT_FREE PyMem_RawFree
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "dtypes_Py.h"
+#include "str_str_wyhash.h"
+#include <stdbool.h>
+#include <inttypes.h>
+#include "flags.h"
+#include "microdict_api.h"
+
+/*
+    Binding of the tables with a string key and/or value, compiled once per (dtype_key, dtype_val) pair by setup.py :
+    str_str, str_i64 and i64_str. An integer side behaves as in int_int_Py.c.
+*/
+
+#if dtype_key == 5
+    #define _key_match(a, b) ((a).len == (b).len && _strncmp((a).str, (b).str, (a).len))
+#else
+    #define _key_match(a, b) ((a) == (b))
+#endif
+
+
+typedef struct {
+    PyObject_HEAD
+    h_t* ht;
+    bool valid_ht;
+    kbox_t temp_key;
+    vbox_t temp_val;
+    bool temp_isvalid;
+    char key_size_str[6];
+    char val_size_str[6];
+    uint32_t flags;
+    int active_iters;   // Number of running iterators, which hold the expired items in place (see _hold_expired).
+} dictObj;
+
+typedef struct
+{
+    PyObject_HEAD
+    dictObj* dict;
+    h_t* ht;            // dict->ht when the iterator was created
+    uint64_t version;   // ht->version when the iterator was created
+    i_t iter_idx;
+    i_t iter_num;
+    bool holds;         // Whether the iterator is counted by dict->active_iters
+} iterObj;
+
+
+static void iter_dealloc(iterObj* self);
+static PyObject* key_iternext(iterObj* self);
+static PyObject* value_iternext(iterObj* self);
+static PyObject* item_iternext(iterObj* self);
+
+
+static PyTypeObject MDICT_SYM(keyIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " key iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) key_iternext,
+};
+
+static PyTypeObject MDICT_SYM(valueIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " value iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) value_iternext,
+};
+
+static PyTypeObject MDICT_SYM(itemIterType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME " item iterator",
+    .tp_doc = "",
+    .tp_basicsize = sizeof(iterObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_dealloc = (destructor) iter_dealloc,
+    .tp_iter = PyObject_SelfIter,
+    .tp_iternext = (iternextfunc) item_iternext,
+};
+
+
+void _expire(dictObj* self);
+
+static void _hold_expired(dictObj* dict, bool* holds, bool hold) {
+    /*
+    Starts or ends the hold of an iterator over dict. Reclaiming an expired item changes the version of the hashtable
+    and would invalidate the running iterators, so while any of them holds, lookups and len leave the expired items in
+    place (see mdict_ttl.h) : ht->ext->expire_holds counts the holding iterators whenever ht has an expiry. An iterator
+    holds from its creation until it is exhausted, invalidated or deallocated.
+    */
+
+    if (*holds == hold)
+        return;
+    *holds = hold;
+    dict->active_iters += hold ? 1 : -1;
+    if (_ext(dict->ht, expiry))
+        dict->ht->ext->expire_holds += hold ? 1 : -1;
+}
+
+static PyObject* _new_iter(dictObj* dict, PyTypeObject* type) {
+    /*
+    Returns a new iterator of the given type over dict. Every call to iter(dict), dict.values() or dict.items() gets its
+    own iterator, so nested and interleaved iterations do not share a cursor.
+    */
+
+    _expire(dict);
+    iterObj* self = PyObject_New(iterObj, type);
+    if (!self)
+        return NULL;
+
+    Py_INCREF(dict);
+    self->dict = dict;
+    self->ht = dict->ht;
+    self->version = dict->ht->version;
+    self->iter_idx = 0;
+    self->iter_num = 0;
+    self->holds = false;
+    _hold_expired(dict, &self->holds, true);
+    return (PyObject*) self;
+}
+
+static void iter_dealloc(iterObj* self) {
+    _hold_expired(self->dict, &self->holds, false);
+    Py_DECREF(self->dict);
+    PyObject_Del(self);
+}
+
+static int _iter_check(iterObj* self) {
+    /*
+    Raises a RuntimeError and returns -1 if an item was inserted into or deleted from the dictionary (or the dictionary
+    was cleared or frozen) since the iterator was created.
+    */
+
+    if (self->dict->ht != self->ht || self->ht->version != self->version) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetString(PyExc_RuntimeError, "microdictionary changed size during iteration");
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject* value_iternext(iterObj* self) {
+    /*
+    Iterates over the values when __next__ is called on the iterator. Each time this function is called by __next__, the next value is returned.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    vbox_t val;
+    int v_step_inc = h->v_step_increment;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    val = _get_val(h, GET_PTR(i, v_step_inc));
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+
+    return _val_to_py(val);
+}
+
+
+static PyObject* item_iternext(iterObj* self) {
+    /*
+    Iterates over the items when __next__ is called on the iterator. Each time this function is called by __next__, the next item (key, value) is returned.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    kbox_t key; vbox_t val;
+    int k_step_inc = h->k_step_increment;
+    int v_step_inc = h->v_step_increment;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    key = _get_key(h, GET_PTR(i, k_step_inc));
+    val = _get_val(h, GET_PTR(i, v_step_inc));
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+
+    return Py_BuildValue("(NN)", _key_to_py(key), _val_to_py(val));
+}
+
+void _set_default_flags(dictObj* self) {
+    self->flags = 0;
+    _set_flag(&self->flags, FLAG_POP_ARG_EXC, true);
+    _set_flag(&self->flags, FLAG_POP_RET_EXC, true);
+}
+
+void _destroy(dictObj* self){
+    /*
+    Called by the destructor for deleting the hashtable.
+    */
+ 
+    if (self->valid_ht == true){
+        mdict_delete_ht(self->ht);
+        self->valid_ht = false;
+    }
+}
+
+int _check_frozen(dictObj* self) {
+    /*
+    Raises a TypeError and returns -1 if the hashtable has been frozen by dict.freeze(). Returns 0 otherwise.
+    */
+
+    if (self->ht->is_frozen) {
+        PyErr_SetString(PyExc_TypeError, "Cannot modify a frozen microdictionary");
+        return -1;
+    }
+    return 0;
+}
+
+int _parse_key(dictObj* self, PyObject* obj, kbox_t* k) {
+    /*
+    Converts obj into a key. Returns 0 on success, -1 if obj is not of the key type and -2 if it is a string longer
+    than key_str_len. The caller raises the error, e.g. with _key_type_error.
+    */
+
+#if dtype_key == 5
+    Py_ssize_t len;
+    k->str = (char*) PyUnicode_AsUTF8AndSize(obj, &len);
+    if (k->str == NULL)
+        return -1;
+    if (len > self->ht->key_str_len)
+        return -2;
+    k->len = len;
+#else
+    uint64_t x;
+    if (_int_from_py(obj, KEY_IS_SIGNED, KEY_MIN, KEY_MAX, &x) == -1)
+        return -1;
+    *k = (kbox_t) x;
+#endif
+    return 0;
+}
+
+int _parse_val(dictObj* self, PyObject* obj, vbox_t* v) {
+    /*
+    Converts obj into a value, returning 0, -1 or -2 like _parse_key.
+    */
+
+#if dtype_val == 5
+    Py_ssize_t len;
+    v->str = (char*) PyUnicode_AsUTF8AndSize(obj, &len);
+    if (v->str == NULL)
+        return -1;
+    if (len > self->ht->val_str_len)
+        return -2;
+    v->len = len;
+#else
+    uint64_t x;
+    if (_int_from_py(obj, VAL_IS_SIGNED, VAL_MIN, VAL_MAX, &x) == -1)
+        return -1;
+    *v = (vbox_t) x;
+#endif
+    return 0;
+}
+
+void _key_type_error(dictObj* self) {
+#if dtype_key == 5
+    PyErr_Format(PyExc_TypeError, "Key needs to be a string of size at most %d", self->ht->key_str_len);
+#else
+    PyErr_SetString(PyExc_TypeError, "Key needs to be a " KEY_DESC " Int");
+#endif
+}
+
+void _val_type_error(dictObj* self) {
+#if dtype_val == 5
+    PyErr_Format(PyExc_TypeError, "Value needs to be a string of size at most %d", self->ht->val_str_len);
+#else
+    PyErr_SetString(PyExc_TypeError, "Value needs to be a " VAL_DESC " Int");
+#endif
+}
+
+void _key_error(kbox_t k) {
+    /*
+    Raises a KeyError for the absent key k, holding the key for an integer key type.
+    */
+
+#if dtype_key == 5
+    PyErr_SetString(PyExc_KeyError, "");
+#else
+    PyErr_SetObject(PyExc_KeyError, _key_to_py(k));
+#endif
+}
+
+void _expire(dictObj* self) {
+    /*
+    Reclaims the expired items (see mdict_ttl.h) before a full scan of the hashtable, so that the scan does not return
+    them. Skipped while an iterator holds (see _hold_expired).
+    */
+
+    if (_ext(self->ht, expiry) && self->active_iters == 0 && mdict_expire(self->ht) > 0)
+        self->temp_isvalid = false;
+}
+
+void _create(dictObj* self, i_t k_maxLength, i_t v_maxLength){
+    /*
+    Called by the constructor for allocating and initializing the hashtable.
+    */
+ 
+    if (self->valid_ht == false){
+        ht_param param = {dtype_key, k_maxLength, dtype_val, v_maxLength, k_maxLength+2, v_maxLength+2};
+        self->ht = mdict_create(&param);  
+        self->valid_ht = true;
+        self->temp_isvalid = false;
+        sprintf(self->key_size_str, "%d", self->ht->key_str_len);
+        sprintf(self->val_size_str, "%d", self->ht->val_str_len);
+    }    
+}
+
+ 
+static void custom_dealloc(dictObj* self) {
+    /*
+    The destructor
+    */
+
+    _destroy(self);
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject* custom_new(PyTypeObject *type, PyObject *args) {
+    /*
+    Allocates the dictObj
+    */
+
+    dictObj* self = (dictObj*) type->tp_alloc(type, 0);
+    self->valid_ht = false;
+    self->ht = NULL;
+    _set_default_flags(self);
+    return (PyObject*) self;
+}
+
+
+static int custom_init(dictObj* self, PyObject *args, PyObject *kwds) {
+    /*
+    Constructor for allocating and initializing the hashtable along with the iterators.
+    If ordered is true, the hashtable uses the insertion ordered layout of mdict_ordered.h.
+    If max_items is positive, the hashtable holds at most that many items and inserting a new key into a full
+    hashtable first evicts an item according to policy ("lru" or "clock", see mdict_evict.h).
+    If max_bytes is positive, the arrays of the hashtable take at most that many bytes (see mdict_budget.h). An insert
+    that would grow them past it either raises MemoryError (policy "fail", the default) or first removes a random item
+    (policy "random"). With "lru" or "clock", the capacity is the largest one that fits max_bytes. A max_bytes smaller
+    than the arrays of an empty hashtable raises a ValueError.
+    */
+
+    int k_maxLength = 0, v_maxLength = 0, ordered = 0, max_items = 0, policy = EVICT_NONE, budget_policy = BUDGET_FAIL;
+    const char* policy_name = NULL;
+    Py_ssize_t max_bytes = 0;
+
+#if dtype_key == 5 && dtype_val == 5
+    static char* kwlist[] = {"key_len", "val_len", "ordered", "max_items", "policy", "max_bytes", NULL};
+    int ret_val = PyArg_ParseTupleAndKeywords(args, kwds, "ii|pizn", kwlist, &k_maxLength, &v_maxLength, &ordered, &max_items, &policy_name, &max_bytes);
+#elif dtype_key == 5
+    static char* kwlist[] = {"key_len", "ordered", "max_items", "policy", "max_bytes", NULL};
+    int ret_val = PyArg_ParseTupleAndKeywords(args, kwds, "i|pizn", kwlist, &k_maxLength, &ordered, &max_items, &policy_name, &max_bytes);
+#else
+    static char* kwlist[] = {"val_len", "ordered", "max_items", "policy", "max_bytes", NULL};
+    int ret_val = PyArg_ParseTupleAndKeywords(args, kwds, "i|pizn", kwlist, &v_maxLength, &ordered, &max_items, &policy_name, &max_bytes);
+#endif
+    if (!ret_val) {
+        Py_DECREF(self);
+        return -1;
+    }
+
+    if (k_maxLength > str_len_MAX || v_maxLength > str_len_MAX) {
+        PyErr_SetString(PyExc_ValueError, "key_len and val_len must be at most 65535");
+        Py_DECREF(self);
+        return -1;
+    }
+
+    if (max_items < 0 || max_bytes < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_items and max_bytes must be positive");
+        return -1;
+    }
+
+    if (max_items || max_bytes) {
+        if (!policy_name)
+            policy_name = max_items ? "lru" : "fail";
+        policy = mdict_evict_policy(policy_name);
+        if (policy < 0) {
+            policy = EVICT_NONE;
+            budget_policy = max_items ? -1 : mdict_budget_policy(policy_name);
+        }
+        if (budget_policy < 0) {
+#if dtype_val == 5
+            PyErr_SetString(PyExc_ValueError, "policy must be \"lru\" or \"clock\", or with max_bytes alone \"fail\" or \"random\"");
+#else
+            PyErr_SetString(PyExc_ValueError, "policy must be \"lru\" or \"clock\", or with max_bytes alone \"fail\", \"random\" or \"lowest\"");
+#endif
+            return -1;
+        }
+    }
+
+    if ((max_items || max_bytes) && ordered) {
+        PyErr_SetString(PyExc_ValueError, "max_items and max_bytes can not be combined with ordered");
+        return -1;
+    }
+
+    _create(self, k_maxLength, v_maxLength);
+    if (ordered && mdict_ordered_enable(self->ht) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    if (policy && max_bytes) {
+        i_t budget_items = mdict_budget_max_items(self->ht, max_bytes, policy);
+        if (!budget_items) {
+            PyErr_SetString(PyExc_ValueError, "max_bytes is too small for the lru and clock policies");
+            return -1;
+        }
+        if (!max_items || budget_items < max_items)
+            max_items = budget_items;
+    }
+    if (policy && mdict_evict_enable(self->ht, max_items, policy) < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    ret_val = max_bytes ? mdict_budget_enable(self->ht, max_bytes, budget_policy) : 0;
+    if (ret_val == -2) {
+        PyErr_SetString(PyExc_ValueError, "max_bytes is too small for the arrays of an empty microdictionary");
+        return -1;
+    } else if (ret_val < 0) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    return 0;
+}
+
+
+static PyObject* del(dictObj* self, PyObject* str_obj){
+    /*
+    dict.pop() invokes this function. Only accepts a python string object of size at most key_str_len.
+    If the key argument is present, then this function deletes it. Otherwise it will either raise a KeyError
+    or return a None object depending on whether FLAG_POP_RET_EXC flag is set or not. 
+    By default, FLAG_POP_RET_EXC flag is set. If FLAG_POP_RET_EXC is set, then it raises an exception if the key
+    has length larger than key_str_len, otherwise returns None. By default, FLAG_POP_ARG_EXC is set.
+    */
+
+    kbox_t k; vbox_t v; int ret_val;
+
+    if (_check_frozen(self) == -1)
+        return NULL;
+
+    ret_val = _parse_key(self, str_obj, &k);
+    if (ret_val == -2 && !_get_flag(self->flags, FLAG_POP_ARG_EXC))
+        return Py_BuildValue("");
+    if (ret_val < 0) {
+        _key_type_error(self);
+        return NULL;
+    }
+
+    if (self->temp_isvalid && _key_match(k, self->temp_key))
+        self->temp_isvalid = false;
+
+
+    i_t idx;
+    v = mdict_get_map(self->ht, k, &idx);
+    if (idx == self->ht->num_buckets) {
+        if (!_get_flag(self->flags, FLAG_POP_RET_EXC))
+            return Py_BuildValue("");
+        _key_error(k);
+        return NULL;
+    }
+
+    PyObject* val_obj = _val_to_py(v); // Converted first : v points into the vals array, which the deletion may free by shrinking the table.
+    if (val_obj)
+        mdict_del_map(self->ht, k, NULL);
+    return val_obj;
+}
+
+
+static PyObject* clear(dictObj* self, PyObject* const* args, Py_ssize_t nargs){
+    /*
+    This function is called when dict.clear() is invoked. It takes an optional list argument which (if given)
+    must contain keys of str type with length of at most key_str_len. Goals is to delete all the keys present
+    in the given list. If the key type and length constraint is not met then either it will raise a TypeError
+    the first time the constraint is violated or just skip that key depending on whether FLAG_CLEAR_RET_EXC flag
+    is set. FLAG_CLEAR_RET_EXC is set by default.
+
+    If no argument is provided then, then a empty hashtable is created. Note that the PyObject is the same.
+    */
+
+    kbox_t k; int ret_val;
+    PyObject* list=NULL;
+
+    if (_fastcall_args("clear", args, nargs, NULL, NULL, 0, 1, &list) == -1)
+        return NULL;
+
+    if (_check_frozen(self) == -1)
+        return NULL;
+
+    if (!list && _ext(self->ht, policy)) {
+        mdict_evict_clear(self->ht); // Keeps the capacity and the eviction policy.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list && self->ht->is_ordered) {
+        mdict_ordered_clear(self->ht); // Keeps the insertion ordered layout.
+        self->temp_isvalid = false;
+        return Py_BuildValue("");
+    }
+
+    if (!list) {
+        uint64_t version = self->ht->version;
+        i_t key_str_len = self->ht->key_str_len, val_str_len = self->ht->val_str_len;
+        size_t max_bytes = _ext(self->ht, max_bytes);
+        int budget_policy = _ext(self->ht, budget_policy);
+        _destroy(self);
+        _create(self, key_str_len, val_str_len);
+        self->ht->version = version + 1; // Invalidates the running iterators.
+        if (max_bytes && mdict_budget_enable(self->ht, max_bytes, budget_policy) < 0) // Keeps the memory budget.
+            return PyErr_NoMemory();
+        return Py_BuildValue("");
+    }
+
+    if (!PyList_CheckExact(list)) {
+        PyErr_SetString(PyExc_TypeError, "The first optional argument must be a list");
+        return NULL;
+    }
+
+    Py_ssize_t len = PyList_Size(list);
+
+    for (Py_ssize_t i=0; i<len; ++i){
+        PyObject* item = PyList_GetItem(list, i);
+        if (_parse_key(self, item, &k) == 0) {
+            mdict_del_map(self->ht, k, NULL);
+        } else if (_get_flag(self->flags, FLAG_CLEAR_RET_EXC)) {
+            _key_type_error(self);
+            return NULL;
+        }
+    }
+
+    self->temp_isvalid = false;
+    PyErr_Clear();
+    return Py_BuildValue("");
+}
+
+
+
+static PyObject* get_keys(dictObj* self) {
+    /*
+    This is called when dict.get_keys() is called. It returns a list containing all keys.
+    In case it fails to add a key into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    int k_step_inc = h->k_step_increment;
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        kbox_t key = _get_key(h, GET_PTR(i, k_step_inc));
+        PyObject* item = _key_to_py(key);
+        if (item != NULL) {
+            PyList_SET_ITEM(list, idx, item);
+        } else {
+            PyList_SET_ITEM(list, idx, Py_BuildValue(""));
+        }
+        idx += 1;
+    }
+
+    return list;
+}
+
+static PyObject* get_values(dictObj* self) {
+    /*
+    This is called when dict.get_values() is called. It returns a list containing all values.
+    In case it fails to add a value into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    int v_step_inc = h->v_step_increment;
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        vbox_t val = _get_val(h, GET_PTR(i, v_step_inc));
+        PyObject* item = _val_to_py(val);
+        if (item != NULL) {
+            PyList_SET_ITEM(list, idx, item);
+        } else {
+            PyList_SET_ITEM(list, idx, Py_BuildValue(""));
+        }
+        idx += 1;
+    }
+
+    return list;
+}
+
+static PyObject* get_items(dictObj* self) {
+    /*
+    This is called when dict.get_items() is called. It returns a list containing all items (key,value).
+    In case it fails to add an item into the list, a None object is instead added.
+    */
+
+    _expire(self);
+    i_t len = self->ht->size;
+    h_t* h = self->ht;
+
+    PyObject* list = PyList_New(len);    
+    if (!list) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the list object");
+        return NULL;
+    }
+
+    int k_step_inc = h->k_step_increment;
+    int v_step_inc = h->v_step_increment;
+    Py_ssize_t idx = 0;
+    for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<len; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+        kbox_t key = _get_key(h, GET_PTR(i, k_step_inc));
+        vbox_t val = _get_val(h, GET_PTR(i, v_step_inc));
+        PyObject* item_key = _key_to_py(key);
+        PyObject* item_val = _val_to_py(val);
+        if (item_key != NULL && item_val != NULL) {
+            PyObject* item_obj = PyTuple_Pack(2, item_key, item_val);
+            if (item_obj != NULL) {
+                PyList_SET_ITEM(list, idx, item_obj);
+            } else {
+                PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to add all (Key, value) pairs to the list");
+                Py_DECREF(list);
+                return NULL;                
+            }
+        } else {
+            Py_XDECREF(item_key);
+            Py_XDECREF(item_val);
+            PyList_SET_ITEM(list, idx, Py_BuildValue(""));                
+        }
+        idx += 1;
+    }
+
+    return list;
+}
+
+int _update_from_Pydict(dictObj* self, PyObject* dict) {
+    /*
+    This function updates the hashtable with items from a given Python Dictionary. In case the python
+    dictionary contains an item with non-matching types, then either that item will be skipped or TypeError
+    will be raised depending on whether FLAG_UPDATE_ARG_EXC is set or not. FLAG_UPDATE_ARG_EXC is set by default.
+    */
+
+    PyObject *key_obj, *value_obj;
+    Py_ssize_t pos = 0;
+    kbox_t key;
+    vbox_t val;
+
+    while (PyDict_Next(dict, &pos, &key_obj, &value_obj)) {
+        if (_parse_key(self, key_obj, &key) != 0) {
+            if (_get_flag(self->flags, FLAG_UPDATE_ARG_EXC)) {
+                _key_type_error(self);
+                return -1;
+            } else
+                continue;
+        }
+
+        if (_parse_val(self, value_obj, &val) != 0) {
+            if (_get_flag(self->flags, FLAG_UPDATE_ARG_EXC)) {
+                _val_type_error(self);
+                return -1;
+            } else
+                continue;
+        }
+
+        if (mdict_set(self->ht, key, val) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+            return -1;
+        }
+    }
+
+    return 0;    
+}
+
+int _update_from_mdict(dictObj* self, dictObj* dict) {
+    /*
+    This function updates the hashtable with all the items from another dictionary (dict) of the same key, value type.
+    Returns -1 and raises MemoryError if an item could not be inserted.
+    */
+
+    _expire(dict);
+    h_t* h = self->ht;
+    h_t* h2 = dict->ht;
+    Py_ssize_t idx = 0;
+    int k_step_inc = h->k_step_increment;
+    int v_step_inc = h->v_step_increment;
+
+    for (i_t i=_flags_next_occupied(h2->flags, 0, h2->num_buckets); idx<h2->size; i=_flags_next_occupied(h2->flags, i+1, h2->num_buckets)) {
+        kbox_t key = _get_key(h2, GET_PTR(i, k_step_inc));
+        vbox_t val = _get_val(h2, GET_PTR(i, v_step_inc));
+        if (mdict_set(h, key, val) == -1) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+            return -1;
+        }
+        idx += 1;
+    }
+    return 0;
+}
+
+
+static PyObject* to_Pydict(dictObj* self) {
+    /*
+    Returns a newly created python dictionary after updating it with all the items from the hashtable.
+    Raises MemoryError if the dictionary could not successfully populated.
+    */
+
+    _expire(self);
+    h_t* h = self->ht;
+    PyObject* dict = PyDict_New();
+    int k_step_inc = h->k_step_increment;
+    int v_step_inc = h->v_step_increment;
+
+    if (dict != NULL) {
+        Py_ssize_t idx = 0;
+        for (i_t i=_flags_next_occupied(h->flags, 0, h->num_buckets); idx<h->size; i=_flags_next_occupied(h->flags, i+1, h->num_buckets)) {
+            kbox_t key = _get_key(h, GET_PTR(i, k_step_inc));
+            vbox_t val = _get_val(h, GET_PTR(i, v_step_inc));
+            PyObject* item_key = _key_to_py(key);
+            PyObject* item_val = _val_to_py(val);
+            if (item_key != NULL && item_val != NULL) {
+                if (PyDict_SetItem(dict, item_key, item_val) == -1) {
+                    if (_get_flag(self->flags, FLAG_PYDICT_ARG_EXC)) {    
+                        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Could not add all (key, value) pairs to the Python Dictionary object");
+                        Py_DECREF(dict);
+                        return NULL;
+                    } else
+                        return dict;
+                }
+            } else if (_get_flag(self->flags, FLAG_PYDICT_ARG_EXC)) {
+                PyErr_SetString(PyExc_UnicodeDecodeError, "Could not decode UTF8 using PyUnicode_DecodeUTF8 function"); 
+                Py_DECREF(dict);
+                Py_XDECREF(item_key);
+                Py_XDECREF(item_val);
+                return NULL;                   
+            } else {
+                Py_XDECREF(item_key);
+                Py_XDECREF(item_val);
+            }
+            idx += 1;
+        }
+        return dict;
+    } else {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Could not allocate the Python Dictionary object");
+        return NULL;
+    }
+}
+
+
+static int _contains_(dictObj* self, PyObject* key) {
+    /*
+    This function is called for the python expression 'k in dict' . k must be of the same type as the hashtable keys.
+    */
+
+    kbox_t k; i_t idx;
+
+    if (_parse_key(self, key, &k) != 0) {
+        _key_type_error(self);
+        return -1;
+    }
+
+    mdict_get_map(self->ht, k, &idx);
+    if (idx != self->ht->num_buckets)
+        return 1;
+    else
+        return 0;
+}
+
+static int _len_(dictObj* self) {
+    /*
+    This function is called when len(dict) is called. It returns the total number of items present.
+    */
+    _expire(self); // Expired items are not counted.
+    return self->ht->size;
+}
+
+
+static bool _cache_hit(dictObj* self, kbox_t k) {
+    /*
+    True if k is the key of the item cached by the key iterator (see key_iternext). Tables with expiring items do not
+    use the cache, since the cached item may have expired since it was cached, nor do bounded tables, whose lookups
+    must mark the item as recently used (see mdict_evict.h).
+    */
+
+    return self->temp_isvalid && !_ext(self->ht, expiry) && !_ext(self->ht, policy) && _key_match(k, self->temp_key);
+}
+
+static PyObject* mapping_get(dictObj* self, PyObject* key){
+    /*
+    This function is invoked when dict[k] is called to return the corresponding value if present. If not present, a KeyError
+    is raised if flag FLAG_GET_RET_EXC is set and otherwise, a None is returned. By default FLAG_GET_RET_EXC 
+    is not set.
+    */
+    
+    kbox_t k; vbox_t v; i_t idx;
+
+    if (_parse_key(self, key, &k) != 0) {
+        _key_type_error(self);
+        return NULL;
+    }
+
+    if (_cache_hit(self, k)) {
+        return _val_to_py(self->temp_val);
+    } else {
+        v = mdict_get_map(self->ht, k, &idx);
+        if (idx != self->ht->num_buckets)
+            return _val_to_py(v);
+        else {
+            if (!_get_flag(self->flags, FLAG_GET_RET_EXC))
+                return Py_BuildValue("");
+
+            _key_error(k);
+            return NULL;
+        }
+    }
+}
+
+static PyObject* get(dictObj* self, PyObject* const* args, Py_ssize_t nargs) {
+    /*
+    Invoked for d.get(key, default=None). Returns the value of key if present and default otherwise, whether or not
+    FLAG_GET_RET_EXC is set. A key longer than key_str_len can not be present, so it gives default too.
+    */
+
+    kbox_t k; vbox_t v; i_t idx;
+    PyObject* params[2] = {NULL, Py_None};
+
+    if (_fastcall_args("get", args, nargs, NULL, NULL, 1, 2, params) == -1)
+        return NULL;
+
+    int ret_val = _parse_key(self, params[0], &k);
+    if (ret_val == -1) {
+        _key_type_error(self);
+        return NULL;
+    }
+
+    if (ret_val == 0) {
+        if (_cache_hit(self, k))
+            return _val_to_py(self->temp_val);
+
+        v = mdict_get_map(self->ht, k, &idx);
+        if (idx != self->ht->num_buckets)
+            return _val_to_py(v);
+    }
+
+    Py_INCREF(params[1]);
+    return params[1];
+}
+
+static int _set_item(dictObj* self, kbox_t k, vbox_t v) {
+    /*
+    Inserts k -> v into the (mutable) hashtable and keeps the cached item consistent. Raises a MemoryError and returns
+    -1 if the insertion fails.
+    */
+
+    if (mdict_set(self->ht, k, v) == -1) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to insert the item");
+        return -1;
+    }
+
+    if (self->temp_isvalid && _key_match(k, self->temp_key)) { // This logic supports that setting a value does not necessarily cache (key, val) pair and that the cache is mainly for the iterator.
+        self->temp_val = v;
+    } else if (_ext(self->ht, policy) || _ext(self->ht, max_bytes) || _ext(self->ht, expiry)) {
+        self->temp_isvalid = false; // The cached item may have been evicted or reclaimed.
+    }
+
+    return 0;
+}
+
+static int mapping_set(dictObj* self, PyObject* key, PyObject* val){
+    /*
+    This is invoked for the python expression d[key] = value. Both key and value must be of the hashtable type.
+    */
+
+    vbox_t v; kbox_t k;
+
+    if (_check_frozen(self) == -1)
+        return -1;
+
+    if (_parse_key(self, key, &k) != 0) {
+        _key_type_error(self);
+        return -1;
+    }
+
+    if (_parse_val(self, val, &v) != 0) {
+        _val_type_error(self);
+        return -1;
+    }
+
+    return _set_item(self, k, v);
+}
+
+static PyObject* set(dictObj* self, PyObject* const* args, Py_ssize_t nargs, PyObject* kwnames) {
+    /*
+    Invoked for d.set(key, value, ttl=None). Same as d[key] = value, except that if ttl is given the item expires ttl
+    seconds later : it is then treated as absent and reclaimed lazily (see mdict_ttl.h). Setting a key without a ttl
+    makes it permanent again.
+    */
+
+    static const char* kwlist[] = {"key", "value", "ttl"};
+    PyObject* params[3] = {NULL, NULL, Py_None};
+    double seconds = 0;
+
+    if (_fastcall_args("set", args, nargs, kwnames, kwlist, 2, 3, params) == -1)
+        return NULL;
+    PyObject *key = params[0], *val = params[1], *ttl = params[2];
+
+    if (ttl != Py_None) {
+        if (_check_frozen(self) == -1)
+            return NULL;
+
+        seconds = PyFloat_AsDouble(ttl);
+        if (seconds == -1 && PyErr_Occurred())
+            return NULL;
+        if (!(seconds > 0)) {
+            PyErr_SetString(PyExc_ValueError, "ttl must be a positive number of seconds");
+            return NULL;
+        }
+
+        bool had_expiry = _ext(self->ht, expiry) != NULL;
+        int ret_val = mdict_ttl_enable(self->ht);
+        if (ret_val == -2) {
+            PyErr_SetString(PyExc_ValueError, "ttl is not supported by ordered, key_range or concurrent_reads microdictionaries");
+            return NULL;
+        } else if (ret_val < 0) {
+            return PyErr_NoMemory();
+        }
+        if (!had_expiry)
+            self->ht->ext->expire_holds += self->active_iters; // The running iterators now hold (see _hold_expired).
+    }
+
+    if (mapping_set(self, key, val) < 0)
+        return NULL;
+
+    if (ttl != Py_None) {
+        kbox_t k;
+        _parse_key(self, key, &k); // Cannot fail, mapping_set parsed it already.
+        mdict_ttl_expire_at(self->ht, k, mdict_now_ns() + (uint64_t) (MIN(seconds, 1e9) * 1e9));
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* expire(dictObj* self) {
+    /*
+    Invoked for d.expire(). Removes all the expired items right away and returns how many were removed.
+    */
+
+    if (_ext(self->ht, expiry) && _check_frozen(self) == -1)
+        return NULL;
+
+    i_t removed = mdict_expire(self->ht);
+    if (removed > 0)
+        self->temp_isvalid = false;
+    return PyLong_FromLong((long) removed);
+}
+
+static PyObject* mdict_iter(dictObj* self) {
+    /*
+    Returns a new iterator over the keys when __iter__(dict) is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(keyIterType));
+}
+
+
+static PyObject* key_iternext(iterObj* self) {
+    /*
+    Iterates over the keys. Each time __next__ is called on the key iterator, this function returns the next key.
+    The current item is cached in the dictionary, so that d[k] is free within a "for k in d" loop.
+    */
+
+    if (_iter_check(self) == -1)
+        return NULL;
+
+    if (self->iter_num >= self->ht->size) {
+        _hold_expired(self->dict, &self->holds, false);
+        PyErr_SetNone(PyExc_StopIteration);
+        self->dict->temp_isvalid = false;
+        return NULL;
+    }
+
+    h_t* h = self->ht;
+    int k_step_inc = h->k_step_increment;
+    int v_step_inc = h->v_step_increment;
+
+    i_t i = _flags_next_occupied(h->flags, self->iter_idx, h->num_buckets);
+    self->dict->temp_key = _get_key(h, GET_PTR(i, k_step_inc));
+    self->dict->temp_val = _get_val(h, GET_PTR(i, v_step_inc));
+    self->iter_idx = i+1;
+    self->iter_num += 1;
+    self->dict->temp_isvalid = true;
+
+    return _key_to_py(self->dict->temp_key);
+}
+
+
+static PyObject* update(dictObj* self, PyObject* dict);
+
+static PyObject* get_value_iterator(dictObj* self) {
+    /*
+    Returns a new iterator over the values when dict.values() is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(valueIterType));
+}
+
+static PyObject* get_item_iterator(dictObj* self) {
+    /*
+    Returns a new iterator over the (key, value) items when dict.items() is called.
+    */
+
+    return _new_iter(self, &MDICT_SYM(itemIterType));
+}
+
+static PyObject* _create_args(h_t* h) {
+    /*
+    Returns the positional arguments of the constructor for a dictionary of the same maximum string lengths as h.
+    */
+
+#if dtype_key == 5 && dtype_val == 5
+    return Py_BuildValue("ii", h->key_str_len, h->val_str_len);
+#elif dtype_key == 5
+    return Py_BuildValue("(i)", h->key_str_len);
+#else
+    return Py_BuildValue("(i)", h->val_str_len);
+#endif
+}
+
+static PyObject* copy(dictObj* self) {
+    /*
+    Returns a new microdictionary object containing all items present in this hashtable when dict.copy() is called.
+    */
+
+    PyObject* args = _create_args(self->ht);
+    dictObj* new_obj = (dictObj *) PyObject_CallObject(((PyObject *) self)->ob_type, args);
+    Py_DECREF(args);
+    if (!new_obj)
+        return NULL;
+    h_ext_t* ext = self->ht->ext;
+    if ((self->ht->is_ordered && mdict_ordered_enable(new_obj->ht) < 0) ||
+        (ext && ext->policy && mdict_evict_enable(new_obj->ht, ext->max_items, ext->policy) < 0) ||
+        (ext && ext->max_bytes && mdict_budget_enable(new_obj->ht, ext->max_bytes, ext->budget_policy) < 0)) {
+        Py_DECREF(new_obj);
+        return PyErr_NoMemory();
+    }
+    if (_update_from_mdict(new_obj, self) == -1) {
+        Py_DECREF(new_obj);
+        return NULL;
+    }
+    if (mdict_ttl_copy(new_obj->ht, self->ht) < 0) {
+        Py_DECREF(new_obj);
+        return PyErr_NoMemory();
+    }
+    return (PyObject*) new_obj;
+}
+
+static PyObject* freeze(dictObj* self) {
+    /*
+    Invoked when dict.freeze() is called. Converts the hashtable into the compact read-only layout described in
+    mdict_frozen.h. Lookups and iteration keep working as before while any modification raises a TypeError.
+    Freezing an already frozen dictionary does nothing. Raises a ValueError if the dictionary is ordered, since the
+    frozen layout groups the items by hash slot and would lose their insertion order.
+    */
+
+    if (self->ht->is_ordered) {
+        PyErr_SetString(PyExc_ValueError, "Cannot freeze an ordered microdictionary");
+        return NULL;
+    }
+
+    if (!self->ht->is_frozen) {
+        _expire(self); // A frozen hashtable has no expiration.
+        h_t* f = mdict_freeze(self->ht);
+        if (!f) {
+            PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the frozen hashtable");
+            return NULL;
+        }
+
+        f->version = self->ht->version + 1; // Invalidates the running iterators.
+        mdict_delete_ht(self->ht);
+        self->ht = f;
+        self->temp_isvalid = false;
+    }
+
+    return Py_BuildValue("");
+}
+
+static PyObject* is_frozen(dictObj* self) {
+    /*
+    Returns True if dict.freeze() has been called on this dictionary.
+    */
+
+    return PyBool_FromLong(self->ht->is_frozen);
+}
+
+static PyObject* _stats_list(const i_t* values, i_t len) {
+    /*
+    Returns a python list holding the len integers of values.
+    */
+
+    PyObject* list = PyList_New(len);
+    if (!list)
+        return NULL;
+    for (i_t i=0; i<len; ++i) {
+        PyObject* obj = PyLong_FromLong((long) values[i]);
+        if (!obj) {
+            Py_DECREF(list);
+            return NULL;
+        }
+        PyList_SET_ITEM(list, i, obj);
+    }
+    return list;
+}
+
+static PyObject* stats(dictObj* self) {
+    /*
+    Invoked when dict.stats() is called. Returns a python dictionary describing the hashtable (see mdict_stats.h) : its
+    layout, size, bucket count and load factor, the bytes taken by each of its arrays, a histogram of the probe lengths
+    of the items, the max probe length of each group of 32 buckets, and how many resizes took place and for how long.
+    Builds compiled with MDICT_STATS also report how many lookups and inserts were made and their total probe steps.
+    */
+
+    h_t* h = self->ht;
+    size_t bytes[MDICT_NUM_ARRAYS], total_bytes = 0;
+    i_t *hist, hist_len;
+
+    if (mdict_probe_histogram(h, &hist, &hist_len) < 0)
+        return PyErr_NoMemory();
+    PyObject* probe_lengths = _stats_list(hist, hist_len);
+    MDICT_FREE(hist);
+    PyObject* group_max_psl = _stats_list(h->psl, (h->psl && !h->is_frozen) ? _flags_size(h->num_buckets) : 0);
+
+    PyObject* array_bytes = PyDict_New();
+    mdict_array_bytes(h, bytes);
+    for (int a=0; array_bytes && a<MDICT_NUM_ARRAYS; ++a) {
+        if (bytes[a] == 0)
+            continue;
+        total_bytes += bytes[a];
+        PyObject* obj = PyLong_FromSize_t(bytes[a]);
+        if (!obj || PyDict_SetItemString(array_bytes, mdict_array_names[a], obj) < 0)
+            Py_CLEAR(array_bytes);
+        Py_XDECREF(obj);
+    }
+
+    PyObject* dict = Py_BuildValue("{s:s,s:n,s:n,s:d,s:n,s:N,s:N,s:N,s:n,s:d}",
+        "layout", mdict_layout_name(h),
+        "size", (Py_ssize_t) h->size,
+        "num_buckets", (Py_ssize_t) h->num_buckets,
+        "load_factor", h->num_buckets ? (double) h->size / h->num_buckets : 0.0,
+        "bytes", (Py_ssize_t) total_bytes,
+        "array_bytes", array_bytes,
+        "probe_lengths", probe_lengths,
+        "group_max_psl", group_max_psl,
+        "num_resizes", (Py_ssize_t) h->num_resizes,
+        "rehash_seconds", h->rehash_ns * 1e-9);
+
+#ifdef MDICT_STATS
+    if (dict) {
+        PyObject* counters = Py_BuildValue("{s:K,s:K,s:K,s:K}", "num_lookups", h->num_lookups, "lookup_probes", h->lookup_probes,
+                                           "num_inserts", h->num_inserts, "insert_probes", h->insert_probes);
+        if (!counters || PyDict_Update(dict, counters) < 0)
+            Py_CLEAR(dict);
+        Py_XDECREF(counters);
+    }
+#endif
+
+    return dict;
+}
+
+static PyObject* size_of(dictObj* self) {
+    /*
+    Invoked by sys.getsizeof. Returns the size of the dictObj plus everything allocated for its hashtable, see
+    mdict_sizeof in mdict_stats.h. Iterators own no memory besides their object and are not counted.
+    */
+
+    size_t size = Py_TYPE(self)->tp_basicsize;
+    if (self->valid_ht)
+        size += mdict_sizeof(self->ht);
+    return PyLong_FromSize_t(size);
+}
+
+static PyObject* share(dictObj* self, PyObject* args) {
+    /*
+    Invoked when dict.share(name) is called. Publishes a frozen snapshot of the hashtable into the POSIX shared memory
+    segment called name (see mdict_shm.h), replacing any previous segment of that name. Other processes can then map it
+    read-only using mdict.attach. The dictionary itself is left unchanged. Raises OSError if the segment can not be written.
+    */
+
+    const char* name;
+    bool failed = false;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    h_t* f = self->ht->is_frozen ? self->ht : mdict_freeze(self->ht);
+    if (!f) {
+        PyErr_SetString(PyExc_MemoryError, "Insufficient memory : Failed to allocate the frozen hashtable");
+        return NULL;
+    }
+
+    if (mdict_shm_publish(f, name) < 0) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+        failed = true;
+    }
+
+    if (f != self->ht)
+        mdict_delete_ht(f);
+
+    if (failed)
+        return NULL;
+
+    return Py_BuildValue("");
+}
+
+static PyObject* map(dictObj* self, PyObject* args) { 
+    /*
+    Experimental status.
+    */
+
+    PyObject* list = NULL;
+    PyObject* func = NULL;
+    PyObject* output_list;
+
+    if (!PyArg_ParseTuple(args, "O|O", &list, &func))
+        return NULL;
+
+    if (!PyList_CheckExact(list)) {
+        return NULL;
+    }
+
+    Py_ssize_t size = PyList_Size(list);
+    output_list = PyList_New(size);
+    kbox_t key;
+
+    for (int i=0; i<size; ++i){
+        if (_parse_key(self, PyList_GET_ITEM(list, i), &key) != 0) {
+            PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+            continue;
+        }
+        int ret_idx;
+        vbox_t val = mdict_get_map(self->ht, key, &ret_idx);
+        if (ret_idx != self->ht->num_buckets) {
+            if (func == NULL)
+                PyList_SET_ITEM(output_list, i, _val_to_py(val));
+            else {
+                PyObject* result = PyObject_CallFunction(func, "N", _val_to_py(val));
+                if (result != NULL)
+                    PyList_SET_ITEM(output_list, i, result);                                        
+                else
+                    PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+            }
+        }
+        else
+            PyList_SET_ITEM(output_list, i, Py_BuildValue(""));
+    }
+
+    PyErr_Clear();
+    return output_list;
+}
+
+static PyObject* item_len(dictObj* self) {
+    /*
+    Returns max length of key and value that the dictionary supports.
+    */
+
+    return PyTuple_Pack(2, PyLong_FromLong(self->ht->key_str_len), PyLong_FromLong(self->ht->val_str_len));
+}
+
+
+static PyMethodDef MDICT_SYM(methods)[] = {
+    {"pop", del, METH_O, "deletes a key-value pair and pops its value"},
+    {"get", (PyCFunction) get, METH_FASTCALL, "Returns the value of a key, or default (None if not given) if the key is absent"},
+    {"clear", (PyCFunction) clear, METH_FASTCALL, "clears the hashtable"},
+    {"get_keys", get_keys, METH_NOARGS, "returns a list of all keys"},
+    {"get_values", get_values, METH_NOARGS, "returns a list of all values"},
+    {"get_items", get_items, METH_NOARGS, "returns a list of all key-value pairs"},
+    {"to_Pydict", to_Pydict, METH_NOARGS, "returns a python dictionary created from the microdict"},
+    {"update", update, METH_O, "Updates the microdict with all key-value pairs within the given input: Either a Python dictionary or another microdict"},
+    {"values", get_value_iterator, METH_NOARGS, "Returns an iterator for iterating over values"},
+    {"items", get_item_iterator, METH_NOARGS, "Returns an iterator for iterating over items"},
+    {"copy", copy, METH_NOARGS, "Returns a deep copy of the hashtable"},
+    {"freeze", freeze, METH_NOARGS, "Converts the microdict into a compact read-only hashtable"},
+    {"set", (PyCFunction) set, METH_FASTCALL | METH_KEYWORDS, "Inserts a key-value pair, optionally expiring after ttl seconds"},
+    {"expire", expire, METH_NOARGS, "Removes all the expired items and returns how many were removed"},
+    {"is_frozen", is_frozen, METH_NOARGS, "Returns True if the microdict is frozen"},
+    {"stats", stats, METH_NOARGS, "Returns a dictionary of statistics about the hashtable layout, memory and probe lengths"},
+    {"__sizeof__", size_of, METH_NOARGS, "Returns the size of the microdict in bytes, hashtable arrays included"},
+    {"share", share, METH_VARARGS, "Publishes a read-only snapshot of the microdict into a named shared memory segment"},
+    {"item_len", item_len, METH_NOARGS, "Returns the tuple (KEY_MAX_LENGTH, VALUE_MAX_LENGTH"},
+    // {"map", map, METH_VARARGS, "Updates the microdict with all key-value pairs within the given input: Either a Python dictionary or another microdict"},
+    {NULL, NULL, 0, NULL}
+};
+
+
+static PySequenceMethods MDICT_SYM(sequence) = {
+    _len_,                            /* sq_length */
+    0,                                  /* sq_concat */
+    0,                                  /* sq_repeat */
+    0,                                  /* sq_item */
+    0,                                  /* sq_slice */
+    0,                                  /* sq_ass_item */
+    0,                                  /* sq_ass_slice */
+    (objobjproc) _contains_,           /* sq_contains */
+};
+
+static PyMappingMethods MDICT_SYM(mapping) = {
+    0, /*mp_length*/
+    (binaryfunc)mapping_get, /*mp_subscript*/
+    (objobjargproc)mapping_set, /*mp_ass_subscript*/
+};
+
+
+static PyTypeObject MDICT_SYM(dictType) = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = KEY_NAME "->" VAL_NAME,
+    .tp_doc = KEY_NAME "->" VAL_NAME " microdictionary",
+    .tp_basicsize = sizeof(dictObj),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .tp_new = custom_new,
+    .tp_init = (initproc) custom_init,
+    .tp_dealloc = (destructor) custom_dealloc,
+    .tp_methods = MDICT_SYM(methods),
+    .tp_as_sequence = &MDICT_SYM(sequence),
+    .tp_as_mapping = &MDICT_SYM(mapping),
+    .tp_iter = (getiterfunc) mdict_iter,
+};
+
+
+
+static PyObject* update(dictObj* self, PyObject* dict) {
+    /*
+    Invoked when dict.update() is called. It takes an argument which must be either a Python dictionary or a microdictionary
+    of the same type. It adds all the items from the argument dictionary given to its hashtable. See _update_from_Pydict and
+    _update_from_mdict for further documentation.
+    */
+
+    bool is_pydict;
+
+    if (_check_frozen(self) == -1)
+        return NULL;
+
+    if (!PyDict_Check(dict)) {
+        is_pydict = false;
+        if (PyObject_IsInstance(dict, (PyObject *) &MDICT_SYM(dictType)) != 1) {
+            PyErr_SetString(PyExc_TypeError, "Argument needs to be either a " KEY_NAME "->" VAL_NAME " microdictionary or a (" KEY_DESC " key, " VAL_DESC " value) Python dictionary");
+            return NULL;
+        }
+ 
+    } else
+        is_pydict = true;
+
+    if (is_pydict) {
+        if (_update_from_Pydict(self, dict) == -1)
+            return NULL;
+    } else {
+        dictObj* _dict_ = (dictObj*) dict;
+        if ((_dict_->ht->key_str_len <= self->ht->key_str_len) && (_dict_->ht->val_str_len <= self->ht->val_str_len)) {
+            if (_update_from_mdict(self, _dict_) == -1)
+                return NULL;
+        } else {
+            char msg[210];
+            sprintf(msg, "Incompatible microdictionary argument : Trying to update a microdictionary of key length = %d, value length = %d with another microdictionary of key length = %d, value length = %d", self->ht->key_str_len, self->ht->val_str_len, _dict_->ht->key_str_len, _dict_->ht->val_str_len);
+            PyErr_SetString(PyExc_TypeError, msg);
+            return NULL;
+        }
+    }
+
+    PyErr_Clear();
+    return Py_BuildValue("");
+}
+
+
+static PyObject* attach(PyObject* module, PyObject* args) {
+    /*
+    Called by mdict.attach. Returns a new frozen microdictionary backed by the POSIX shared memory segment called name,
+    which must have been published by dict.share from a dictionary of the same type. The segment is mapped read-only
+    and unmapped when the returned dictionary is deleted.
+    */
+
+    const char* name;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    h_t* h = mdict_shm_attach(name);
+    if (!h) {
+        if (errno == EPROTOTYPE)
+            PyErr_SetString(PyExc_TypeError, "The shared memory segment holds a microdictionary of a different type");
+        else if (errno == EINVAL)
+            PyErr_SetString(PyExc_ValueError, "The shared memory segment does not hold a published microdictionary");
+        else
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+        return NULL;
+    }
+
+    PyObject* create_args = _create_args(h);
+    dictObj* obj = (dictObj *) PyObject_CallObject((PyObject *) &MDICT_SYM(dictType), create_args);
+    Py_XDECREF(create_args);
+    if (!obj) {
+        mdict_delete_ht(h);
+        return NULL;
+    }
+
+    _destroy(obj);
+    obj->ht = h;
+    obj->valid_ht = true;
+    return (PyObject*) obj;
+}
+
+static PyObject* unlink_segment(PyObject* module, PyObject* args) {
+    /*
+    Called by mdict.unlink. Removes the name of a shared memory segment published by dict.share. Dictionaries already
+    attached to it keep working until they are deleted.
+    */
+
+    const char* name;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    if (mdict_shm_unlink(name) < 0)
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+
+    return Py_BuildValue("");
+}
+
+
+#if dtype_key == 5 && dtype_val == 5
+/*
+    C API exported through the _C_API capsule, see microdict_api.h. The functions do the work of d[k], d[k] = v, d.pop(k)
+    and iteration on UTF-8 encoded keys and values, and expect the GIL to be held.
+*/
+
+static PyObject* api_create(Py_ssize_t key_len, Py_ssize_t val_len) {
+    return PyObject_CallFunction((PyObject *) &MDICT_SYM(dictType), "nn", key_len, val_len);
+}
+
+static int api_get(PyObject* d, const char* key, Py_ssize_t key_len, const char** val, Py_ssize_t* val_len) {
+    h_t* h = ((dictObj*) d)->ht;
+    i_t idx;
+
+    if (key_len > h->key_str_len)
+        return 0;
+
+    vbox_t v = mdict_get_map(h, (kbox_t) {(char*) key, (int) key_len}, &idx);
+    if (idx == h->num_buckets)
+        return 0;
+    *val = v.str;
+    *val_len = v.len;
+    return 1;
+}
+
+static int api_set(PyObject* d, const char* key, Py_ssize_t key_len, const char* val, Py_ssize_t val_len) {
+    dictObj* self = (dictObj*) d;
+
+    if (_check_frozen(self) == -1)
+        return -1;
+
+    if (key_len > self->ht->key_str_len) {
+        PyErr_Format(PyExc_TypeError, "Key needs to be a string of size at most %d", self->ht->key_str_len);
+        return -1;
+    }
+    if (val_len > self->ht->val_str_len) {
+        PyErr_Format(PyExc_TypeError, "Value needs to be a string of size at most %d", self->ht->val_str_len);
+        return -1;
+    }
+
+    return _set_item(self, (kbox_t) {(char*) key, (int) key_len}, (vbox_t) {(char*) val, (int) val_len});
+}
+
+static int api_del(PyObject* d, const char* key, Py_ssize_t key_len) {
+    dictObj* self = (dictObj*) d;
+
+    if (_check_frozen(self) == -1)
+        return -1;
+    if (key_len > self->ht->key_str_len)
+        return 0;
+
+    kbox_t k = {(char*) key, (int) key_len};
+    if (self->temp_isvalid && (k.len == self->temp_key.len) && _strncmp(k.str, self->temp_key.str, k.len))
+        self->temp_isvalid = false;
+
+    return mdict_del_map(self->ht, k, NULL) == -2 ? 0 : 1;
+}
+
+static Py_ssize_t api_get_many(PyObject* d, const char* const* keys, const Py_ssize_t* key_lens, const char** vals, Py_ssize_t* val_lens, Py_ssize_t n) {
+    h_t* h = ((dictObj*) d)->ht;
+    Py_ssize_t num_found = 0;
+
+    for (Py_ssize_t j = 0; j < n; ++j) {
+        i_t idx = h->num_buckets;
+        vbox_t v;
+        if (key_lens[j] <= h->key_str_len)
+            v = mdict_get_map(h, (kbox_t) {(char*) keys[j], (int) key_lens[j]}, &idx);
+
+        if (idx != h->num_buckets) {
+            vals[j] = v.str;
+            val_lens[j] = v.len;
+            num_found += 1;
+        } else {
+            vals[j] = NULL;
+            val_lens[j] = 0;
+        }
+    }
+    return num_found;
+}
+
+static int api_next(PyObject* d, Py_ssize_t* pos, const char** key, Py_ssize_t* key_len, const char** val, Py_ssize_t* val_len) {
+    dictObj* self = (dictObj*) d;
+
+    if (*pos == 0)
+        _expire(self);
+
+    h_t* h = self->ht;
+    i_t i = _flags_next_occupied(h->flags, (i_t) *pos, h->num_buckets);
+    if (i >= h->num_buckets)
+        return 0;
+
+    kbox_t k = _get_key(h, GET_PTR(i, h->k_step_increment));
+    vbox_t v = _get_val(h, GET_PTR(i, h->v_step_increment));
+    *key = k.str;
+    *key_len = k.len;
+    *val = v.str;
+    *val_len = v.len;
+    *pos = i + 1;
+    return 1;
+}
+
+static Py_ssize_t api_size(PyObject* d) {
+    return ((dictObj*) d)->ht->size;
+}
+
+static MDICT_SYM(MicrodictAPI) MDICT_SYM(api) = {MICRODICT_API_VERSION, &MDICT_SYM(dictType), api_create, api_get, api_set, api_del, api_get_many, api_next, api_size};
+#endif
+
+
+static PyMethodDef MDICT_SYM(module_methods)[] = {
+    {"attach", attach, METH_VARARGS, "Attaches a microdict published into a shared memory segment"},
+    {"unlink", unlink_segment, METH_VARARGS, "Removes a shared memory segment published by share"},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef MDICT_SYM(moduleDef) =
+{
+    PyModuleDef_HEAD_INIT,
+    MDICT_NAME " microdictionary", /* name of module */
+    NULL, // Documentation of the module
+    -1,   /* size of per-interpreter state of the module, or -1 if the module keeps state in global variables. */
+    MDICT_SYM(module_methods), /* module level functions */
+};
+
+PyMODINIT_FUNC MDICT_SYM(PyInit)(void)
+{
+    PyObject *obj;
+
+    if (PyType_Ready(&MDICT_SYM(dictType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(keyIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(valueIterType)) < 0)
+        return NULL;
+
+    if (PyType_Ready(&MDICT_SYM(itemIterType)) < 0)
+        return NULL;
+
+    obj = PyModule_Create(&MDICT_SYM(moduleDef));
+    if (obj == NULL)
+        return NULL;
+
+    Py_INCREF(&MDICT_SYM(dictType));
+    if (PyModule_AddObject(obj, "create", (PyObject *) &MDICT_SYM(dictType)) < 0) {
+        Py_DECREF(&MDICT_SYM(dictType));
+        Py_DECREF(obj);
+        return NULL;
+    }
+
+#if dtype_key == 5 && dtype_val == 5
+    PyObject* capsule = PyCapsule_New((void*) &MDICT_SYM(api), "_mdict_c." MDICT_NAME "._C_API", NULL);
+    if (PyModule_AddObject(obj, "_C_API", capsule) < 0) {
+        Py_XDECREF(capsule);
+        Py_DECREF(obj);
+        return NULL;
+    }
+#endif
+
+    return obj;
+}
\ No newline at end of file
@@ -1,9 +1,11 @@
 #include "wyhash.h"
 #include "_string.h"
 
+#if dtype_key == 5
 inline uint64_t _hash_func(h_t *h, kbox_t key_box) {
 	return wyhash(key_box.str, key_box.len, h->seed, _wyp);
 }
+#endif
 
 
 #include "mdict_ht.h"
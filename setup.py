@@ -1,4 +1,6 @@
 from setuptools import setup, Extension, find_packages
+from setuptools.command.build_ext import build_ext
+import copy
 import os
 import sys
 
@@ -8,24 +10,43 @@ parent_dir = 'microdict'
 def read(filename):
     return open(os.path.join(os.path.dirname(__file__), filename)).read()
 
+define_macros = [('MDICT_STATS', None)] if os.environ.get('MDICT_STATS') else [] # Lookup and insert counters, see mdict_stats.h
+
+# Every module is one (key type, value type) pair compiled from a shared binding template : int_int_Py.c for the
+# integer pairs and str_Py.c for the pairs with a string side, with dtype_key and dtype_val set to the dtype codes of
+# microdict/hash_funcs.h.
+int_dtypes = {'i16': 8, 'u16': 9, 'i32': 1, 'u32': 6, 'i64': 2, 'u64': 7}
+type_pairs = [(k, v, 'int_int_Py.c') for k in int_dtypes for v in int_dtypes]
+type_pairs += [('str', 'str', 'str_Py.c'), ('str', 'i64', 'str_Py.c'), ('i64', 'str', 'str_Py.c')]
+dtype_codes = dict(int_dtypes, str=5)
+
 if os.name != 'nt':
     if sys.platform == 'darwin' and 'APPVEYOR' in os.environ:
         os.environ['CC'] = 'gcc-8'
 
-    module_i32_i32 = Extension('i32_i32', sources = [os.path.join(parent_dir, 'int32_int32_Py.c')], extra_compile_args = ["-O3", "-w"])
-    module_i32_i64 = Extension('i32_i64', sources = [os.path.join(parent_dir, 'int32_int64_Py.c')], extra_compile_args = ["-O3", "-w"])
-    module_i64_i32 = Extension('i64_i32', sources = [os.path.join(parent_dir, 'int64_int32_Py.c')], extra_compile_args = ["-O3", "-w"])
-    module_i64_i64 = Extension('i64_i64', sources = [os.path.join(parent_dir, 'int64_int64_Py.c')], extra_compile_args = ["-O3", "-w"])
-    module_str_str = Extension('str_str', sources = [os.path.join(parent_dir, 'str_str_wyhash_Py.c')], extra_compile_args = ["-O3", "-w"])
+    libraries = ['rt'] if sys.platform.startswith('linux') else [] # shm_open lives in librt on older glibc versions
+    extra_compile_args = ["-O3", "-w"]
 
     os.system('gcc -v')
 else:
     # If windows:
-    module_i32_i32 = Extension('i32_i32', sources = [os.path.join(parent_dir, 'int32_int32_Py.c')], extra_compile_args = ["/O2", "/w"])
-    module_i32_i64 = Extension('i32_i64', sources = [os.path.join(parent_dir, 'int32_int64_Py.c')], extra_compile_args = ["/O2", "/w"])
-    module_i64_i32 = Extension('i64_i32', sources = [os.path.join(parent_dir, 'int64_int32_Py.c')], extra_compile_args = ["/O2", "/w"])
-    module_i64_i64 = Extension('i64_i64', sources = [os.path.join(parent_dir, 'int64_int64_Py.c')], extra_compile_args = ["/O2", "/w"])
-    module_str_str = Extension('str_str', sources = [os.path.join(parent_dir, 'str_str_wyhash_Py.c')], extra_compile_args = ["/O2", "/w"])
+    libraries = []
+    extra_compile_args = ["/O2", "/w"]
+
+modules = [Extension(k + '_' + v, sources = [os.path.join(parent_dir, source)], extra_compile_args = extra_compile_args, libraries = libraries,
+                     define_macros = define_macros + [('dtype_key', str(dtype_codes[k])), ('dtype_val', str(dtype_codes[v]))])
+           for k, v, source in type_pairs]
+
+
+class build_ext_per_type(build_ext):
+    """
+    The modules share their source files, so each one gets its own temporary directory for the object files.
+    """
+
+    def build_extension(self, ext):
+        cmd = copy.copy(self) # Leaves self alone for the other modules, which build_ext --parallel builds concurrently.
+        cmd.build_temp = os.path.join(self.build_temp, ext.name)
+        build_ext.build_extension(cmd, ext)
 
 
 setup (name = 'microdict',
@@ -39,8 +60,11 @@ setup (name = 'microdict',
         url = 'https://github.com/touqir14/Microdict',
         ext_package = '_mdict_c',
         py_modules = [os.path.join(parent_dir, 'mdict'), os.path.join(parent_dir, 'run_tests'), os.path.join(parent_dir, 'microdict_tests')],
-        ext_modules = [module_i32_i32, module_i32_i64, module_i64_i32, module_i64_i64, module_str_str],
+        ext_modules = modules,
+        cmdclass = {'build_ext': build_ext_per_type},
         packages = find_packages(),
+        package_data = {'microdict': ['microdict_api.h', 'microdict_api.pxd', 'flat_map.hpp', 'wyhash.h', 'int32_int32_lockfree.h', 'mdict_atomic.h']}, # The C API, the C++ flat_map and the lock-free table, see microdict.get_include()
+        python_requires = '>=3.7', # METH_FASTCALL
         classifiers = ['Development Status :: 4 - Beta',
           'Intended Audience :: Developers',
           'License :: OSI Approved :: MIT License',
@@ -49,8 +73,6 @@ setup (name = 'microdict',
           'Operating System :: POSIX :: Linux',
           'Programming Language :: Python',
           'Programming Language :: Python :: 3',
-          'Programming Language :: Python :: 3.5',
-          'Programming Language :: Python :: 3.6',
           'Programming Language :: Python :: 3.7',
           'Programming Language :: Python :: 3.8',
           'Programming Language :: Python :: 3.9',